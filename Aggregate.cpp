@@ -0,0 +1,160 @@
+#include "Aggregate.h"
+
+#include <charconv>
+#include <cmath>
+
+#include "Predicate.h"
+
+namespace {
+
+std::string formatNumber(double value) {
+    char buffer[32];
+    return std::string(buffer, std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+}
+
+} // namespace
+
+//Neumaier summation keeps the rounding error of each addition, so the total does not depend on
+//how rows were split between threads
+void AggregateState::addToSum(double value) {
+    double total = sum + value;
+    if (std::fabs(sum) >= std::fabs(value)) compensation += (sum - total) + value;
+    else compensation += (value - total) + sum;
+    sum = total;
+}
+
+bool aggregateFunction(const std::string& name, AggregateFunction& function) {
+    if (name == "COUNT") function = AggregateFunction::Count;
+    else if (name == "SUM") function = AggregateFunction::Sum;
+    else if (name == "AVG") function = AggregateFunction::Avg;
+    else if (name == "MIN") function = AggregateFunction::Min;
+    else if (name == "MAX") function = AggregateFunction::Max;
+    else return false;
+    return true;
+}
+
+//typed cells are stored in canonical form and parse exactly; untyped cells follow the WHERE rules
+bool AggregateState::numberOf(const AggregateSpec& spec, std::string_view cell, double& number,
+                              std::int64_t& integer) const {
+    const char* end = cell.data() + cell.size();
+    switch (spec.type) {
+        case ValueType::Int: {
+            auto parsed = std::from_chars(cell.data(), end, integer);
+            number = static_cast<double>(integer);
+            return parsed.ec == std::errc() && parsed.ptr == end;
+        }
+        case ValueType::Double: {
+            auto parsed = std::from_chars(cell.data(), end, number);
+            return parsed.ec == std::errc() && parsed.ptr == end;
+        }
+        case ValueType::Text:
+            return false;
+        default:
+            return parseLikeStod(cell, number) && !std::isnan(number);
+    }
+}
+
+void AggregateState::offerBest(const AggregateSpec& spec, std::string_view cell, bool isNumber, double number) {
+    bool better;
+    if (!hasBest) {
+        better = true;
+    } else if (isNumber != bestIsNumber) {
+        better = (spec.function == AggregateFunction::Min) == isNumber; //numbers sort first
+    } else if (isNumber && spec.type != ValueType::Int && number != bestNumber) {
+        better = spec.function == AggregateFunction::Min ? number < bestNumber : number > bestNumber;
+    } else if (isNumber && spec.type == ValueType::Int) {
+        //compare integers exactly rather than through doubles
+        std::int64_t value = 0, current = 0;
+        std::from_chars(cell.data(), cell.data() + cell.size(), value);
+        std::from_chars(best.data(), best.data() + best.size(), current);
+        better = spec.function == AggregateFunction::Min ? value < current : value > current;
+    } else {
+        //text, or equal numbers written differently ("5" and "5.0")
+        better = spec.function == AggregateFunction::Min ? cell < best : cell > best;
+    }
+    if (!better) return;
+    hasBest = true;
+    bestIsNumber = isNumber;
+    bestNumber = number;
+    best.assign(cell);
+}
+
+void AggregateState::add(const AggregateSpec& spec, std::string_view cell) {
+    if (cell.empty()) return;
+    ++count;
+    if (spec.function == AggregateFunction::Count) return;
+
+    double number = 0;
+    std::int64_t integer = 0;
+    bool isNumber = numberOf(spec, cell, number, integer);
+    if (spec.function == AggregateFunction::Min || spec.function == AggregateFunction::Max) {
+        offerBest(spec, cell, isNumber, number);
+        return;
+    }
+    if (!isNumber) return;
+    ++numbers;
+    addToSum(number);
+    if (spec.type == ValueType::Int && !intOverflow) intOverflow = __builtin_add_overflow(intSum, integer, &intSum);
+}
+
+void AggregateState::merge(const AggregateSpec& spec, const AggregateState& other) {
+    count += other.count;
+    numbers += other.numbers;
+    addToSum(other.sum);
+    compensation += other.compensation;
+    if (spec.type == ValueType::Int) {
+        intOverflow = intOverflow || other.intOverflow || __builtin_add_overflow(intSum, other.intSum, &intSum);
+    }
+    if (other.hasBest) offerBest(spec, other.best, other.bestIsNumber, other.bestNumber);
+}
+
+std::string AggregateState::result(const AggregateSpec& spec) const {
+    switch (spec.function) {
+        case AggregateFunction::Count:
+            return std::to_string(count);
+        case AggregateFunction::Sum:
+            if (numbers == 0) return "";
+            if (spec.type == ValueType::Int && !intOverflow) return std::to_string(intSum);
+            return formatNumber(sum + compensation);
+        case AggregateFunction::Avg:
+            return numbers == 0 ? "" : formatNumber((sum + compensation) / numbers);
+        default:
+            return best;
+    }
+}
+
+GroupTable::GroupTable(std::vector<int> groupColumns, std::vector<AggregateSpec> aggregates)
+    : groupColumns(std::move(groupColumns)), aggregates(std::move(aggregates)) {}
+
+GroupTable::Group& GroupTable::groupFor(std::uint64_t order) {
+    auto it = groups.find(key);
+    if (it == groups.end()) {
+        it = groups.emplace(key, Group()).first;
+        it->second.first = order;
+        it->second.states.resize(aggregates.size());
+    }
+    return it->second;
+}
+
+void GroupTable::merge(GroupTable& other) {
+    for (auto& [otherKey, otherGroup] : other.groups) {
+        auto it = groups.find(otherKey);
+        if (it == groups.end()) {
+            groups.emplace(otherKey, std::move(otherGroup));
+            continue;
+        }
+        Group& group = it->second;
+        group.first = std::min(group.first, otherGroup.first);
+        for (size_t i = 0; i < aggregates.size(); ++i) group.states[i].merge(aggregates[i], otherGroup.states[i]);
+    }
+    other.groups.clear();
+}
+
+void GroupTable::splitKey(std::string_view key, std::vector<std::string_view>& keys) {
+    keys.clear();
+    while (!key.empty()) {
+        size_t end = key.find('\0');
+        keys.push_back(key.substr(0, end));
+        key.remove_prefix(end + 1);
+    }
+}
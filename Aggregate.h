@@ -0,0 +1,114 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Schema.h"
+
+enum class AggregateFunction { Count, Sum, Avg, Min, Max };
+
+//false if name (uppercase) is not an aggregate function
+bool aggregateFunction(const std::string& name, AggregateFunction& function);
+
+//one aggregate of a query, bound to a column position of the rows it reads
+struct AggregateSpec {
+    AggregateFunction function = AggregateFunction::Count;
+    int column = -1;                 //-1 for COUNT(*)
+    ValueType type = ValueType::Any; //declared type of the column
+};
+
+//running value of one aggregate within one group. empty cells and cells past the end of a row
+//are skipped, so COUNT(col) counts the rows that have a value. SUM and AVG read numbers only;
+//MIN and MAX order numbers numerically ahead of other values, which compare bytewise (the order
+//index keys use), except on TEXT columns where every value compares bytewise.
+class AggregateState {
+public:
+    void add(const AggregateSpec& spec, std::string_view cell);
+    void addRow() { ++count; } //COUNT(*)
+    void merge(const AggregateSpec& spec, const AggregateState& other);
+
+    //the aggregate's value as printed; empty when no value contributed (except COUNT)
+    std::string result(const AggregateSpec& spec) const;
+
+private:
+    bool numberOf(const AggregateSpec& spec, std::string_view cell, double& number, std::int64_t& integer) const;
+    void offerBest(const AggregateSpec& spec, std::string_view cell, bool isNumber, double number);
+    void addToSum(double value);
+
+    std::uint64_t count = 0;   //contributing cells (rows for COUNT(*))
+    std::uint64_t numbers = 0; //cells that were numbers
+    double sum = 0;
+    double compensation = 0;   //rounding error lost from sum
+    std::int64_t intSum = 0;   //exact sum for INT columns while it fits
+    bool intOverflow = false;
+
+    bool hasBest = false;
+    bool bestIsNumber = false;
+    double bestNumber = 0;
+    std::string best;          //MIN or MAX as written in the table
+};
+
+//hash aggregation of rows into groups keyed by their GROUP BY cells. each scan thread fills
+//its own table and the partial tables are merged at the end, so no lock is taken per row.
+class GroupTable {
+public:
+    struct Group {
+        std::uint64_t first = 0; //order of the group's first row, for output in scan order
+        std::vector<AggregateState> states;
+    };
+
+    GroupTable(std::vector<int> groupColumns, std::vector<AggregateSpec> aggregates);
+
+    //adds one row; order is its position in the scan (smaller is earlier)
+    template <typename Values>
+    void add(const Values& values, std::uint64_t order) {
+        key.clear();
+        for (int col : groupColumns) {
+            if (col < static_cast<int>(values.size())) key.append(values[col]);
+            key.push_back('\0');
+        }
+        Group& group = groupFor(order);
+        for (size_t i = 0; i < aggregates.size(); ++i) {
+            const AggregateSpec& spec = aggregates[i];
+            if (spec.column < 0) group.states[i].addRow();
+            else if (spec.column < static_cast<int>(values.size())) group.states[i].add(spec, values[spec.column]);
+        }
+    }
+
+    //folds another table's groups into this one
+    void merge(GroupTable& other);
+
+    //calls visit(keys, states) for every group in order of first appearance. a query without
+    //GROUP BY has exactly one group, even over no rows.
+    template <typename Visitor>
+    void forEachGroup(Visitor visit) {
+        if (groups.empty() && groupColumns.empty()) groupFor(0);
+        std::vector<const std::pair<const std::string, Group>*> ordered;
+        for (const auto& entry : groups) ordered.push_back(&entry);
+        std::sort(ordered.begin(), ordered.end(),
+                  [](const auto* a, const auto* b) { return a->second.first < b->second.first; });
+        std::vector<std::string_view> keys;
+        for (const auto* entry : ordered) {
+            splitKey(entry->first, keys);
+            visit(keys, entry->second.states);
+        }
+    }
+
+    const std::vector<AggregateSpec>& specs() const { return aggregates; }
+
+private:
+    Group& groupFor(std::uint64_t order);
+    static void splitKey(std::string_view key, std::vector<std::string_view>& keys);
+
+    std::vector<int> groupColumns;
+    std::vector<AggregateSpec> aggregates;
+    std::unordered_map<std::string, Group> groups;
+    std::string key; //scratch for the key of the row being added
+};
+
+#endif
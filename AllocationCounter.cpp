@@ -0,0 +1,27 @@
+#include <cstdlib>
+#include <new>
+
+#include "QueryProfile.h"
+
+//sql_database replaces the global allocation functions so EXPLAIN ANALYZE can count each thread's
+//allocations; the library never does this itself, so embedding programs keep their own allocator.
+//outside an analyzed query each call costs one relaxed load on top of malloc
+void* operator new(std::size_t size) {
+    noteAllocation();
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    noteAllocation();
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
@@ -0,0 +1,190 @@
+#include "AppendLock.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <filesystem>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "DeletionMap.h"
+
+namespace fs = std::filesystem;
+
+//the contents of a lock file, shared by every process that maps it
+struct LockState {
+    std::atomic<std::uint64_t> committed; //0 until a writer publishes a length
+    std::atomic<std::uint64_t> writing;   //1 while a writer may have bytes past committed
+    std::atomic<std::uint64_t> deleted;   //tombstones in effect
+    std::atomic<std::uint64_t> generation;
+    std::atomic<std::uint64_t> sequence;  //odd while committed, deleted and generation are stored
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "committed lengths are read without locks");
+
+namespace {
+
+std::string lockPath(const std::string& tableName) {
+    return "database/" + tableName + ".lock";
+}
+
+std::string tablePath(const std::string& tableName) {
+    return "database/" + tableName + ".txt";
+}
+
+bool fileSize(const std::string& path, std::uint64_t& size) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) return false;
+    size = st.st_size;
+    return true;
+}
+
+//times a reader retries a snapshot that a publish is storing before it takes what it read; only a
+//writer that died in the middle of a publish keeps the sequence odd for longer
+const int kSnapshotRetries = 1000;
+
+int lockFile(int fd, int operation) {
+    int result;
+    do {
+        result = ::flock(fd, operation);
+    } while (result != 0 && errno == EINTR);
+    return result;
+}
+
+} // namespace
+
+bool AppendLock::openFile(const std::string& tableName) {
+    unlock();
+    std::string path = lockPath(tableName);
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size == 0) {
+        std::error_code ec;
+        fs::permissions(path, fs::perms::owner_all | fs::perms::group_all | fs::perms::others_all,
+                        fs::perm_options::replace, ec);
+    }
+    return true;
+}
+
+bool AppendLock::lock(const std::string& tableName) {
+    if (!openFile(tableName) || lockFile(fd, LOCK_EX) != 0) {
+        unlock();
+        return false;
+    }
+
+    //a new lock file is sized under the lock, so readers never map a short one
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || (st.st_size < static_cast<off_t>(sizeof(LockState)) &&
+                                  ::ftruncate(fd, sizeof(LockState)) != 0)) {
+        unlock();
+        return false;
+    }
+    void* mapped = ::mmap(nullptr, sizeof(LockState), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        unlock();
+        return false;
+    }
+    state = static_cast<LockState*>(mapped);
+
+    std::uint64_t sequence = state->sequence.load(std::memory_order_relaxed);
+    if (sequence % 2 != 0) state->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::uint64_t size;
+    if (!fileSize(tablePath(tableName), size)) return true;
+    std::uint64_t committed = state->committed.load(std::memory_order_acquire);
+    bool failed = state->writing.load(std::memory_order_acquire);
+    if (failed && size > committed && committed > 0) {
+        if (::truncate(tablePath(tableName).c_str(), committed) == 0) size = committed;
+    }
+    std::uint64_t deleted = trimTombstones(tableName, failed ? state->deleted.load(std::memory_order_relaxed) : UINT64_MAX);
+    store(size, deleted, state->generation.load(std::memory_order_relaxed));
+    return true;
+}
+
+bool AppendLock::tryLockShared(const std::string& tableName) {
+    if (openFile(tableName) && lockFile(fd, LOCK_SH | LOCK_NB) == 0) return true;
+    unlock();
+    return false;
+}
+
+void AppendLock::unlock() {
+    if (state) ::munmap(state, sizeof(LockState));
+    if (fd >= 0) ::close(fd);
+    state = nullptr;
+    fd = -1;
+}
+
+void AppendLock::beginWrite() {
+    if (state) state->writing.store(1, std::memory_order_release);
+}
+
+void AppendLock::publish(std::uint64_t length) {
+    if (state) publish(length, state->deleted.load(std::memory_order_relaxed));
+}
+
+void AppendLock::publish(std::uint64_t length, std::uint64_t deleted) {
+    if (state) store(length, deleted, state->generation.load(std::memory_order_relaxed));
+}
+
+void AppendLock::publishRewrite(std::uint64_t length) {
+    if (state) store(length, 0, state->generation.load(std::memory_order_relaxed) + 1);
+}
+
+std::uint64_t AppendLock::deletedRows() const {
+    return state ? state->deleted.load(std::memory_order_relaxed) : 0;
+}
+
+//a sequence lock: readers retry while the sequence is odd or changes under them
+void AppendLock::store(std::uint64_t length, std::uint64_t deleted, std::uint64_t generation) {
+    std::uint64_t sequence = state->sequence.load(std::memory_order_relaxed);
+    state->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    state->committed.store(length, std::memory_order_relaxed);
+    state->deleted.store(deleted, std::memory_order_relaxed);
+    state->generation.store(generation, std::memory_order_relaxed);
+    state->sequence.store(sequence + 2, std::memory_order_release);
+    state->writing.store(0, std::memory_order_release);
+}
+
+TableSnapshot readSnapshot(const std::string& tableName) {
+    //the length is loaded before the file is measured: the file only grows past a published length,
+    //so the other order could take in part of a write that was published in between
+    TableSnapshot snapshot;
+    std::uint64_t committed = 0;
+    int fd = ::open(lockPath(tableName).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(LockState))) {
+            void* mapped = ::mmap(nullptr, sizeof(LockState), PROT_READ, MAP_SHARED, fd, 0);
+            if (mapped != MAP_FAILED) {
+                const LockState* state = static_cast<const LockState*>(mapped);
+                for (int retry = 0;; ++retry) {
+                    std::uint64_t sequence = state->sequence.load(std::memory_order_acquire);
+                    committed = state->committed.load(std::memory_order_relaxed);
+                    snapshot.deleted = state->deleted.load(std::memory_order_relaxed);
+                    snapshot.generation = state->generation.load(std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    bool stable = sequence % 2 == 0 && state->sequence.load(std::memory_order_relaxed) == sequence;
+                    if (stable || retry == kSnapshotRetries) break;
+                    std::this_thread::yield();
+                }
+                ::munmap(mapped, sizeof(LockState));
+            }
+        }
+        ::close(fd);
+    }
+
+    std::uint64_t size;
+    if (!fileSize(tablePath(tableName), size)) return snapshot;
+    snapshot.length = committed == 0 ? size : std::min(committed, size);
+    return snapshot;
+}
+
+std::uint64_t readableLength(const std::string& tableName) {
+    return readSnapshot(tableName).length;
+}
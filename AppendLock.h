@@ -0,0 +1,73 @@
+#ifndef APPEND_LOCK_H
+#define APPEND_LOCK_H
+
+#include <cstdint>
+#include <string>
+
+struct LockState;
+
+//coordinates the processes that share a database directory. every text table has a lock file,
+//database/<table>.lock, holding its committed length: the bytes of the table file that hold whole
+//rows of finished writes. a writer appends under an exclusive flock on the lock file and publishes
+//the new length once its rows are written; readers load the length without locking (it is an
+//atomic in the file's shared mapping) and read the table up to it, so they never wait for a writer
+//and never see rows a writer has not finished. the number of tombstones in effect (see
+//DeletionMap.h) is published together with the length, so the rows an UPDATE deletes and the rows
+//it appends become visible at once.
+class AppendLock {
+public:
+    AppendLock() = default;
+    AppendLock(const AppendLock&) = delete;
+    AppendLock& operator=(const AppendLock&) = delete;
+    ~AppendLock() { unlock(); }
+
+    //waits for the exclusive lock of a table. the table file is then brought in line with its
+    //committed length: bytes a failed writer left past it are cut off, and a file that was changed
+    //by anything else is taken as it is; so are tombstones past the committed count. false if the
+    //lock file cannot be opened
+    bool lock(const std::string& tableName);
+
+    //takes the lock shared, for reading files a writer changes in place (the B+tree indexes);
+    //false at once if a writer holds it
+    bool tryLockShared(const std::string& tableName);
+
+    void unlock();
+
+    //marks the table as being written: until publish, bytes past the committed length are not whole
+    void beginWrite();
+
+    //makes the table's first length bytes visible to readers
+    void publish(std::uint64_t length);
+
+    //the same, together with the first deleted tombstones of the table
+    void publish(std::uint64_t length, std::uint64_t deleted);
+
+    //publishes a table file that replaced the previous one and has no tombstones yet
+    void publishRewrite(std::uint64_t length);
+
+    //tombstones in effect while the lock is held
+    std::uint64_t deletedRows() const;
+
+private:
+    bool openFile(const std::string& tableName);
+    void store(std::uint64_t length, std::uint64_t deleted, std::uint64_t generation);
+
+    int fd = -1;
+    LockState* state = nullptr;
+};
+
+//what a reader may see of a table at one moment
+struct TableSnapshot {
+    std::uint64_t length = 0;     //bytes of the table file that may be read, 0 if it has no text file
+    std::uint64_t deleted = 0;    //tombstones in effect
+    std::uint64_t generation = 0; //raised each time the table file is replaced, as by VACUUM
+};
+
+//the committed length, tombstone count and generation of a table, taken together. a table no writer
+//has published a length for may be read whole
+TableSnapshot readSnapshot(const std::string& tableName);
+
+//bytes of a table file a reader may read, the length of readSnapshot
+std::uint64_t readableLength(const std::string& tableName);
+
+#endif
@@ -0,0 +1,286 @@
+#include "BPlusTree.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char kMagic[8] = {'I', 'D', 'I', 'M', 'B', 'P', 'T', '1'};
+const std::size_t kHeaderSize = 8;
+const std::size_t kBulkFill = BPlusTree::kPageSize * 9 / 10; //leave room for later inserts
+
+template <typename T>
+void put(char*& p, T value) {
+    std::memcpy(p, &value, sizeof(T));
+    p += sizeof(T);
+}
+
+template <typename T>
+T get(const char*& p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+}
+
+std::size_t entrySize(bool leaf, const std::string& key) {
+    return 2 + key.size() + (leaf ? 8 : 4);
+}
+
+std::size_t nodeSize(const BPlusTree::Node& node) {
+    std::size_t size = kHeaderSize;
+    for (const auto& key : node.keys) size += entrySize(node.leaf, key);
+    return size;
+}
+
+//page layout: u8 leaf, u8 unused, u16 count, u32 next (leaf) or first child (internal),
+//then per entry: u16 key length, key bytes, u64 value (leaf) or u32 child (internal)
+void encodeNode(const BPlusTree::Node& node, char* page) {
+    std::memset(page, 0, BPlusTree::kPageSize);
+    char* p = page;
+    put<std::uint8_t>(p, node.leaf ? 1 : 0);
+    put<std::uint8_t>(p, 0);
+    put<std::uint16_t>(p, node.keys.size());
+    put<std::uint32_t>(p, node.leaf ? node.next : node.children[0]);
+    for (std::size_t i = 0; i < node.keys.size(); ++i) {
+        put<std::uint16_t>(p, node.keys[i].size());
+        std::memcpy(p, node.keys[i].data(), node.keys[i].size());
+        p += node.keys[i].size();
+        if (node.leaf) put<std::uint64_t>(p, node.values[i]);
+        else put<std::uint32_t>(p, node.children[i + 1]);
+    }
+}
+
+BPlusTree::Node decodeNode(const char* page) {
+    BPlusTree::Node node;
+    const char* p = page;
+    node.leaf = get<std::uint8_t>(p) != 0;
+    get<std::uint8_t>(p);
+    std::uint16_t count = get<std::uint16_t>(p);
+    std::uint32_t first = get<std::uint32_t>(p);
+    if (node.leaf) node.next = first;
+    else node.children.push_back(first);
+    node.keys.reserve(count);
+    for (std::uint16_t i = 0; i < count; ++i) {
+        std::uint16_t len = get<std::uint16_t>(p);
+        node.keys.emplace_back(p, len);
+        p += len;
+        if (node.leaf) node.values.push_back(get<std::uint64_t>(p));
+        else node.children.push_back(get<std::uint32_t>(p));
+    }
+    return node;
+}
+
+void encodeMeta(char* page, std::uint32_t root, std::uint32_t pageCount) {
+    std::memset(page, 0, BPlusTree::kPageSize);
+    char* p = page;
+    std::memcpy(p, kMagic, sizeof(kMagic));
+    p += sizeof(kMagic);
+    put<std::uint32_t>(p, root);
+    put<std::uint32_t>(p, pageCount);
+}
+
+} // namespace
+
+bool BPlusTree::create(const std::string& path,
+                       const std::vector<std::pair<std::string, std::uint64_t>>& sorted) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    std::vector<char> page(kPageSize);
+    std::uint32_t pageCount = 1; //page 0 holds the meta data
+    out.write(page.data(), kPageSize);
+
+    auto emit = [&](const Node& node) {
+        encodeNode(node, page.data());
+        out.write(page.data(), kPageSize);
+        return pageCount++;
+    };
+
+    //pack the leaves left to right; each leaf links to the page written after it
+    std::vector<std::pair<std::string, std::uint32_t>> level;
+    Node leaf;
+    std::size_t used = kHeaderSize;
+    for (std::size_t i = 0; i < sorted.size(); ++i) {
+        std::size_t size = entrySize(true, sorted[i].first);
+        if (!leaf.keys.empty() && used + size > kBulkFill) {
+            leaf.next = pageCount + 1;
+            level.emplace_back(leaf.keys.front(), emit(leaf));
+            leaf = Node();
+            used = kHeaderSize;
+        }
+        leaf.keys.push_back(sorted[i].first);
+        leaf.values.push_back(sorted[i].second);
+        used += size;
+    }
+    leaf.next = 0;
+    level.emplace_back(leaf.keys.empty() ? std::string() : leaf.keys.front(), emit(leaf));
+
+    //build internal levels until a single root remains
+    while (level.size() > 1) {
+        std::vector<std::pair<std::string, std::uint32_t>> parents;
+        Node node;
+        node.leaf = false;
+        for (const auto& [firstKey, child] : level) {
+            if (node.children.empty()) {
+                node.children.push_back(child);
+                used = kHeaderSize;
+                parents.emplace_back(firstKey, 0);
+                continue;
+            }
+            std::size_t size = entrySize(false, firstKey);
+            if (used + size > kBulkFill) {
+                parents.back().second = emit(node);
+                node = Node();
+                node.leaf = false;
+                node.children.push_back(child);
+                used = kHeaderSize;
+                parents.emplace_back(firstKey, 0);
+                continue;
+            }
+            node.keys.push_back(firstKey);
+            node.children.push_back(child);
+            used += size;
+        }
+        parents.back().second = emit(node);
+        level = std::move(parents);
+    }
+
+    encodeMeta(page.data(), level.front().second, pageCount);
+    out.seekp(0);
+    out.write(page.data(), kPageSize);
+    return static_cast<bool>(out);
+}
+
+bool BPlusTree::open(const std::string& path) {
+    file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file) return false;
+
+    std::vector<char> page(kPageSize);
+    if (!file.read(page.data(), kPageSize) || std::memcmp(page.data(), kMagic, sizeof(kMagic)) != 0) {
+        file.close();
+        return false;
+    }
+    const char* p = page.data() + sizeof(kMagic);
+    root = get<std::uint32_t>(p);
+    pageCount = get<std::uint32_t>(p);
+    return true;
+}
+
+BPlusTree::Node BPlusTree::readNode(std::uint32_t page) {
+    std::vector<char> buffer(kPageSize);
+    file.seekg(static_cast<std::streamoff>(page) * kPageSize);
+    file.read(buffer.data(), kPageSize);
+    return decodeNode(buffer.data());
+}
+
+void BPlusTree::writeNode(std::uint32_t page, const Node& node) {
+    std::vector<char> buffer(kPageSize);
+    encodeNode(node, buffer.data());
+    file.seekp(static_cast<std::streamoff>(page) * kPageSize);
+    file.write(buffer.data(), kPageSize);
+}
+
+std::uint32_t BPlusTree::allocatePage() {
+    return pageCount++;
+}
+
+void BPlusTree::writeMeta() {
+    std::vector<char> buffer(kPageSize);
+    encodeMeta(buffer.data(), root, pageCount);
+    file.seekp(0);
+    file.write(buffer.data(), kPageSize);
+    file.flush();
+}
+
+void BPlusTree::insert(const std::string& key, std::uint64_t value) {
+    Split split = insertInto(root, key, value);
+    if (split.happened) {
+        //the root split: grow the tree by one level
+        Node newRoot;
+        newRoot.leaf = false;
+        newRoot.keys.push_back(split.separator);
+        newRoot.children = {root, split.page};
+        root = allocatePage();
+        writeNode(root, newRoot);
+    }
+    writeMeta();
+}
+
+BPlusTree::Split BPlusTree::insertInto(std::uint32_t page, const std::string& key, std::uint64_t value) {
+    Node node = readNode(page);
+    Split result;
+
+    if (node.leaf) {
+        auto it = std::lower_bound(node.keys.begin(), node.keys.end(), key);
+        std::size_t pos = it - node.keys.begin();
+        if (it != node.keys.end() && *it == key) {
+            node.values[pos] = value;
+            writeNode(page, node);
+            return result;
+        }
+        node.keys.insert(it, key);
+        node.values.insert(node.values.begin() + pos, value);
+    } else {
+        std::size_t pos = std::upper_bound(node.keys.begin(), node.keys.end(), key) - node.keys.begin();
+        Split child = insertInto(node.children[pos], key, value);
+        if (!child.happened) return result;
+        node.keys.insert(node.keys.begin() + pos, child.separator);
+        node.children.insert(node.children.begin() + pos + 1, child.page);
+    }
+
+    if (nodeSize(node) <= kPageSize) {
+        writeNode(page, node);
+        return result;
+    }
+
+    //overflow: move the upper half of the entries to a new right sibling
+    std::size_t mid = node.keys.size() / 2;
+    Node right;
+    right.leaf = node.leaf;
+    result.happened = true;
+    result.page = allocatePage();
+    if (node.leaf) {
+        right.keys.assign(node.keys.begin() + mid, node.keys.end());
+        right.values.assign(node.values.begin() + mid, node.values.end());
+        node.keys.resize(mid);
+        node.values.resize(mid);
+        right.next = node.next;
+        node.next = result.page;
+        result.separator = right.keys.front();
+    } else {
+        result.separator = node.keys[mid];
+        right.keys.assign(node.keys.begin() + mid + 1, node.keys.end());
+        right.children.assign(node.children.begin() + mid + 1, node.children.end());
+        node.keys.resize(mid);
+        node.children.resize(mid + 1);
+    }
+    writeNode(result.page, right);
+    writeNode(page, node);
+    return result;
+}
+
+BPlusTree::Cursor BPlusTree::lowerBound(const std::string& key) {
+    Cursor cursor;
+    cursor.tree = this;
+    Node node = readNode(root);
+    while (!node.leaf) {
+        std::size_t pos = std::upper_bound(node.keys.begin(), node.keys.end(), key) - node.keys.begin();
+        node = readNode(node.children[pos]);
+    }
+    cursor.index = std::lower_bound(node.keys.begin(), node.keys.end(), key) - node.keys.begin();
+    cursor.node = std::move(node);
+    if (!cursor.valid() && cursor.node.next != 0) {
+        cursor.index = cursor.node.keys.size();
+        cursor.next();
+    }
+    return cursor;
+}
+
+void BPlusTree::Cursor::next() {
+    ++index;
+    while (index >= node.keys.size() && node.next != 0) {
+        node = tree->readNode(node.next);
+        index = 0;
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef BPLUS_TREE_H
+#define BPLUS_TREE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+//disk-resident B+tree mapping unique byte-string keys to 64-bit values.
+//keys are ordered by plain byte comparison; leaves are chained for range scans.
+class BPlusTree {
+public:
+    static const std::size_t kPageSize = 4096;
+    static const std::size_t kMaxKeySize = 1024; //keys must stay below this to fit a page split
+
+    //a node decoded from its page
+    struct Node {
+        bool leaf = true;
+        std::uint32_t next = 0;                 //leaf: right sibling page, 0 if none
+        std::vector<std::string> keys;
+        std::vector<std::uint64_t> values;      //leaf only
+        std::vector<std::uint32_t> children;    //internal only, keys.size() + 1 entries
+    };
+
+    //forward iterator over leaf entries in key order
+    class Cursor {
+    public:
+        bool valid() const { return index < node.keys.size(); }
+        const std::string& key() const { return node.keys[index]; }
+        std::uint64_t value() const { return node.values[index]; }
+        void next();
+
+    private:
+        friend class BPlusTree;
+        BPlusTree* tree = nullptr;
+        Node node;
+        std::size_t index = 0;
+    };
+
+    //writes a new tree file holding the given entries, which must be sorted and unique
+    static bool create(const std::string& path,
+                       const std::vector<std::pair<std::string, std::uint64_t>>& sorted);
+
+    bool open(const std::string& path);
+    bool isOpen() const { return file.is_open(); }
+
+    //adds a key, replacing the value if the key is already present
+    void insert(const std::string& key, std::uint64_t value);
+
+    //positions a cursor on the first key not less than the given one
+    Cursor lowerBound(const std::string& key);
+
+private:
+    struct Split {
+        bool happened = false;
+        std::string separator;
+        std::uint32_t page = 0;
+    };
+
+    Node readNode(std::uint32_t page);
+    void writeNode(std::uint32_t page, const Node& node);
+    std::uint32_t allocatePage();
+    void writeMeta();
+    Split insertInto(std::uint32_t page, const std::string& key, std::uint64_t value);
+
+    std::fstream file;
+    std::uint32_t root = 0;
+    std::uint32_t pageCount = 0;
+};
+
+#endif
@@ -0,0 +1,449 @@
+#include "ColumnStore.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kMagic[8] = {'I', 'D', 'I', 'M', 'C', 'O', 'L', '1'};
+const std::uint32_t kRaggedFlag = 1;
+const std::uint32_t kCompressedFlag = 2;
+const std::uint64_t kSegmentAlign = 4096;
+const std::size_t kMaxEntries = 1 << 16; //largest dictionary, so codes fit in 2 bytes
+
+//file layout: magic, u32 column count, u32 flags, u64 row count, u64 width segment offset,
+//then per column u8 type, u16 name length, name, u64 segment offset. segments start on page
+//boundaries: 8 bytes per row for numeric columns, (rows + 1) u64 offsets then the blob for strings.
+//an encoded column has u32 entry count, u32 code width, u64 run count, (entries + 1) u64 offsets
+//and the entry bytes, then, 8-byte aligned, a code per row (Dictionary) or the u64 end rows and
+//u32 codes of its runs (RunLength).
+
+template <typename T>
+void put(char*& p, T value) {
+    std::memcpy(p, &value, sizeof(T));
+    p += sizeof(T);
+}
+
+template <typename T>
+T get(const char*& p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+}
+
+template <typename T>
+T load(const char* p, std::uint64_t index) {
+    T value;
+    std::memcpy(&value, p + index * sizeof(T), sizeof(T));
+    return value;
+}
+
+std::uint64_t alignUp(std::uint64_t value) {
+    return (value + kSegmentAlign - 1) / kSegmentAlign * kSegmentAlign;
+}
+
+//true if the text is exactly what printing the parsed integer would give back
+bool isCanonicalInt(const std::string& text, std::int64_t& value) {
+    if (text.empty()) return false;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size()) return false;
+    char buffer[ColumnTable::kScratchSize];
+    auto printed = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::string_view(buffer, printed.ptr - buffer) == text;
+}
+
+//true if the text is exactly the shortest round-trip form of the parsed double
+bool isCanonicalDouble(const std::string& text, double& value) {
+    if (text.empty()) return false;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size()) return false;
+    char buffer[ColumnTable::kScratchSize];
+    auto printed = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return std::string_view(buffer, printed.ptr - buffer) == text;
+}
+
+struct ColumnPlan {
+    bool canInt = true;
+    bool canDouble = true;
+    std::uint64_t blobBytes = 0;
+    ColumnType type = ColumnType::String;
+    std::uint64_t offset = 0;
+    std::uint64_t blobCursor = 0;
+
+    //dictionary encoding: the distinct cells while there are at most kMaxEntries of them
+    bool canEncode = false;
+    std::unordered_map<std::string, std::uint32_t> codes;
+    std::uint64_t entryBytes = 0;
+    std::uint64_t runs = 0;
+    std::string last;
+    std::uint32_t codeWidth = 0;
+    std::uint64_t run = 0;       //second pass: run being written
+    std::uint32_t runCode = 0;
+};
+
+//bytes of an encoded segment up to its payload
+std::uint64_t dictionaryBytes(const ColumnPlan& plan) {
+    return (16 + (plan.codes.size() + 1) * 8 + plan.entryBytes + 7) / 8 * 8;
+}
+
+//picks the smallest of the plain, dictionary and run-length forms of a text column, and numbers
+//its dictionary entries in bytewise order
+void planEncoding(ColumnPlan& plan, std::uint64_t rowCount) {
+    if (!plan.canEncode) return;
+    std::uint64_t plainBytes = (rowCount + 1) * 8 + plan.blobBytes;
+    std::uint32_t width = plan.codes.size() <= 256 ? 1 : 2;
+    std::uint64_t codeBytes = dictionaryBytes(plan) + rowCount * width;
+    std::uint64_t runBytes = dictionaryBytes(plan) + plan.runs * 12;
+    if (runBytes < codeBytes && runBytes < plainBytes) {
+        plan.type = ColumnType::RunLength;
+    } else if (codeBytes < plainBytes) {
+        plan.type = ColumnType::Dictionary;
+        plan.codeWidth = width;
+    } else {
+        return;
+    }
+    std::vector<const std::string*> entries;
+    for (const auto& entry : plan.codes) entries.push_back(&entry.first);
+    std::sort(entries.begin(), entries.end(), [](const std::string* a, const std::string* b) { return *a < *b; });
+    for (std::uint32_t code = 0; code < entries.size(); ++code) plan.codes[*entries[code]] = code;
+}
+
+//fills the head of an encoded segment: counts, then the entries in code order
+void writeDictionary(char* segment, const ColumnPlan& plan) {
+    std::vector<const std::string*> entries(plan.codes.size());
+    for (const auto& entry : plan.codes) entries[entry.second] = &entry.first;
+    char* p = segment;
+    put<std::uint32_t>(p, entries.size());
+    put<std::uint32_t>(p, plan.codeWidth);
+    put<std::uint64_t>(p, plan.runs);
+    char* blob = p + (entries.size() + 1) * 8;
+    std::uint64_t cursor = 0;
+    for (const std::string* entry : entries) {
+        put<std::uint64_t>(p, cursor);
+        std::memcpy(blob + cursor, entry->data(), entry->size());
+        cursor += entry->size();
+    }
+    put<std::uint64_t>(p, cursor);
+}
+
+} // namespace
+
+bool writeColumnTable(const std::string& path, const std::vector<std::string>& headers,
+                      const std::function<bool(std::vector<std::string>&)>& read,
+                      const std::function<void()>& rewind, bool compress) {
+    const std::size_t columnCount = headers.size();
+    std::vector<ColumnPlan> plans(columnCount);
+    for (auto& plan : plans) plan.canEncode = compress;
+    const std::string missing;
+    std::vector<std::string> row;
+    std::uint64_t rowCount = 0;
+    bool ragged = false;
+
+    //first pass: pick each column's type and size its segment
+    while (read(row)) {
+        ++rowCount;
+        if (row.size() != columnCount) ragged = true;
+        for (std::size_t c = 0; c < columnCount && c < row.size(); ++c) {
+            auto& plan = plans[c];
+            std::int64_t i;
+            double d;
+            if (plan.canInt && !isCanonicalInt(row[c], i)) plan.canInt = false;
+            if (!plan.canInt && plan.canDouble && !isCanonicalDouble(row[c], d)) plan.canDouble = false;
+            plan.blobBytes += row[c].size();
+        }
+
+        //a row without the cell stores it as empty, as the plain segment does
+        for (std::size_t c = 0; c < columnCount; ++c) {
+            auto& plan = plans[c];
+            if (!plan.canEncode) continue;
+            const std::string& cell = c < row.size() ? row[c] : missing;
+            if (rowCount == 1 || cell != plan.last) {
+                ++plan.runs;
+                plan.last = cell;
+            }
+            if (plan.codes.emplace(cell, 0).second) {
+                plan.entryBytes += cell.size();
+                if (plan.codes.size() > kMaxEntries) {
+                    plan.canEncode = false;
+                    plan.codes.clear();
+                }
+            }
+        }
+    }
+
+    std::uint64_t headerSize = sizeof(kMagic) + 4 + 4 + 8 + 8;
+    for (const auto& name : headers) headerSize += 1 + 2 + name.size() + 8;
+
+    std::uint64_t end = alignUp(headerSize);
+    std::uint64_t widthOffset = 0;
+    if (ragged) {
+        widthOffset = end;
+        end = alignUp(end + rowCount * 4);
+    }
+    for (auto& plan : plans) {
+        plan.type = plan.canInt ? ColumnType::Int64 : plan.canDouble ? ColumnType::Double : ColumnType::String;
+        if (plan.type == ColumnType::String) planEncoding(plan, rowCount);
+        plan.offset = end;
+        std::uint64_t bytes;
+        if (plan.type == ColumnType::Dictionary) bytes = dictionaryBytes(plan) + rowCount * plan.codeWidth;
+        else if (plan.type == ColumnType::RunLength) bytes = dictionaryBytes(plan) + plan.runs * 12;
+        else if (plan.type == ColumnType::String) bytes = (rowCount + 1) * 8 + plan.blobBytes;
+        else bytes = rowCount * 8;
+        end = alignUp(end + bytes);
+    }
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0) return false;
+    if (::ftruncate(fd, end) != 0) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = ::mmap(nullptr, end, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+    char* out = static_cast<char*>(mapped);
+
+    char* p = out;
+    std::memcpy(p, kMagic, sizeof(kMagic));
+    p += sizeof(kMagic);
+    put<std::uint32_t>(p, columnCount);
+    put<std::uint32_t>(p, (ragged ? kRaggedFlag : 0) | (compress ? kCompressedFlag : 0));
+    put<std::uint64_t>(p, rowCount);
+    put<std::uint64_t>(p, widthOffset);
+    for (std::size_t c = 0; c < columnCount; ++c) {
+        put<std::uint8_t>(p, static_cast<std::uint8_t>(plans[c].type));
+        put<std::uint16_t>(p, headers[c].size());
+        std::memcpy(p, headers[c].data(), headers[c].size());
+        p += headers[c].size();
+        put<std::uint64_t>(p, plans[c].offset);
+        if (plans[c].type == ColumnType::Dictionary || plans[c].type == ColumnType::RunLength) {
+            writeDictionary(out + plans[c].offset, plans[c]);
+        }
+    }
+
+    //second pass: write every cell straight into its segment
+    rewind();
+    for (std::uint64_t r = 0; r < rowCount && read(row); ++r) {
+        if (ragged) {
+            std::uint32_t width = std::min(row.size(), columnCount);
+            std::memcpy(out + widthOffset + r * 4, &width, 4);
+        }
+        for (std::size_t c = 0; c < columnCount; ++c) {
+            auto& plan = plans[c];
+            char* segment = out + plan.offset;
+            bool present = c < row.size();
+            if (plan.type == ColumnType::Int64) {
+                std::int64_t value = 0;
+                if (present) std::from_chars(row[c].data(), row[c].data() + row[c].size(), value);
+                std::memcpy(segment + r * 8, &value, 8);
+            } else if (plan.type == ColumnType::Double) {
+                double value = 0;
+                if (present) std::from_chars(row[c].data(), row[c].data() + row[c].size(), value);
+                std::memcpy(segment + r * 8, &value, 8);
+            } else if (plan.type == ColumnType::Dictionary) {
+                std::uint32_t code = plan.codes.find(present ? row[c] : missing)->second;
+                std::memcpy(segment + dictionaryBytes(plan) + r * plan.codeWidth, &code, plan.codeWidth);
+            } else if (plan.type == ColumnType::RunLength) {
+                //a run is written once the next one starts, and the last one after the rows
+                std::uint32_t code = plan.codes.find(present ? row[c] : missing)->second;
+                char* ends = segment + dictionaryBytes(plan);
+                if (r > 0 && code != plan.runCode) {
+                    std::memcpy(ends + plan.run * 8, &r, 8);
+                    std::memcpy(ends + plan.runs * 8 + plan.run * 4, &plan.runCode, 4);
+                    ++plan.run;
+                }
+                plan.runCode = code;
+            } else {
+                char* blob = segment + (rowCount + 1) * 8;
+                std::memcpy(segment + r * 8, &plan.blobCursor, 8);
+                if (present) {
+                    std::memcpy(blob + plan.blobCursor, row[c].data(), row[c].size());
+                    plan.blobCursor += row[c].size();
+                }
+                std::memcpy(segment + (r + 1) * 8, &plan.blobCursor, 8);
+            }
+        }
+    }
+
+    for (auto& plan : plans) {
+        if (plan.type != ColumnType::RunLength || rowCount == 0) continue;
+        char* ends = out + plan.offset + dictionaryBytes(plan);
+        std::memcpy(ends + plan.run * 8, &rowCount, 8);
+        std::memcpy(ends + plan.runs * 8 + plan.run * 4, &plan.runCode, 4);
+    }
+
+    bool ok = ::msync(out, end, MS_SYNC) == 0;
+    ::munmap(out, end);
+    return ok;
+}
+
+ColumnTable::~ColumnTable() {
+    if (base) ::munmap(const_cast<char*>(base), size);
+}
+
+bool ColumnTable::open(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(kMagic) + 24)) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+    base = static_cast<const char*>(mapped);
+    size = st.st_size;
+
+    //every offset and count in the file is checked against its size before it is used, so a
+    //truncated or corrupt file fails to open instead of sending reads past the mapping
+    auto fits = [&](std::uint64_t offset, std::uint64_t count, std::uint64_t width) {
+        return offset <= size && count <= (size - offset) / width;
+    };
+    if (std::memcmp(base, kMagic, sizeof(kMagic)) != 0) return false;
+    const char* p = base + sizeof(kMagic);
+    std::uint32_t columnCount = get<std::uint32_t>(p);
+    std::uint32_t flags = get<std::uint32_t>(p);
+    rows = get<std::uint64_t>(p);
+    std::uint64_t widthOffset = get<std::uint64_t>(p);
+    if (flags & kRaggedFlag) {
+        if (widthOffset % 4 != 0 || !fits(widthOffset, rows, 4)) return false;
+        widths = reinterpret_cast<const std::uint32_t*>(base + widthOffset);
+    }
+    compressedFile = flags & kCompressedFlag;
+
+    for (std::uint32_t c = 0; c < columnCount; ++c) {
+        Column column;
+        if (!fits(p - base, 3, 1)) return false;
+        column.type = static_cast<ColumnType>(get<std::uint8_t>(p));
+        std::uint16_t nameLen = get<std::uint16_t>(p);
+        if (!fits(p - base, nameLen + 8, 1)) return false;
+        names.emplace_back(p, nameLen);
+        p += nameLen;
+        std::uint64_t offset = get<std::uint64_t>(p);
+        if (offset > size) return false;
+        column.data = base + offset;
+        if (column.type == ColumnType::Int64 || column.type == ColumnType::Double) {
+            if (!fits(offset, rows, 8)) return false;
+        } else if (column.type == ColumnType::String) {
+            if (rows >= (size - offset) / 8) return false;
+            column.blobBytes = load<std::uint64_t>(column.data, rows);
+            if (!fits(offset + (rows + 1) * 8, column.blobBytes, 1)) return false;
+        } else if (column.type == ColumnType::Dictionary || column.type == ColumnType::RunLength) {
+            if (!fits(offset, 16, 1)) return false;
+            const char* q = column.data;
+            column.entries = get<std::uint32_t>(q);
+            column.codeWidth = get<std::uint32_t>(q);
+            column.runs = get<std::uint64_t>(q);
+            if (column.entries > kMaxEntries || (rows > 0 && column.entries == 0) ||
+                !fits(offset + 16, column.entries + 1, 8)) {
+                return false;
+            }
+            column.blob = q + (column.entries + 1) * 8;
+            std::uint64_t entryBytes = load<std::uint64_t>(q, column.entries);
+            if (!fits(column.blob - base, entryBytes, 1)) return false;
+            for (std::uint32_t e = 0; e < column.entries; ++e) {
+                if (load<std::uint64_t>(q, e) > load<std::uint64_t>(q, e + 1)) return false;
+            }
+            std::uint64_t payloadOffset = (column.blob + entryBytes - base + 7) / 8 * 8;
+            if (payloadOffset > size) return false;
+            column.payload = base + payloadOffset;
+            if (column.type == ColumnType::Dictionary) {
+                if ((column.codeWidth != 1 && column.codeWidth != 2) || !fits(payloadOffset, rows, column.codeWidth)) {
+                    return false;
+                }
+            } else {
+                //runs end in ascending rows, the last at the end of the table
+                if ((rows > 0 && column.runs == 0) || !fits(payloadOffset, column.runs, 12)) return false;
+                std::uint64_t previous = 0;
+                for (std::uint64_t run = 0; run < column.runs; ++run) {
+                    std::uint64_t runEnd = load<std::uint64_t>(column.payload, run);
+                    if (runEnd <= previous) return false;
+                    previous = runEnd;
+                }
+                if (previous != rows) return false;
+            }
+        } else {
+            return false;
+        }
+        columns.push_back(column);
+    }
+
+    //column segments are read front to back by scans
+    ::madvise(const_cast<char*>(base), size, MADV_SEQUENTIAL);
+    return true;
+}
+
+std::size_t ColumnTable::rowWidth(std::uint64_t row) const {
+    return widths ? std::min<std::size_t>(widths[row], columns.size()) : columns.size();
+}
+
+double ColumnTable::numberAt(std::size_t col, std::uint64_t row) const {
+    const Column& column = columns[col];
+    if (column.type == ColumnType::Int64) return static_cast<double>(load<std::int64_t>(column.data, row));
+    return load<double>(column.data, row);
+}
+
+std::string_view ColumnTable::dictionaryEntry(std::size_t col, std::uint32_t code) const {
+    const Column& column = columns[col];
+    auto begin = load<std::uint64_t>(column.data + 16, code);
+    auto end = load<std::uint64_t>(column.data + 16, code + 1);
+    return std::string_view(column.blob + begin, end - begin);
+}
+
+std::uint32_t ColumnTable::codeAt(std::size_t col, std::uint64_t row) const {
+    const Column& column = columns[col];
+    if (column.type == ColumnType::Dictionary) {
+        //a code past the dictionary, from a corrupt file, reads as the first entry
+        std::uint32_t code = column.codeWidth == 1 ? static_cast<std::uint8_t>(column.payload[row])
+                                                   : load<std::uint16_t>(column.payload, row);
+        return code < column.entries ? code : 0;
+    }
+
+    //the first run that ends past the row
+    std::uint64_t low = 0, high = column.runs - 1;
+    while (low < high) {
+        std::uint64_t middle = (low + high) / 2;
+        if (load<std::uint64_t>(column.payload, middle) <= row) low = middle + 1;
+        else high = middle;
+    }
+    return runCode(col, low);
+}
+
+std::uint64_t ColumnTable::runEnd(std::size_t col, std::uint64_t run) const {
+    return load<std::uint64_t>(columns[col].payload, run);
+}
+
+std::uint32_t ColumnTable::runCode(std::size_t col, std::uint64_t run) const {
+    const Column& column = columns[col];
+    std::uint32_t code = load<std::uint32_t>(column.payload + column.runs * 8, run);
+    return code < column.entries ? code : 0;
+}
+
+std::string_view ColumnTable::cell(std::size_t col, std::uint64_t row, char* scratch) const {
+    const Column& column = columns[col];
+    if (column.type == ColumnType::Dictionary || column.type == ColumnType::RunLength) {
+        return dictionaryEntry(col, codeAt(col, row));
+    }
+    if (column.type == ColumnType::String) {
+        //offsets are kept inside the blob, whatever the file holds
+        auto end = std::min(load<std::uint64_t>(column.data, row + 1), column.blobBytes);
+        auto begin = std::min(load<std::uint64_t>(column.data, row), end);
+        return std::string_view(column.data + (rows + 1) * 8 + begin, end - begin);
+    }
+    std::to_chars_result printed;
+    if (column.type == ColumnType::Int64) {
+        printed = std::to_chars(scratch, scratch + kScratchSize, load<std::int64_t>(column.data, row));
+    } else {
+        printed = std::to_chars(scratch, scratch + kScratchSize, load<double>(column.data, row));
+    }
+    return std::string_view(scratch, printed.ptr - scratch);
+}
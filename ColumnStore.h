@@ -0,0 +1,102 @@
+#ifndef COLUMN_STORE_H
+#define COLUMN_STORE_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//physical type of a column segment
+enum class ColumnType : std::uint8_t {
+    Int64 = 0,  //every cell is a canonical integer
+    Double = 1, //every cell round-trips through the shortest double representation
+    String = 2,     //offsets array plus a blob of the raw cell bytes
+    Dictionary = 3, //dictionary of the distinct cells plus a 1- or 2-byte code per row
+    RunLength = 4   //dictionary plus one (end row, code) pair per run of equal cells
+};
+
+//writes a columnar table file. rows are streamed twice: the first pass infers column types and
+//segment sizes, the second fills the segments in place. read returns false at the end of the
+//rows and rewind restarts them. cells past the header width are dropped. with compress, a text
+//column of few distinct cells is stored as dictionary codes, or as runs of codes when its equal
+//cells come in long runs, whichever is smaller than the plain segment.
+bool writeColumnTable(const std::string& path, const std::vector<std::string>& headers,
+                      const std::function<bool(std::vector<std::string>&)>& read,
+                      const std::function<void()>& rewind, bool compress = false);
+
+//read-only view of a columnar table file mapped into memory. each column lives in its own
+//page-aligned segment, so a scan only faults in the pages of the columns it touches.
+class ColumnTable {
+public:
+    //scratch space callers pass to cell() for formatting numeric values
+    static const std::size_t kScratchSize = 32;
+
+    ColumnTable() = default;
+    ColumnTable(const ColumnTable&) = delete;
+    ColumnTable& operator=(const ColumnTable&) = delete;
+    ~ColumnTable();
+
+    bool open(const std::string& path);
+
+    std::uint64_t rowCount() const { return rows; }
+    std::size_t columnCount() const { return columns.size(); }
+    const std::vector<std::string>& columnNames() const { return names; }
+    ColumnType columnType(std::size_t col) const { return columns[col].type; }
+    std::uintmax_t fileSize() const { return size; }
+
+    //true if the file was written with compression, whether or not any column was encoded
+    bool compressed() const { return compressedFile; }
+
+    //true for Dictionary and RunLength columns
+    bool encoded(std::size_t col) const {
+        return columns[col].type == ColumnType::Dictionary || columns[col].type == ColumnType::RunLength;
+    }
+
+    //dictionary of an encoded column: the distinct cells sorted bytewise, indexed by code
+    std::uint32_t dictionarySize(std::size_t col) const { return columns[col].entries; }
+    std::string_view dictionaryEntry(std::size_t col, std::uint32_t code) const;
+
+    //code of a cell in an encoded column
+    std::uint32_t codeAt(std::size_t col, std::uint64_t row) const;
+
+    //runs of a RunLength column in row order: run i holds code runCode(col, i) up to row
+    //runEnd(col, i), exclusive
+    std::uint64_t runCount(std::size_t col) const { return columns[col].runs; }
+    std::uint64_t runEnd(std::size_t col, std::uint64_t run) const;
+    std::uint32_t runCode(std::size_t col, std::uint64_t run) const;
+
+    //true if some rows have fewer cells than the header
+    bool ragged() const { return widths != nullptr; }
+
+    //number of cells the row had in the source file (at most columnCount())
+    std::size_t rowWidth(std::uint64_t row) const;
+
+    //numeric value of a cell in an Int64 or Double column
+    double numberAt(std::size_t col, std::uint64_t row) const;
+
+    //text of a cell exactly as it appeared in the source file; numeric cells are formatted into scratch
+    std::string_view cell(std::size_t col, std::uint64_t row, char* scratch) const;
+
+private:
+    struct Column {
+        ColumnType type = ColumnType::String;
+        const char* data = nullptr;
+        std::uint32_t entries = 0;       //encoded columns: dictionary size
+        std::uint32_t codeWidth = 0;     //Dictionary: bytes per code
+        std::uint64_t runs = 0;          //RunLength: number of runs
+        const char* blob = nullptr;      //encoded columns: bytes of the dictionary entries
+        const char* payload = nullptr;   //Dictionary: codes; RunLength: run ends, then run codes
+        std::uint64_t blobBytes = 0;     //String: bytes of the cells
+    };
+
+    const char* base = nullptr;
+    std::uintmax_t size = 0;
+    std::uint64_t rows = 0;
+    bool compressedFile = false;
+    const std::uint32_t* widths = nullptr; //null when every row has the full header width
+    std::vector<std::string> names;
+    std::vector<Column> columns;
+};
+
+#endif
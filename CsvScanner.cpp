@@ -0,0 +1,210 @@
+#include "CsvScanner.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CSV_SCANNER_X86 1
+#endif
+
+namespace {
+
+//first occurrence of c in [p, end), or end
+const char* findByteScalar(const char* p, const char* end, char c) {
+    while (p < end && *p != c) ++p;
+    return p;
+}
+
+#ifdef CSV_SCANNER_X86
+const char* findByteSse2(const char* p, const char* end, char c) {
+    const __m128i needle = _mm_set1_epi8(c);
+    for (; end - p >= 16; p += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return findByteScalar(p, end, c);
+}
+
+__attribute__((target("avx2")))
+const char* findByteAvx2(const char* p, const char* end, char c) {
+    const __m256i needle = _mm256_set1_epi8(c);
+    for (; end - p >= 32; p += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return findByteSse2(p, end, c);
+}
+#endif
+
+using FindByte = const char* (*)(const char*, const char*, char);
+
+bool supported(ScanLevel level) {
+#ifdef CSV_SCANNER_X86
+    if (level == ScanLevel::AVX2) return __builtin_cpu_supports("avx2");
+    return true;
+#else
+    return level == ScanLevel::Scalar;
+#endif
+}
+
+ScanLevel bestLevel() {
+    if (supported(ScanLevel::AVX2)) return ScanLevel::AVX2;
+    if (supported(ScanLevel::SSE2)) return ScanLevel::SSE2;
+    return ScanLevel::Scalar;
+}
+
+FindByte finderFor(ScanLevel level) {
+#ifdef CSV_SCANNER_X86
+    if (level == ScanLevel::AVX2) return findByteAvx2;
+    if (level == ScanLevel::SSE2) return findByteSse2;
+#endif
+    return findByteScalar;
+}
+
+ScanLevel activeLevel = bestLevel();
+FindByte findByte = finderFor(activeLevel);
+
+//position after the closing quote of a quoted value whose contents start at p, or end
+const char* skipQuoted(const char* p, const char* end) {
+    while (true) {
+        p = findByte(p, end, '\'');
+        if (p == end) return end;
+        if (p + 1 < end && p[1] == '\'') {
+            p += 2;
+            continue;
+        }
+        return p + 1;
+    }
+}
+
+//calls emit(begin, end) for every value of the row
+template <typename Emit>
+void scanRow(std::string_view line, Emit&& emit) {
+    const char* p = line.data();
+    const char* end = p + line.size();
+    const char* fieldStart = p;
+    while (true) {
+        if (p == fieldStart && p < end && *p == '\'') p = skipQuoted(p + 1, end);
+        p = findByte(p, end, ',');
+        if (p == end) break;
+        emit(fieldStart, p);
+        fieldStart = ++p;
+    }
+    if (fieldStart < end) emit(fieldStart, end);
+}
+
+} // namespace
+
+ScanLevel scanLevel() {
+    return activeLevel;
+}
+
+const char* scanLevelName(ScanLevel level) {
+    switch (level) {
+        case ScanLevel::AVX2: return "avx2";
+        case ScanLevel::SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+bool setScanLevel(ScanLevel level) {
+    if (!supported(level)) return false;
+    activeLevel = level;
+    findByte = finderFor(level);
+    return true;
+}
+
+size_t splitRow(std::string_view line, std::vector<std::string_view>& fields) {
+    fields.clear();
+    scanRow(line, [&](const char* begin, const char* end) { fields.emplace_back(begin, end - begin); });
+    return fields.size();
+}
+
+size_t splitRow(std::string_view line, std::vector<std::string>& fields) {
+    size_t count = 0;
+    scanRow(line, [&](const char* begin, const char* end) {
+        if (count < fields.size()) fields[count].assign(begin, end);
+        else fields.emplace_back(begin, end);
+        ++count;
+    });
+    fields.resize(count);
+    return count;
+}
+
+CsvReader::~CsvReader() {
+    if (fd >= 0) ::close(fd);
+}
+
+bool CsvReader::open(const std::string& path, std::uint64_t limit) {
+    fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st = {};
+    end = ::fstat(fd, &st) == 0 ? std::min<std::uint64_t>(st.st_size, limit) : limit;
+    id = st.st_ino;
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    buffer.resize(kBlockSize);
+    return true;
+}
+
+bool CsvReader::fill() {
+    if (eof) return false;
+
+    //keep the unread tail, growing the buffer if a single line outgrew it
+    if (pos > 0) {
+        std::memmove(buffer.data(), buffer.data() + pos, len - pos);
+        bufferOffset += pos;
+        len -= pos;
+        pos = 0;
+    }
+    if (len == buffer.size()) buffer.resize(buffer.size() * 2);
+
+    //reads after a seek start small and double back up to full blocks when scanning on
+    std::uint64_t left = bufferOffset + len < end ? end - (bufferOffset + len) : 0;
+    size_t want = std::min<std::uint64_t>(std::min(readSize, buffer.size() - len), left);
+    readSize = std::min(readSize * 2, kBlockSize);
+    ssize_t n = want == 0 ? 0 : ::read(fd, buffer.data() + len, want);
+    if (n <= 0) {
+        eof = true;
+        return false;
+    }
+    len += n;
+    return true;
+}
+
+bool CsvReader::nextLine(std::string_view& line) {
+    while (true) {
+        const char* begin = buffer.data() + pos;
+        const char* end = buffer.data() + len;
+        const char* newline = findByte(begin, end, '\n');
+        if (newline != end) {
+            line = std::string_view(begin, newline - begin);
+            pos += newline - begin + 1;
+            return true;
+        }
+        if (!fill()) {
+            if (pos == len) return false;
+            line = std::string_view(buffer.data() + pos, len - pos);
+            pos = len;
+            return true;
+        }
+    }
+}
+
+void CsvReader::seek(std::uint64_t offset) {
+    if (offset >= bufferOffset && offset < bufferOffset + len) {
+        pos = offset - bufferOffset;
+        return;
+    }
+    ::lseek(fd, offset, SEEK_SET);
+    bufferOffset = offset;
+    pos = len = 0;
+    eof = false;
+    readSize = 4096;
+}
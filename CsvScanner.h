@@ -0,0 +1,70 @@
+#ifndef CSV_SCANNER_H
+#define CSV_SCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//instruction sets the scanner can search bytes with, picked at startup from what the CPU supports
+enum class ScanLevel { Scalar, SSE2, AVX2 };
+
+ScanLevel scanLevel();
+const char* scanLevelName(ScanLevel level);
+
+//switches the byte search, false if the CPU lacks the instructions (used by the benchmark)
+bool setScanLevel(ScanLevel level);
+
+//splits one table row into views of its values without copying. a value that starts with a
+//quote runs to the matching closing quote ('' stands for one quote), so it may hold commas.
+//like reading with getline(',') a trailing empty value is dropped and an empty line has none.
+size_t splitRow(std::string_view line, std::vector<std::string_view>& fields);
+
+//same split, copying the values into strings
+size_t splitRow(std::string_view line, std::vector<std::string>& fields);
+
+//reads a text table in large blocks and hands out its lines as views into the block buffer
+class CsvReader {
+public:
+    static constexpr size_t kBlockSize = 1u << 20;
+
+    CsvReader() = default;
+    CsvReader(const CsvReader&) = delete;
+    CsvReader& operator=(const CsvReader&) = delete;
+    ~CsvReader();
+
+    //reads the file up to limit bytes, the table's committed length (see AppendLock.h)
+    bool open(const std::string& path, std::uint64_t limit = UINT64_MAX);
+    bool isOpen() const { return fd >= 0; }
+
+    //bytes of the file the reader covers
+    std::uint64_t size() const { return end; }
+
+    //identity (inode) of the open file, which tells it from a file that replaced it at the same path
+    std::uint64_t fileId() const { return id; }
+
+    //next line without its '\n'; the view stays valid until the next call
+    bool nextLine(std::string_view& line);
+
+    //continues reading at a byte offset, which must be the start of a line. seeks within the
+    //current block are free; others start over with small reads since they are usually index probes.
+    void seek(std::uint64_t offset);
+
+    //file offset of the next line
+    std::uint64_t offset() const { return bufferOffset + pos; }
+
+private:
+    bool fill();
+
+    int fd = -1;
+    std::vector<char> buffer;
+    size_t pos = 0, len = 0;        //unread bytes are buffer[pos, len)
+    std::uint64_t bufferOffset = 0; //file offset of buffer[0]
+    std::uint64_t end = 0;          //bytes of the file that are read
+    std::uint64_t id = 0;
+    size_t readSize = kBlockSize;
+    bool eof = false;
+};
+
+#endif
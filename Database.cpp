@@ -0,0 +1,209 @@
+#include "Database.h"
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+
+#include "CsvScanner.h"
+
+namespace {
+
+//passes what commands print to out() on to a sink's message(), a line at a time
+class MessageBuffer : public std::streambuf {
+public:
+    explicit MessageBuffer(ResultSink& sink) : sink(sink) {}
+
+    ~MessageBuffer() override {
+        if (!pending.empty()) sink.message(pending);
+    }
+
+protected:
+    int overflow(int c) override {
+        if (c != traits_type::eof()) {
+            char ch = traits_type::to_char_type(c);
+            xsputn(&ch, 1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char* text, std::streamsize count) override {
+        pending.append(text, count);
+        size_t end = pending.rfind('\n');
+        if (end != std::string::npos) {
+            sink.message(std::string_view(pending).substr(0, end + 1));
+            pending.erase(0, end + 1);
+        }
+        return count;
+    }
+
+private:
+    ResultSink& sink;
+    std::string pending;
+};
+
+//runs commands with their results and messages going to sink
+void runCommands(const std::string& sql, ResultSink& sink) {
+    MessageBuffer messages(sink);
+    std::ostream stream(&messages);
+    OutputCapture capture(stream);
+    ResultCapture results(sink);
+    executeSqlCommand(sql);
+}
+
+} // namespace
+
+Database::Database(const Settings& options) {
+    settings = options;
+}
+
+Connection Database::connect() {
+    return Connection();
+}
+
+//what the command thread of a cursor hands over: the batches not yet read, and the messages
+struct ResultCursor::Stream : ResultSink {
+    static constexpr size_t kMaxQueued = 4; //batches the command thread may run ahead
+
+    struct Batch {
+        bool header = false;
+        std::vector<char> text;
+    };
+
+    void header(std::string_view line) override { push(true, line); }
+    void rows(std::string_view lines) override { push(false, lines); }
+
+    void message(std::string_view text) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        messages.append(text);
+    }
+
+    //waits for room in the queue; once the cursor is gone the commands run on without output
+    void push(bool header, std::string_view text) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [&] { return cancelled || queue.size() < kMaxQueued; });
+        if (cancelled) return;
+        queue.push_back({header, std::vector<char>(text.begin(), text.end())});
+        changed.notify_all();
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Batch> queue;
+    std::string messages;
+    bool done = false;
+    bool cancelled = false;
+    std::thread thread;
+};
+
+ResultCursor::ResultCursor(std::unique_ptr<Stream> stream) : stream(std::move(stream)) {}
+
+ResultCursor::ResultCursor(ResultCursor&&) noexcept = default;
+
+ResultCursor& ResultCursor::operator=(ResultCursor&& other) noexcept {
+    if (this == &other) return *this;
+    close();
+    stream = std::move(other.stream);
+    newResult = other.newResult;
+    columnNames = std::move(other.columnNames);
+    text = std::move(other.text);
+    values = std::move(other.values);
+    rowStarts = std::move(other.rowStarts);
+    return *this;
+}
+
+ResultCursor::~ResultCursor() {
+    close();
+}
+
+//stops handing out batches and waits for the command thread
+void ResultCursor::close() {
+    if (!stream) return;
+    {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->cancelled = true;
+        stream->queue.clear();
+    }
+    stream->changed.notify_all();
+    stream->thread.join();
+    stream.reset();
+}
+
+bool ResultCursor::next() {
+    values.clear();
+    rowStarts.clear();
+    newResult = false;
+    if (!stream) return false;
+
+    Stream::Batch batch;
+    {
+        std::unique_lock<std::mutex> lock(stream->mutex);
+        stream->changed.wait(lock, [&] { return stream->done || !stream->queue.empty(); });
+        if (stream->queue.empty()) return false;
+        batch = std::move(stream->queue.front());
+        stream->queue.pop_front();
+    }
+    stream->changed.notify_all();
+
+    text = std::move(batch.text);
+    std::string_view lines(text.data(), text.size());
+    if (batch.header) {
+        newResult = true;
+        splitRow(lines, columnNames);
+        return true;
+    }
+
+    //the values of every row are views into the batch's text
+    std::vector<std::string_view> fields;
+    rowStarts.push_back(0);
+    while (!lines.empty()) {
+        size_t newline = lines.find('\n');
+        splitRow(lines.substr(0, newline), fields);
+        lines.remove_prefix(newline == std::string_view::npos ? lines.size() : newline + 1);
+        values.insert(values.end(), fields.begin(), fields.end());
+        rowStarts.push_back(values.size());
+    }
+    return true;
+}
+
+std::string ResultCursor::messages() const {
+    if (!stream) return "";
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    return stream->messages;
+}
+
+std::string ResultCursor::error() const {
+    std::string text = messages();
+    for (size_t pos = 0; pos < text.size();) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos) end = text.size();
+        if (text.compare(pos, 6, "Error:") == 0) return text.substr(pos, end - pos);
+        pos = end + 1;
+    }
+    return "";
+}
+
+void Connection::execute(const std::string& sql, ResultSink& sink) {
+    runCommands(sql, sink);
+}
+
+ResultCursor Connection::query(const std::string& sql) {
+    auto stream = std::make_unique<ResultCursor::Stream>();
+    ResultCursor::Stream* shared = stream.get();
+    shared->thread = std::thread([shared, sql] {
+        try {
+            runCommands(sql, *shared);
+        } catch (const std::exception& e) {
+            shared->message("Error: " + std::string(e.what()) + "\n");
+        }
+        {
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            shared->done = true;
+        }
+        shared->changed.notify_all();
+    });
+    return ResultCursor(std::move(stream));
+}
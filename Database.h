@@ -0,0 +1,109 @@
+#ifndef DATABASE_H
+#define DATABASE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "IDimDatabase.h"
+
+//embedding API. a program links the engine and runs commands through a Connection instead of
+//starting sql_database and parsing what it prints:
+//
+//  Database db;
+//  Connection connection = db.connect();
+//  ResultCursor cursor = connection.query("SELECT name, gpa FROM students WHERE gpa > 3.5");
+//  while (cursor.next()) {
+//      for (size_t i = 0; i < cursor.size(); ++i) use(cursor.row(i)[0], cursor.row(i)[1]);
+//  }
+//  if (!cursor.error().empty()) ...
+
+class Connection;
+
+//the tables in the database/ directory under the working directory, as with sql_database
+class Database {
+public:
+    //the engine settings are process-wide; opening a database replaces them
+    explicit Database(const Settings& options = Settings());
+
+    Connection connect();
+};
+
+//one row of a result: views of its values in the table format, so a value stored with quotes keeps
+//them (see decodeValue in ResultWriter.h). valid until the cursor moves to its next batch
+class RowView {
+public:
+    RowView(const std::string_view* values, size_t count) : values(values), count(count) {}
+
+    size_t size() const { return count; }
+    //values missing at the end of a short row read as empty
+    std::string_view operator[](size_t i) const { return i < count ? values[i] : std::string_view(); }
+    const std::string_view* begin() const { return values; }
+    const std::string_view* end() const { return values + count; }
+
+private:
+    const std::string_view* values;
+    size_t count;
+};
+
+//streams the results of the commands given to Connection::query, batch by batch. the commands run
+//on a thread of their own that stays a few batches ahead of the reader. every result starts with a
+//batch that holds only its column names; the batches after it hold its rows, thousands at a time.
+//a query holds the tables for reading until its cursor is done or destroyed, so finish with (or
+//destroy) a cursor before writing to the tables from the same thread.
+class ResultCursor {
+public:
+    ResultCursor(ResultCursor&&) noexcept;
+    ResultCursor& operator=(ResultCursor&&) noexcept;
+    //waits for the commands to finish; the rest of the output is discarded
+    ~ResultCursor();
+
+    //moves to the next batch, false once every command has finished
+    bool next();
+
+    //true for the batch that starts a result
+    bool startsResult() const { return newResult; }
+    //column names of the result the batch belongs to
+    const std::vector<std::string>& columns() const { return columnNames; }
+
+    size_t size() const { return rowStarts.empty() ? 0 : rowStarts.size() - 1; }
+    RowView row(size_t i) const { return {values.data() + rowStarts[i], rowStarts[i + 1] - rowStarts[i]}; }
+
+    //everything the commands printed other than results (confirmations, errors), so far
+    std::string messages() const;
+    //the first error the commands reported, empty if none
+    std::string error() const;
+
+private:
+    friend class Connection;
+    struct Stream;
+
+    explicit ResultCursor(std::unique_ptr<Stream> stream);
+    void close();
+
+    std::unique_ptr<Stream> stream;
+    bool newResult = false;
+    std::vector<std::string> columnNames;
+    std::vector<char> text; //the lines of the current batch
+    std::vector<std::string_view> values;
+    std::vector<size_t> rowStarts; //row i holds values[rowStarts[i], rowStarts[i + 1])
+};
+
+//runs commands against a Database. prepared statements are shared by every connection
+class Connection {
+public:
+    //runs one or more ';'-separated commands on the calling thread, sending their results and
+    //messages to sink as they are produced
+    void execute(const std::string& sql, ResultSink& sink);
+
+    //runs one or more ';'-separated commands and streams their results
+    ResultCursor query(const std::string& sql);
+
+private:
+    friend class Database;
+    Connection() = default;
+};
+
+#endif
@@ -0,0 +1,145 @@
+#include "DeletionMap.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char kMagic[8] = {'I', 'D', 'I', 'M', 'D', 'E', 'L', '1'};
+
+//file layout: magic, u64 inode of the table file, then one record per deleted row in the order the
+//rows were deleted: u64 offset, u64 bytes. the file is only appended to until the table is rewritten
+const size_t kHeaderSize = sizeof(kMagic) + 8;
+const size_t kRecordSize = 8 + 8;
+
+std::string deletionPath(const std::string& tableName) {
+    return "database/" + tableName + ".deleted";
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T get(const char*& p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+}
+
+//identity of the table file, 0 if it has none
+std::uint64_t tableFileId(const std::string& tableName) {
+    struct stat st;
+    if (::stat(("database/" + tableName + ".txt").c_str(), &st) != 0) return 0;
+    return st.st_ino;
+}
+
+//whether a deletion file starts with a header for the table file with identity fileId
+bool headerMatches(const char* data, size_t size, std::uint64_t fileId) {
+    if (size < kHeaderSize || std::memcmp(data, kMagic, sizeof(kMagic)) != 0) return false;
+    const char* p = data + sizeof(kMagic);
+    return get<std::uint64_t>(p) == fileId;
+}
+
+bool writeAll(int fd, const std::string& data) {
+    for (size_t done = 0; done < data.size();) {
+        ssize_t written = ::write(fd, data.data() + done, data.size() - done);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        done += written;
+    }
+    return true;
+}
+
+} // namespace
+
+void DeletionMap::load(const std::string& tableName, std::uint64_t fileId, std::uint64_t count) {
+    offsets.clear();
+    dead = 0;
+    std::ifstream file(deletionPath(tableName), std::ios::binary);
+    if (!file) return;
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!headerMatches(data.data(), data.size(), fileId)) return;
+
+    //a tombstone still being written is past count, or cut short
+    std::uint64_t records = std::min<std::uint64_t>(count, (data.size() - kHeaderSize) / kRecordSize);
+    offsets.reserve(records);
+    const char* p = data.data() + kHeaderSize;
+    for (std::uint64_t i = 0; i < records; ++i) {
+        offsets.push_back(get<std::uint64_t>(p));
+        dead += get<std::uint64_t>(p);
+    }
+    std::sort(offsets.begin(), offsets.end());
+}
+
+bool DeletionMap::contains(std::uint64_t offset) const {
+    return std::binary_search(offsets.begin(), offsets.end(), offset);
+}
+
+bool DeletionMap::contains(std::uint64_t offset, size_t& cursor) const {
+    //rows between two deleted rows cost one comparison each
+    if (cursor < offsets.size() && offsets[cursor] < offset) {
+        cursor = std::lower_bound(offsets.begin() + cursor, offsets.end(), offset) - offsets.begin();
+    }
+    return cursor < offsets.size() && offsets[cursor] == offset;
+}
+
+bool appendTombstones(const std::string& tableName, const std::vector<Tombstone>& tombstones, bool sync) {
+    if (tombstones.empty()) return true;
+    std::string path = deletionPath(tableName);
+    int fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0666);
+    if (fd < 0) return false;
+
+    //a new file starts with the identity of the table file
+    std::string data;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size == 0) {
+        data.append(kMagic, sizeof(kMagic));
+        put<std::uint64_t>(data, tableFileId(tableName));
+        std::error_code ec;
+        fs::permissions(path, fs::perms::owner_all | fs::perms::group_all | fs::perms::others_all,
+                        fs::perm_options::replace, ec);
+    }
+    for (const auto& tombstone : tombstones) {
+        put<std::uint64_t>(data, tombstone.offset);
+        put<std::uint64_t>(data, tombstone.bytes);
+    }
+    bool ok = writeAll(fd, data) && (!sync || ::fdatasync(fd) == 0);
+    ::close(fd);
+    return ok;
+}
+
+std::uint64_t trimTombstones(const std::string& tableName, std::uint64_t count) {
+    std::string path = deletionPath(tableName);
+    std::error_code ec;
+    std::uint64_t size = fs::file_size(path, ec);
+    if (ec) return 0;
+
+    char header[kHeaderSize];
+    std::ifstream file(path, std::ios::binary);
+    if (!file.read(header, kHeaderSize) || !headerMatches(header, kHeaderSize, tableFileId(tableName))) {
+        file.close();
+        fs::remove(path, ec);
+        return 0;
+    }
+    std::uint64_t kept = std::min<std::uint64_t>(count, (size - kHeaderSize) / kRecordSize);
+    if (size != kHeaderSize + kept * kRecordSize) fs::resize_file(path, kHeaderSize + kept * kRecordSize, ec);
+    return kept;
+}
+
+void dropTombstones(const std::string& tableName) {
+    std::error_code ec;
+    fs::remove(deletionPath(tableName), ec);
+}
@@ -0,0 +1,54 @@
+#ifndef DELETION_MAP_H
+#define DELETION_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//a deleted row: the bytes [offset, offset + bytes) of the table file, its line and newline
+struct Tombstone {
+    std::uint64_t offset = 0;
+    std::uint64_t bytes = 0;
+};
+
+//the deleted rows of a text table. DELETE and UPDATE leave the rows in the table file and append a
+//tombstone for each to database/<table>.deleted; scans pass over the rows it names until VACUUM
+//rewrites the table without them. the file starts with the identity (inode) of the table file its
+//tombstones refer to, so the tombstones of a table file that was replaced never apply to the new one.
+//in memory the tombstones are kept as the sorted offsets of the deleted rows.
+class DeletionMap {
+public:
+    //loads the first count tombstones of a table whose file has identity fileId; there are none if
+    //the table has no deletion file or it belongs to another table file
+    void load(const std::string& tableName, std::uint64_t fileId, std::uint64_t count = UINT64_MAX);
+
+    bool empty() const { return offsets.empty(); }
+    size_t size() const { return offsets.size(); }
+
+    //bytes of the table file the deleted rows take up
+    std::uint64_t deadBytes() const { return dead; }
+
+    //whether the row starting at offset is deleted
+    bool contains(std::uint64_t offset) const;
+
+    //the same for rows visited in ascending order of offset: cursor starts at 0 and is passed to each call
+    bool contains(std::uint64_t offset, size_t& cursor) const;
+
+private:
+    std::vector<std::uint64_t> offsets;
+    std::uint64_t dead = 0;
+};
+
+//appends tombstones to the deletion file of a table, made durable with fdatasync if sync is set.
+//called by the table's writer, under its AppendLock
+bool appendTombstones(const std::string& tableName, const std::vector<Tombstone>& tombstones, bool sync);
+
+//cuts the deletion file of a table back to its first count tombstones and removes one that belongs
+//to another table file; returns the number of tombstones kept. used when a writer takes the lock
+std::uint64_t trimTombstones(const std::string& tableName, std::uint64_t count);
+
+//removes the deletion file of a table, once the table file holds no deleted rows
+void dropTombstones(const std::string& tableName);
+
+#endif
@@ -0,0 +1,312 @@
+#include "ExternalSort.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <random>
+
+#include "Predicate.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char kNumberTag = 0x01;
+constexpr char kTextTag = 0x02;
+constexpr std::size_t kMaxFanIn = 64;    //runs merged at once
+constexpr std::size_t kFileBuffer = 1u << 20;
+
+void appendBigEndian(std::string& out, std::uint64_t value) {
+    for (int shift = 56; shift >= 0; shift -= 8) out.push_back(static_cast<char>(value >> shift));
+}
+
+//bits of a double whose unsigned order matches numeric order
+std::uint64_t orderedBits(double value) {
+    if (value == 0) value = 0; //fold -0 into +0
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits >> 63) ? ~bits : bits | (1ull << 63);
+}
+
+//a cell's number for sorting; false sorts it with the text values
+bool sortNumber(ValueType type, std::string_view cell, double& number) {
+    if (type == ValueType::Text) return false;
+    if (type == ValueType::Double) {
+        auto parsed = std::from_chars(cell.data(), cell.data() + cell.size(), number);
+        return !cell.empty() && parsed.ec == std::errc() && parsed.ptr == cell.data() + cell.size();
+    }
+    return parseLikeStod(cell, number) && !std::isnan(number);
+}
+
+void appendLength(std::string& out, std::size_t length) {
+    auto value = static_cast<std::uint32_t>(length);
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool readLength(std::string_view& in, std::size_t& length) {
+    std::uint32_t value;
+    if (in.size() < sizeof(value)) return false;
+    std::memcpy(&value, in.data(), sizeof(value));
+    in.remove_prefix(sizeof(value));
+    length = value;
+    return length <= in.size();
+}
+
+void writeString(std::ofstream& out, std::string_view value) {
+    auto length = static_cast<std::uint32_t>(value.size());
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(value.data(), value.size());
+}
+
+bool readString(std::ifstream& in, std::string& value) {
+    std::uint32_t length;
+    if (!in.read(reinterpret_cast<char*>(&length), sizeof(length))) return false;
+    value.resize(length);
+    return static_cast<bool>(in.read(&value[0], length));
+}
+
+bool byKey(BufferedRow a, BufferedRow b) {
+    return a[0] < b[0];
+}
+
+//bytes a (key, line) row takes in its batch
+std::size_t recordBytes(BufferedRow row) {
+    return 12 + row[0].size() + row[1].size();
+}
+
+} // namespace
+
+void appendSortKey(std::string& key, ValueType type, std::string_view cell, bool descending) {
+    size_t start = key.size();
+    double number;
+    std::int64_t integer;
+    auto parsedInt = std::from_chars(cell.data(), cell.data() + cell.size(), integer);
+    if (type == ValueType::Int && !cell.empty() && parsedInt.ec == std::errc() &&
+        parsedInt.ptr == cell.data() + cell.size()) {
+        //integers keep their full 64 bits of precision
+        key.push_back(kNumberTag);
+        appendBigEndian(key, static_cast<std::uint64_t>(integer) ^ (1ull << 63));
+    } else if (type != ValueType::Int && sortNumber(type, cell, number)) {
+        key.push_back(kNumberTag);
+        appendBigEndian(key, orderedBits(number));
+    } else {
+        //zero bytes are escaped so the 0x00 0x00 terminator sorts shorter values first
+        key.push_back(kTextTag);
+        for (char c : cell) {
+            key.push_back(c);
+            if (c == '\0') key.push_back('\xff');
+        }
+        key.push_back('\0');
+        key.push_back('\0');
+    }
+    if (descending) {
+        for (size_t i = start; i < key.size(); ++i) key[i] = static_cast<char>(~key[i]);
+    }
+}
+
+void appendSortRecord(std::string& out, std::string_view key, std::string_view line) {
+    appendLength(out, key.size());
+    out.append(key);
+    appendLength(out, line.size());
+    out.append(line);
+}
+
+//sequential reader over the records of a spilled run
+class RowSorter::RunReader {
+public:
+    explicit RunReader(const std::string& path) : buffer(kFileBuffer) {
+        in.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+        in.open(path, std::ios::binary);
+    }
+
+    bool next() { return readString(in, current.key) && readString(in, current.line); }
+
+    Record current;
+
+private:
+    std::vector<char> buffer;
+    std::ifstream in;
+};
+
+RowSorter::RowSorter(const SortOptions& options, SortEmitter emit)
+    : options(options), emit(std::move(emit)), useHeap(options.limit.has_value()) {
+    std::random_device rd;
+    tag = std::to_string(std::chrono::steady_clock::now().time_since_epoch().count() ^ rd());
+}
+
+RowSorter::~RowSorter() {
+    for (const auto& path : runPaths) {
+        std::error_code ec;
+        fs::remove(path, ec);
+    }
+}
+
+BufferedRow RowSorter::store(std::string_view key, std::string_view line) {
+    BufferedRow row = buffer[buffer.add(std::array<std::string_view, 2>{key, line})];
+    liveBytes += recordBytes(row);
+    return row;
+}
+
+//copies the heap's rows into a new buffer, dropping the rows they replaced
+void RowSorter::compact() {
+    RowBuffer kept;
+    for (auto& row : rows) row = kept[kept.add(row)];
+    buffer = std::move(kept);
+}
+
+void RowSorter::add(std::string_view key, std::string_view line) {
+    if (done()) return;
+    if (!options.keyed) {
+        emitLine(line);
+        return;
+    }
+
+    //the input position makes every key unique, so equal keys keep their input order
+    scratch.assign(key);
+    appendBigEndian(scratch, sequence++);
+
+    if (useHeap && rows.size() == *options.limit) {
+        //full heap: the row replaces the largest kept row if it sorts before it. the replaced
+        //row stays in the buffer until the garbage outgrows the kept rows
+        if (std::string_view(scratch) >= rows.front()[0]) return;
+        std::pop_heap(rows.begin(), rows.end(), byKey);
+        liveBytes -= recordBytes(rows.back());
+        rows.back() = store(scratch, line);
+        std::push_heap(rows.begin(), rows.end(), byKey);
+        if (buffer.bytes() > 2 * liveBytes + RowBuffer::kBatchSize) compact();
+        peak = std::max(peak, buffer.bytes() + rows.capacity() * sizeof(BufferedRow));
+        return;
+    }
+
+    rows.push_back(store(scratch, line));
+    peak = std::max(peak, buffer.bytes() + rows.capacity() * sizeof(BufferedRow));
+    if (useHeap) {
+        std::push_heap(rows.begin(), rows.end(), byKey);
+        //the limit is too large to keep in memory: sort externally instead
+        if (held() > options.memoryBudget) useHeap = false;
+    }
+    if (!useHeap && held() > options.memoryBudget) spill();
+}
+
+void RowSorter::addRecords(std::string_view records) {
+    size_t keyLength, lineLength;
+    while (readLength(records, keyLength)) {
+        std::string_view key = records.substr(0, keyLength);
+        records.remove_prefix(keyLength);
+        if (!readLength(records, lineLength)) break;
+        add(key, records.substr(0, lineLength));
+        records.remove_prefix(lineLength);
+    }
+}
+
+bool RowSorter::done() const {
+    if (options.limit && *options.limit == 0) return true;
+    return !options.keyed && options.limit && emitted >= *options.limit;
+}
+
+void RowSorter::spill() {
+    std::sort(rows.begin(), rows.end(), byKey);
+    runs.push_back(writeRun(rows));
+    rows.clear();
+    buffer.clear();
+    liveBytes = 0;
+}
+
+std::string RowSorter::writeRun(const std::vector<BufferedRow>& records) {
+    std::string path = options.spillDir + "/.sort_" + tag + "_" + std::to_string(runPaths.size()) + ".tmp";
+    runPaths.push_back(path);
+
+    std::vector<char> buffer(kFileBuffer);
+    std::ofstream out;
+    out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    out.open(path, std::ios::binary);
+    for (BufferedRow record : records) {
+        writeString(out, record[0]);
+        writeString(out, record[1]);
+    }
+    return path;
+}
+
+//k-way merge of sorted runs, into the output or into a new run that is returned
+std::string RowSorter::mergeRuns(const std::vector<std::string>& paths, bool toOutput) {
+    std::vector<std::unique_ptr<RunReader>> readers;
+    for (const auto& path : paths) {
+        readers.push_back(std::make_unique<RunReader>(path));
+        if (!readers.back()->next()) readers.pop_back();
+    }
+    auto later = [&](size_t a, size_t b) { return readers[a]->current.key > readers[b]->current.key; };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heads(later);
+    for (size_t i = 0; i < readers.size(); ++i) heads.push(i);
+
+    std::vector<char> buffer(kFileBuffer);
+    std::ofstream out;
+    std::string path;
+    if (!toOutput) {
+        path = options.spillDir + "/.sort_" + tag + "_" + std::to_string(runPaths.size()) + ".tmp";
+        runPaths.push_back(path);
+        out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+        out.open(path, std::ios::binary);
+    }
+
+    while (!heads.empty()) {
+        size_t head = heads.top();
+        heads.pop();
+        const Record& record = readers[head]->current;
+        if (toOutput) {
+            if (options.limit && emitted >= *options.limit) break;
+            emitLine(record.line);
+        } else {
+            writeString(out, record.key);
+            writeString(out, record.line);
+        }
+        if (readers[head]->next()) heads.push(head);
+    }
+    return path;
+}
+
+void RowSorter::emitLine(std::string_view line) {
+    if (options.limit && emitted >= *options.limit) return;
+    ++emitted;
+    text.append(line);
+    text.push_back('\n');
+    if (text.size() >= 64 * 1024) flush();
+}
+
+void RowSorter::flush() {
+    if (text.empty()) return;
+    emit(text);
+    text.clear();
+}
+
+void RowSorter::finish() {
+    if (options.keyed && runs.empty()) {
+        //everything fit in memory
+        if (useHeap) std::sort_heap(rows.begin(), rows.end(), byKey);
+        else std::sort(rows.begin(), rows.end(), byKey);
+        for (BufferedRow record : rows) emitLine(record[1]);
+        rows.clear();
+        buffer.clear();
+    } else if (options.keyed) {
+        if (!rows.empty()) spill();
+        //merge in passes of at most kMaxFanIn runs so the number of open files stays bounded
+        while (runs.size() > kMaxFanIn) {
+            std::vector<std::string> group(runs.begin(), runs.begin() + kMaxFanIn);
+            runs.erase(runs.begin(), runs.begin() + kMaxFanIn);
+            runs.push_back(mergeRuns(group, false));
+            for (const auto& merged : group) {
+                std::error_code ec;
+                fs::remove(merged, ec);
+            }
+        }
+        mergeRuns(runs, true);
+        runs.clear();
+    }
+    flush();
+}
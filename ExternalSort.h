@@ -0,0 +1,99 @@
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "RowBatch.h"
+#include "Schema.h"
+
+//appends one ORDER BY value to a sort key, so that whole keys compare bytewise in ORDER BY order.
+//numbers sort numerically ahead of other values, which sort bytewise (the order index keys use);
+//TEXT columns sort bytewise throughout. descending inverts the value's bytes.
+void appendSortKey(std::string& key, ValueType type, std::string_view cell, bool descending);
+
+//appends a (key, line) pair to out in the form RowSorter::addRecords reads, so scan threads can
+//hand sorted rows to the calling thread as one string
+void appendSortRecord(std::string& out, std::string_view key, std::string_view line);
+
+struct SortOptions {
+    std::size_t memoryBudget = 256u << 20; //bytes of rows held in memory before a run is spilled
+    std::string spillDir = "database";     //where sorted runs are written
+    std::optional<std::uint64_t> limit;    //print at most this many rows
+    bool keyed = true;                     //false keeps rows in input order (LIMIT without ORDER BY)
+};
+
+//receives the sorted output text, one or more complete lines at a time
+using SortEmitter = std::function<void(const std::string& text)>;
+
+//orders output lines by their keys, rows with equal keys in input order.
+//with a limit the smallest rows are kept in a bounded max-heap (O(n log k)) for as long as the
+//heap fits the memory budget. otherwise rows are buffered up to the budget, sorted and spilled
+//as runs that are merged at the end (external merge sort), so the input may exceed memory.
+//rows held in memory are (key, line) rows of a RowBuffer.
+class RowSorter {
+public:
+    RowSorter(const SortOptions& options, SortEmitter emit);
+    RowSorter(const RowSorter&) = delete;
+    RowSorter& operator=(const RowSorter&) = delete;
+    ~RowSorter();
+
+    //adds one output line (without its newline) under a key built with appendSortKey
+    void add(std::string_view key, std::string_view line);
+
+    //adds every record appended to a string with appendSortRecord
+    void addRecords(std::string_view records);
+
+    //true once further rows cannot change the output (a reached limit without ORDER BY)
+    bool done() const;
+
+    //emits the sorted lines; call once after the last row
+    void finish();
+
+    //how the rows were ordered, for EXPLAIN ANALYZE
+    bool keptInHeap() const { return useHeap; }
+    std::size_t runsWritten() const { return runPaths.size(); }
+    std::uint64_t rowsEmitted() const { return emitted; }
+    std::size_t peakBytes() const { return peak; }
+
+private:
+    struct Record {
+        std::string key; //sort key followed by the row's input position, so keys are unique
+        std::string line;
+    };
+
+    class RunReader;
+
+    BufferedRow store(std::string_view key, std::string_view line);
+    void compact();
+    void spill();
+    std::string writeRun(const std::vector<BufferedRow>& records);
+    std::string mergeRuns(const std::vector<std::string>& paths, bool toOutput);
+    void emitLine(std::string_view line);
+    void flush();
+    std::size_t held() const { return liveBytes + rows.capacity() * sizeof(BufferedRow); }
+
+    SortOptions options;
+    SortEmitter emit;
+
+    std::uint64_t sequence = 0;
+    std::string scratch;
+    std::uint64_t emitted = 0;
+    std::string text;
+
+    bool useHeap;
+    RowBuffer buffer;              //the (key, line) rows kept in memory
+    std::vector<BufferedRow> rows; //heap (max at front) or the unsorted rows of the current run
+    std::size_t liveBytes = 0;     //bytes of the rows still in rows, what the memory budget limits
+    std::size_t peak = 0;          //most memory the buffer and rows held, including replaced rows
+
+    std::string tag;
+    std::vector<std::string> runPaths; //every run written, removed when the sorter is destroyed
+    std::vector<std::string> runs;     //runs waiting to be merged
+};
+
+#endif
@@ -0,0 +1,595 @@
+#include "HashJoin.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <string_view>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::size_t kMaxPartitions = 64;
+const int kMaxDepth = 3;
+const std::size_t kEntryBytes = 48;         //rough size of a row's hash table entry
+const std::size_t kMaxFanIn = 64;           //spilled runs merged at once
+const std::size_t kMinRunBytes = 64u << 10; //least a spilled run holds, so a tiny budget does not
+                                            //write a file per row
+
+//a side of the join held in memory, with each row's position in its original input
+struct OrdRows {
+    RowBuffer rows;
+    std::vector<std::uint64_t> ords;
+};
+
+//pulls the next (ordinal, row) pair of an input
+using OrdReader = std::function<bool(std::uint64_t&, Row&)>;
+
+//receives matches ordered by left ordinal, then right ordinal
+using OrderedEmitter = std::function<void(std::uint64_t, BufferedRow, std::uint64_t, BufferedRow)>;
+
+//memory a build side holds, with the hash table entries its rows will need
+std::size_t footprint(const OrdRows& rows) {
+    return rows.rows.bytes() + rows.ords.capacity() * sizeof(std::uint64_t) + rows.rows.size() * kEntryBytes;
+}
+
+//size of the row as it appears in the csv file
+std::size_t rowTextSize(const Row& row) {
+    std::size_t bytes = row.size();
+    for (const auto& cell : row) bytes += cell.size();
+    return bytes;
+}
+
+//splitmix64 finalizer, seeded so every recursion level partitions differently
+std::uint64_t mixHash(std::uint64_t h, std::uint64_t seed) {
+    h ^= seed * 0x9e3779b97f4a7c15ULL;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+//spill record: u64 ordinal, u32 cell count, then u32 length + bytes for each cell
+template <typename Values>
+void writeRow(std::ofstream& out, std::uint64_t ord, const Values& row) {
+    std::uint32_t cells = row.size();
+    out.write(reinterpret_cast<const char*>(&ord), sizeof(ord));
+    out.write(reinterpret_cast<const char*>(&cells), sizeof(cells));
+    for (size_t i = 0; i < row.size(); ++i) {
+        std::string_view cell = row[i];
+        std::uint32_t len = cell.size();
+        out.write(reinterpret_cast<const char*>(&len), sizeof(len));
+        out.write(cell.data(), len);
+    }
+}
+
+bool readRow(std::ifstream& in, std::uint64_t& ord, Row& row) {
+    std::uint32_t cells = 0;
+    if (!in.read(reinterpret_cast<char*>(&ord), sizeof(ord))) return false;
+    if (!in.read(reinterpret_cast<char*>(&cells), sizeof(cells))) return false;
+    row.resize(cells);
+    for (auto& cell : row) {
+        std::uint32_t len = 0;
+        in.read(reinterpret_cast<char*>(&len), sizeof(len));
+        cell.resize(len);
+        in.read(cell.data(), len);
+    }
+    return static_cast<bool>(in);
+}
+
+//compares the cells [begin, end) of two rows bytewise, a missing cell as empty
+template <typename RowA, typename RowB>
+bool keyLess(const RowA& a, const RowB& b, std::size_t begin, std::size_t end) {
+    for (std::size_t i = begin; i < end; ++i) {
+        std::string_view x = i < a.size() ? std::string_view(a[i]) : std::string_view();
+        std::string_view y = i < b.size() ? std::string_view(b[i]) : std::string_view();
+        if (x != y) return x < y;
+    }
+    return false;
+}
+
+//temp files of one join, named uniquely and removed when the join is done
+class SpillFiles {
+public:
+    explicit SpillFiles(const std::string& dir) : dir(dir) {}
+
+    ~SpillFiles() {
+        for (const auto& path : paths) {
+            std::error_code ec;
+            fs::remove(path, ec);
+        }
+    }
+
+    std::string newPath(const std::string& side) {
+        if (tag.empty()) {
+            std::random_device rd;
+            tag = std::to_string(std::chrono::steady_clock::now().time_since_epoch().count() ^ rd());
+        }
+        paths.push_back(dir + "/.join_" + tag + "_" + side + std::to_string(paths.size()) + ".tmp");
+        return paths.back();
+    }
+
+private:
+    std::string dir;
+    std::string tag;
+    std::vector<std::string> paths;
+};
+
+//k-way merge of pair files written as (left ord, left row, right ord, right row) records, each
+//already sorted by (left, right) ordinal
+void mergeRuns(const std::vector<std::string>& paths, const OrderedEmitter& emit) {
+    struct Cursor {
+        std::ifstream in;
+        std::uint64_t ord1 = 0, ord2 = 0;
+        Row left, right;
+        bool next() { return readRow(in, ord1, left) && readRow(in, ord2, right); }
+    };
+    std::vector<std::unique_ptr<Cursor>> cursors;
+    for (const auto& path : paths) {
+        auto cursor = std::make_unique<Cursor>();
+        cursor->in.open(path, std::ios::binary);
+        if (cursor->next()) cursors.push_back(std::move(cursor));
+    }
+
+    auto later = [&](std::size_t a, std::size_t b) {
+        if (cursors[a]->ord1 != cursors[b]->ord1) return cursors[a]->ord1 > cursors[b]->ord1;
+        return cursors[a]->ord2 > cursors[b]->ord2;
+    };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(later)> heap(later);
+    for (std::size_t i = 0; i < cursors.size(); ++i) heap.push(i);
+
+    RowBuffer pair;
+    while (!heap.empty()) {
+        auto i = heap.top();
+        heap.pop();
+        pair.clear();
+        pair.add(cursors[i]->left);
+        pair.add(cursors[i]->right);
+        emit(cursors[i]->ord1, pair[0], cursors[i]->ord2, pair[1]);
+        if (cursors[i]->next()) heap.push(i);
+    }
+}
+
+//joins an in-memory build side against a streamed probe side.
+//build rows must be in ordinal order, and so must the probe stream. peak is raised to the most
+//memory the rows held. when the probe side is the right one and the matches kept for reordering
+//outgrow budget, they are written to spill files as sorted runs and merged at the end
+void joinInMemory(const OrdRows& build, std::size_t buildKey, bool buildIsLeft, bool ordered,
+                  const OrdReader& probe, std::size_t probeKey, const OrderedEmitter& emit, std::size_t& peak,
+                  std::size_t budget, SpillFiles& spills) {
+    std::unordered_map<std::string_view, std::vector<std::uint32_t>> table;
+    table.reserve(build.rows.size());
+    for (std::size_t i = 0; i < build.rows.size(); ++i) {
+        table[build.rows[i][buildKey]].push_back(i);
+    }
+
+    std::uint64_t ord = 0;
+    Row row;
+    if (!buildIsLeft || !ordered) {
+        //probing with the left side in order already gives nested-loop order
+        RowBuffer probeRow;
+        while (probe(ord, row)) {
+            if (probeKey >= row.size()) continue;
+            auto it = table.find(row[probeKey]);
+            if (it == table.end()) continue;
+            probeRow.clear();
+            probeRow.add(row);
+            for (auto idx : it->second) {
+                if (buildIsLeft) emit(build.ords[idx], build.rows[idx], ord, probeRow[0]);
+                else emit(ord, probeRow[0], build.ords[idx], build.rows[idx]);
+            }
+        }
+        peak = std::max(peak, footprint(build));
+        return;
+    }
+
+    //probing with the right side: keep the matched right rows and reorder by left row
+    RowBuffer matchedRows;
+    std::vector<std::uint64_t> matchedOrds;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> pairs;
+    std::vector<std::string> runs;
+    auto matched = [&] {
+        return matchedRows.bytes() + matchedOrds.capacity() * sizeof(std::uint64_t) + pairs.capacity() * sizeof(pairs[0]);
+    };
+    //the matches get what the build side left of the budget, but at least a quarter of it and
+    //kMinRunBytes, so neither a build side that filled the budget nor a tiny budget spills every row
+    std::size_t buildBytes = footprint(build);
+    std::size_t matchBudget = std::max({budget > buildBytes ? budget - buildBytes : 0, budget / 4, kMinRunBytes});
+    //sorts the buffered matches by build row and passes them on, to emit or to a new run file
+    auto flush = [&](const OrderedEmitter& out) {
+        peak = std::max(peak, buildBytes + matched());
+        std::stable_sort(pairs.begin(), pairs.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (const auto& [buildIdx, probeIdx] : pairs) {
+            out(build.ords[buildIdx], build.rows[buildIdx], matchedOrds[probeIdx], matchedRows[probeIdx]);
+        }
+        //release the buffers rather than clear them, so the next run starts small again
+        matchedRows = RowBuffer();
+        matchedOrds = std::vector<std::uint64_t>();
+        pairs = std::vector<std::pair<std::uint32_t, std::uint32_t>>();
+    };
+    auto spill = [&] {
+        runs.push_back(spills.newPath("M"));
+        std::ofstream run(runs.back(), std::ios::binary);
+        flush([&](std::uint64_t o1, BufferedRow r1, std::uint64_t o2, BufferedRow r2) {
+            writeRow(run, o1, r1);
+            writeRow(run, o2, r2);
+        });
+    };
+    while (probe(ord, row)) {
+        if (probeKey >= row.size()) continue;
+        auto it = table.find(row[probeKey]);
+        if (it == table.end()) continue;
+        std::uint32_t probeIdx = matchedRows.add(row);
+        for (auto idx : it->second) pairs.emplace_back(idx, probeIdx);
+        matchedOrds.push_back(ord);
+        if (matched() > matchBudget) spill();
+    }
+    if (runs.empty()) {
+        flush(emit);
+        return;
+    }
+    if (!pairs.empty()) spill();
+
+    //merge in passes of at most kMaxFanIn runs so the number of open files stays bounded
+    while (runs.size() > kMaxFanIn) {
+        std::vector<std::string> group(runs.begin(), runs.begin() + kMaxFanIn);
+        runs.erase(runs.begin(), runs.begin() + kMaxFanIn);
+        runs.push_back(spills.newPath("M"));
+        std::ofstream merged(runs.back(), std::ios::binary);
+        mergeRuns(group, [&](std::uint64_t o1, BufferedRow r1, std::uint64_t o2, BufferedRow r2) {
+            writeRow(merged, o1, r1);
+            writeRow(merged, o2, r2);
+        });
+        for (const auto& path : group) {
+            std::error_code ec;
+            fs::resize_file(path, 0, ec); //merged run is no longer needed
+        }
+    }
+    mergeRuns(runs, emit);
+}
+
+//partitioned hash join over spill files, used when the build side exceeds the budget
+class GraceJoin {
+public:
+    GraceJoin(const JoinOptions& options, std::size_t leftKey, std::size_t rightKey)
+        : options(options), leftKey(leftKey), rightKey(rightKey), spills(options.spillDir) {}
+
+    //scatters rows into spill files by the hash of their key column
+    class Partitioner {
+    public:
+        Partitioner(GraceJoin& join, const std::string& side, std::size_t partitions,
+                    std::size_t keyIndex, std::uint64_t seed)
+            : keyIndex(keyIndex), seed(seed) {
+            for (std::size_t p = 0; p < partitions; ++p) {
+                paths.push_back(join.spills.newPath(side));
+                files.push_back(std::make_unique<std::ofstream>(paths.back(), std::ios::binary));
+            }
+        }
+
+        template <typename Values>
+        void add(std::uint64_t ord, const Values& row) {
+            auto h = mixHash(std::hash<std::string_view>{}(row[keyIndex]), seed);
+            writeRow(*files[h % files.size()], ord, row);
+        }
+
+        std::vector<std::string> finish() {
+            files.clear();
+            return paths;
+        }
+
+    private:
+        std::size_t keyIndex;
+        std::uint64_t seed;
+        std::vector<std::string> paths;
+        std::vector<std::unique_ptr<std::ofstream>> files;
+    };
+
+    std::size_t partitionCount(std::size_t estimatedBytes) const {
+        std::size_t target = std::max<std::size_t>(options.memoryBudget / 2, 1);
+        return std::clamp<std::size_t>(estimatedBytes / target + 1, 2, kMaxPartitions);
+    }
+
+    //joins one left/right partition pair, recursing with a new seed if it is still too large. the
+    //pairs are written to a result file for mergeResults, or emitted at once when unordered
+    void joinFiles(const std::string& leftPath, const std::string& rightPath, int depth, const JoinEmitter& emit) {
+        auto leftSize = fs::file_size(leftPath), rightSize = fs::file_size(rightPath);
+        if (leftSize == 0 || rightSize == 0) return;
+
+        bool buildIsLeft = leftSize < rightSize;
+        std::size_t buildKey = buildIsLeft ? leftKey : rightKey;
+        std::size_t probeKey = buildIsLeft ? rightKey : leftKey;
+        std::ifstream buildIn(buildIsLeft ? leftPath : rightPath, std::ios::binary);
+
+        OrdRows built;
+        std::size_t used = 0;
+        std::uint64_t ord = 0;
+        Row row;
+        while (readRow(buildIn, ord, row)) {
+            built.rows.add(row);
+            built.ords.push_back(ord);
+            used = footprint(built);
+            if (used > options.memoryBudget && depth < kMaxDepth) break;
+        }
+        peak = std::max(peak, used);
+
+        if (used > options.memoryBudget && depth < kMaxDepth) {
+            //still too big: split this pair again with a different hash seed
+            auto estimate = used * std::max<std::uintmax_t>(1, (buildIsLeft ? leftSize : rightSize) /
+                                                               std::max<std::uintmax_t>(1, buildIn.tellg()));
+            std::size_t partitions = partitionCount(estimate);
+            built = OrdRows();
+            auto leftParts = repartition(leftPath, "L", partitions, leftKey, depth + 1);
+            auto rightParts = repartition(rightPath, "R", partitions, rightKey, depth + 1);
+            for (std::size_t p = 0; p < partitions; ++p) joinFiles(leftParts[p], rightParts[p], depth + 1, emit);
+            return;
+        }
+
+        std::ifstream probeIn(buildIsLeft ? rightPath : leftPath, std::ios::binary);
+        OrdReader probe = [&](std::uint64_t& o, Row& r) { return readRow(probeIn, o, r); };
+
+        if (!options.ordered) {
+            joinInMemory(built, buildKey, buildIsLeft, false, probe, probeKey,
+                         [&](std::uint64_t, BufferedRow r1, std::uint64_t, BufferedRow r2) { emit(r1, r2); }, peak,
+                         options.memoryBudget, spills);
+            return;
+        }
+        resultPaths.push_back(spills.newPath("J"));
+        std::ofstream result(resultPaths.back(), std::ios::binary);
+        joinInMemory(built, buildKey, buildIsLeft, true, probe, probeKey,
+                     [&](std::uint64_t o1, BufferedRow r1, std::uint64_t o2, BufferedRow r2) {
+                         writeRow(result, o1, r1);
+                         writeRow(result, o2, r2);
+                     }, peak, options.memoryBudget, spills);
+    }
+
+    std::vector<std::string> repartition(const std::string& path, const std::string& side,
+                                         std::size_t partitions, std::size_t keyIndex, std::uint64_t seed) {
+        Partitioner parts(*this, side, partitions, keyIndex, seed);
+        std::ifstream in(path, std::ios::binary);
+        std::uint64_t ord = 0;
+        Row row;
+        while (readRow(in, ord, row)) parts.add(ord, row);
+        in.close();
+        auto paths = parts.finish();
+        std::error_code ec;
+        fs::resize_file(path, 0, ec); //parent partition is no longer needed
+        return paths;
+    }
+
+    //merges the per-partition results, each already sorted by (left, right) ordinal
+    void mergeResults(const JoinEmitter& emit) {
+        mergeRuns(resultPaths, [&](std::uint64_t, BufferedRow l, std::uint64_t, BufferedRow r) { emit(l, r); });
+    }
+
+    const JoinOptions& options;
+    std::size_t leftKey, rightKey;
+    SpillFiles spills;
+    std::vector<std::string> resultPaths;
+    std::size_t peak = 0; //most memory a partition's rows held
+};
+
+} // namespace
+
+void hashJoin(JoinInput& left, JoinInput& right, const JoinOptions& options, const JoinEmitter& emit) {
+    bool buildIsLeft = left.sizeHint < right.sizeHint;
+    JoinInput& build = buildIsLeft ? left : right;
+    JoinInput& probe = buildIsLeft ? right : left;
+    if (options.stats) options.stats->buildIsLeft = buildIsLeft;
+
+    //load the build side until it is exhausted or outgrows the memory budget
+    OrdRows built;
+    std::size_t used = 0, textRead = 0;
+    std::uint64_t buildOrd = 0;
+    bool overflow = false;
+    Row row;
+    while (build.read(row)) {
+        std::uint64_t ord = buildOrd++;
+        if (build.keyIndex >= row.size()) continue;
+        textRead += rowTextSize(row);
+        built.rows.add(row);
+        built.ords.push_back(ord);
+        used = footprint(built);
+        if (used > options.memoryBudget) {
+            overflow = true;
+            break;
+        }
+    }
+
+    std::uint64_t probeOrd = 0;
+    auto nextProbe = [&](std::uint64_t& ord, Row& r) {
+        if (!probe.read(r)) return false;
+        ord = probeOrd++;
+        return true;
+    };
+
+    if (!overflow) {
+        std::size_t peak = 0;
+        SpillFiles spills(options.spillDir);
+        joinInMemory(built, build.keyIndex, buildIsLeft, options.ordered, nextProbe, probe.keyIndex,
+                     [&](std::uint64_t, BufferedRow l, std::uint64_t, BufferedRow r) { emit(l, r); }, peak,
+                     options.memoryBudget, spills);
+        if (options.stats) options.stats->peakBytes = peak;
+        return;
+    }
+
+    //grace mode: partition both sides to disk, join each partition pair, merge the results
+    GraceJoin grace(options, left.keyIndex, right.keyIndex);
+    auto estimate = static_cast<std::size_t>(
+        static_cast<double>(used) * build.sizeHint / std::max<std::size_t>(textRead, 1));
+    std::size_t partitions = grace.partitionCount(estimate);
+    if (options.stats) {
+        options.stats->grace = true;
+        options.stats->partitions = partitions;
+    }
+
+    GraceJoin::Partitioner buildParts(grace, buildIsLeft ? "L" : "R", partitions, build.keyIndex, 0);
+    for (std::size_t i = 0; i < built.rows.size(); ++i) buildParts.add(built.ords[i], built.rows[i]);
+    grace.peak = used;
+    built = OrdRows();
+    while (build.read(row)) {
+        std::uint64_t ord = buildOrd++;
+        if (build.keyIndex < row.size()) buildParts.add(ord, row);
+    }
+
+    GraceJoin::Partitioner probeParts(grace, buildIsLeft ? "R" : "L", partitions, probe.keyIndex, 0);
+    std::uint64_t ord = 0;
+    while (nextProbe(ord, row)) {
+        if (probe.keyIndex < row.size()) probeParts.add(ord, row);
+    }
+
+    auto buildPaths = buildParts.finish();
+    auto probePaths = probeParts.finish();
+    for (std::size_t p = 0; p < partitions; ++p) {
+        grace.joinFiles(buildIsLeft ? buildPaths[p] : probePaths[p],
+                        buildIsLeft ? probePaths[p] : buildPaths[p], 0, emit);
+    }
+    if (options.ordered) grace.mergeResults(emit);
+    if (options.stats) options.stats->peakBytes = grace.peak;
+}
+
+//one run of a spool read back row by row
+class RowSpool::RunReader {
+public:
+    explicit RunReader(const std::string& path) : in(path, std::ios::binary) {}
+
+    bool next() {
+        std::uint64_t ord = 0;
+        return readRow(in, ord, row);
+    }
+
+    Row row;
+
+private:
+    std::ifstream in;
+};
+
+RowSpool::RowSpool(const JoinOptions& options, std::size_t keyBegin, std::size_t keyEnd)
+    : memoryBudget(options.memoryBudget), spillDir(options.spillDir), keyBegin(keyBegin), keyEnd(keyEnd) {}
+
+RowSpool::~RowSpool() {
+    readers.clear();
+    for (const auto& path : runPaths) {
+        std::error_code ec;
+        fs::remove(path, ec);
+    }
+}
+
+void RowSpool::add(const std::vector<std::string_view>& row) {
+    buffer.add(row);
+    ++count;
+    peak = std::max(peak, buffer.bytes());
+    if (buffer.bytes() > std::max(memoryBudget, kMinRunBytes)) spill();
+}
+
+//puts the buffered rows in the order they are read back: as added, or by key
+void RowSpool::sortBuffer() {
+    order.resize(buffer.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (keyed()) {
+        std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return keyLess(buffer[a], buffer[b], keyBegin, keyEnd);
+        });
+    }
+    peak = std::max(peak, buffer.bytes() + order.capacity() * sizeof(order[0]));
+}
+
+//writes the buffered rows to a new run and releases the buffer, so the next run starts small again
+void RowSpool::spill() {
+    sortBuffer();
+    runPaths.push_back(newRunPath());
+    std::ofstream out(runPaths.back(), std::ios::binary);
+    for (auto i : order) writeRow(out, 0, buffer[i]);
+    buffer = RowBuffer();
+    order = std::vector<std::uint32_t>();
+}
+
+void RowSpool::startReading() {
+    reading = true;
+    if (runPaths.empty()) {
+        sortBuffer();
+        return;
+    }
+    if (!buffer.empty()) spill();
+    if (!keyed()) return;
+
+    //merge in passes of at most kMaxFanIn runs so the number of open files stays bounded
+    std::vector<std::string> runs = runPaths;
+    while (runs.size() > kMaxFanIn) {
+        std::vector<std::string> group(runs.begin(), runs.begin() + kMaxFanIn);
+        runs.erase(runs.begin(), runs.begin() + kMaxFanIn);
+        openRuns(group);
+        runs.push_back(newRunPath());
+        runPaths.push_back(runs.back());
+        std::ofstream out(runs.back(), std::ios::binary);
+        Row row;
+        while (mergeNext(row)) writeRow(out, 0, row);
+        readers.clear();
+        for (const auto& path : group) {
+            std::error_code ec;
+            fs::resize_file(path, 0, ec); //merged run is no longer needed
+        }
+    }
+    openRuns(runs);
+}
+
+//opens runs for a merge, leaving out the empty ones
+void RowSpool::openRuns(const std::vector<std::string>& paths) {
+    readers.clear();
+    heads.clear();
+    for (const auto& path : paths) {
+        readers.push_back(std::make_unique<RunReader>(path));
+        if (!readers.back()->next()) readers.pop_back();
+    }
+    for (std::size_t i = 0; i < readers.size(); ++i) heads.push_back(i);
+    auto later = [&](std::size_t a, std::size_t b) { return keyLess(readers[b]->row, readers[a]->row, keyBegin, keyEnd); };
+    std::make_heap(heads.begin(), heads.end(), later);
+}
+
+//moves the smallest next row of the open runs into row, false once all of them are read
+bool RowSpool::mergeNext(Row& row) {
+    if (heads.empty()) return false;
+    auto later = [&](std::size_t a, std::size_t b) { return keyLess(readers[b]->row, readers[a]->row, keyBegin, keyEnd); };
+    std::pop_heap(heads.begin(), heads.end(), later);
+    std::size_t head = heads.back();
+    row.swap(readers[head]->row);
+    if (readers[head]->next()) std::push_heap(heads.begin(), heads.end(), later);
+    else heads.pop_back();
+    return true;
+}
+
+bool RowSpool::next(Row& row) {
+    if (!reading) startReading();
+    if (runPaths.empty()) {
+        if (position >= order.size()) return false;
+        BufferedRow stored = buffer[order[position++]];
+        row.resize(stored.size());
+        for (std::size_t i = 0; i < stored.size(); ++i) row[i].assign(stored[i]);
+        return true;
+    }
+    if (keyed()) return mergeNext(row);
+
+    //without a key the runs are read back one after another
+    while (true) {
+        if (!readers.empty() && readers[0]->next()) {
+            row.swap(readers[0]->row);
+            return true;
+        }
+        if (position >= runPaths.size()) return false;
+        readers.clear();
+        readers.push_back(std::make_unique<RunReader>(runPaths[position++]));
+    }
+}
+
+std::string RowSpool::newRunPath() {
+    if (tag.empty()) {
+        std::random_device rd;
+        tag = std::to_string(std::chrono::steady_clock::now().time_since_epoch().count() ^ rd());
+    }
+    return spillDir + "/.spool_" + tag + "_" + std::to_string(runPaths.size()) + ".tmp";
+}
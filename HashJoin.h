@@ -0,0 +1,105 @@
+#ifndef HASH_JOIN_H
+#define HASH_JOIN_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "RowBatch.h"
+
+//one parsed table row, one string per cell
+using Row = std::vector<std::string>;
+
+//pulls the next row of a join input, returns false once the input is exhausted
+using RowReader = std::function<bool(Row&)>;
+
+//receives every matching (left, right) pair; the views are valid for the call
+using JoinEmitter = std::function<void(BufferedRow, BufferedRow)>;
+
+//one side of an equi-join
+struct JoinInput {
+    RowReader read;
+    size_t keyIndex = 0;
+    std::uintmax_t sizeHint = 0; //approximate input size in bytes, used to pick the build side
+};
+
+//what a join did, for EXPLAIN ANALYZE
+struct JoinStats {
+    bool buildIsLeft = false;
+    bool grace = false;           //the build side did not fit and both inputs were partitioned
+    std::size_t partitions = 0;
+    std::size_t peakBytes = 0;    //most memory the buffered rows held at once
+};
+
+struct JoinOptions {
+    std::size_t memoryBudget = 256u << 20; //bytes buffered rows may occupy before spilling
+    std::string spillDir = "database";     //where grace partitions are written
+    JoinStats* stats = nullptr;            //filled in when set
+    bool ordered = true;                   //emit pairs in nested-loop order; a caller that orders them
+                                           //itself saves the buffering and merging this takes
+};
+
+//inner equi-join of left and right on their key columns. buffered rows are kept in RowBuffers.
+//pairs are emitted in the same order a nested loop over left then right would produce them:
+//ordered by left row, then by right row. the smaller input (by sizeHint) is the build side;
+//if it does not fit in memoryBudget both inputs are hash partitioned to temp files and
+//joined partition by partition (grace hash join), then the partition results are merged.
+//matches held back to restore that order count against memoryBudget too: past it they are
+//written to temp files as sorted runs and merged.
+//without options.ordered pairs are emitted as they are found instead. rows that have no key
+//column are skipped.
+void hashJoin(JoinInput& left, JoinInput& right, const JoinOptions& options, const JoinEmitter& emit);
+
+//rows written once and then read back once, such as the rows a join of three or more tables has
+//joined so far. they are kept in a RowBuffer until it outgrows memoryBudget, then written to temp
+//files in spillDir. with a key the rows are read back ordered by the bytes of their cells
+//[keyBegin, keyEnd): each file is a run sorted before it is written, and the runs are merged
+class RowSpool {
+public:
+    explicit RowSpool(const JoinOptions& options, std::size_t keyBegin = 0, std::size_t keyEnd = 0);
+    RowSpool(const RowSpool&) = delete;
+    RowSpool& operator=(const RowSpool&) = delete;
+    ~RowSpool();
+
+    //copies a row; every row is added before the first call to next
+    void add(const std::vector<std::string_view>& row);
+
+    //reads the next row back, in the order the rows were added or by key; false after the last one
+    bool next(Row& row);
+
+    std::uint64_t size() const { return count; }
+    std::size_t runsWritten() const { return runPaths.size(); }
+    std::size_t peakBytes() const { return peak; }
+
+private:
+    class RunReader;
+
+    bool keyed() const { return keyBegin < keyEnd; }
+    void sortBuffer();
+    void spill();
+    void startReading();
+    void openRuns(const std::vector<std::string>& paths);
+    bool mergeNext(Row& row);
+    std::string newRunPath();
+
+    std::size_t memoryBudget;
+    std::string spillDir;
+    std::size_t keyBegin, keyEnd;
+
+    RowBuffer buffer;                 //the rows not written to a run yet
+    std::vector<std::uint32_t> order; //the buffer's rows in the order they are read back
+    std::uint64_t count = 0;
+    std::size_t peak = 0;             //most memory the buffer and its order held
+    bool reading = false;
+    std::size_t position = 0;         //next entry of order, or next run when runs are read in turn
+
+    std::string tag;
+    std::vector<std::string> runPaths;               //every run written, removed with the spool
+    std::vector<std::unique_ptr<RunReader>> readers; //the runs being read back
+    std::vector<std::size_t> heads;                  //heap of readers by the key of their next row
+};
+
+#endif
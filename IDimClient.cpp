@@ -0,0 +1,68 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "Protocol.h"
+
+//sends a command to a running server and prints its reply, returns false if the connection broke
+bool sendCommand(int fd, const std::string& sql_cmd) {
+    std::string reply;
+    if (!writeFrame(fd, sql_cmd) || !readFrame(fd, reply)) {
+        std::cout << "Error: Connection to server lost.\n";
+        return false;
+    }
+    std::cout.write(reply.data(), reply.size());
+    return true;
+}
+
+//main function, entry point of the client
+int main(int argc, char* argv[]) {
+    std::string socketPath = kDefaultSocketPath;
+    std::vector<std::string> commands;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--socket=", 0) == 0) {
+            socketPath = arg.substr(9);
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cout << "Usage: " << argv[0] << " [--socket=PATH] ['SQL command' ...]\n";
+            return 1;
+        } else {
+            commands.push_back(arg);
+        }
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cout << "Error: Socket path '" << socketPath << "' is too long.\n";
+        return 1;
+    }
+    std::strcpy(addr.sun_path, socketPath.c_str());
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cout << "Error: Could not connect to server at '" << socketPath << "'.\n";
+        return 1;
+    }
+
+    //commands come from the arguments, or one per line from stdin
+    bool ok = true;
+    if (!commands.empty()) {
+        for (const auto& command : commands) {
+            if (!(ok = sendCommand(fd, command))) break;
+        }
+    } else {
+        std::string line;
+        while (ok && std::getline(std::cin, line)) {
+            if (!line.empty()) ok = sendCommand(fd, line);
+        }
+    }
+
+    ::close(fd);
+    return ok ? 0 : 1;
+}
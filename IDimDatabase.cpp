@@ -1,17 +1,96 @@
 #include <iostream>
 #include <fstream>
 #include <filesystem>
-#include <sstream>
 #include <vector>
 #include <string>
-#include <regex>
-#include <iomanip>
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <unistd.h>
+
+#include "IDimDatabase.h"
+#include "ColumnStore.h"
+#include "Aggregate.h"
+#include "AppendLock.h"
+#include "CsvScanner.h"
+#include "DeletionMap.h"
+#include "ExternalSort.h"
+#include "HashJoin.h"
+#include "MaterializedView.h"
+#include "ParallelScan.h"
+#include "Predicate.h"
+#include "QueryProfile.h"
+#include "ResultCache.h"
+#include "RowBatch.h"
+#include "Schema.h"
+#include "SqlParser.h"
+#include "TableIndex.h"
+#include "TableStats.h"
+#include "TableWriter.h"
+#include "ZoneMap.h"
 
 namespace fs = std::filesystem;
 
+Settings settings;
+
+//where command output goes: std::cout, or a request's reply buffer in server mode
+thread_local std::ostream* outputStream = &std::cout;
+
+std::ostream& out() {
+    return *outputStream;
+}
+
+OutputCapture::OutputCapture(std::ostream& stream) : previous(outputStream) {
+    outputStream = &stream;
+}
+
+OutputCapture::~OutputCapture() {
+    outputStream = previous;
+}
+
+//prints results to out() as they arrive
+class TextSink : public ResultSink {
+public:
+    void header(std::string_view line) override {
+        out() << line << "\n";
+    }
+
+    void rows(std::string_view lines) override {
+        out().write(lines.data(), lines.size());
+    }
+
+    void message(std::string_view text) override {
+        out().write(text.data(), text.size());
+    }
+};
+
+TextSink textSink;
 
+//where query results go: printed with the rest of the output, or a caller's sink
+thread_local ResultSink* currentSink = &textSink;
+
+ResultSink& resultSink() {
+    return *currentSink;
+}
+
+ResultCapture::ResultCapture(ResultSink& sink) : previous(currentSink) {
+    currentSink = &sink;
+}
+
+ResultCapture::~ResultCapture() {
+    currentSink = previous;
+}
 
 //helper function to convert string to lowercase
 std::string convertToLower(std::string str) {
@@ -20,537 +99,2995 @@ std::string convertToLower(std::string str) {
     return str;
 }
 
-//helper function to split strings by delimiter
-std::vector<std::string> tokenize(const std::string& str, char delimiter) {
-    std::vector<std::string> tokens;
-    std::stringstream ss(str);
-    std::string token;
-    while (std::getline(ss, token, delimiter)) {
-        tokens.push_back(token);
+//helper function to join values into one comma separated line
+std::string joinValues(const std::vector<std::string>& values) {
+    std::string line;
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i > 0) line += ",";
+        line += values[i];
     }
-    return tokens;
+    return line;
 }
 
-//func to create a table (file)
-void buildTable(const std::string& sql_cmd) {
-    //parse the create table command using regex
-    std::regex createRegex("CREATE\\s+TABLE\\s+(\\w+)\\s*\\(\\s*(.+?)\\s*\\)", std::regex::icase);
-    std::smatch match;
-    
-    if (std::regex_search(sql_cmd, match, createRegex)) {
-        std::string tableName = convertToLower(match[1]);
-        std::string columns = match[2];
-        
-        //clean up column string by removing spaces after commas
-        std::stringstream cleanedColumns;
-        bool afterComma = false;
-        for (char c : columns) {
-            if (c == ',') {
-                cleanedColumns << c;
-                afterComma = true;
-            } else if (afterComma && std::isspace(c)) {
-                //skip spaces after comma
-                continue;
-            } else {
-                cleanedColumns << c;
-                afterComma = false;
+//helper function to turn a parsed column list back into names as written, {"*"} if empty
+std::vector<std::string> columnNames(const std::vector<ColumnRef>& columns) {
+    if (columns.empty()) return {"*"};
+    std::vector<std::string> names;
+    for (const auto& col : columns) names.push_back(col.table.empty() ? col.column : col.table + "." + col.column);
+    return names;
+}
+
+//helper function to find a column by case-insensitive name, returns -1 if missing
+int findColumn(const std::vector<std::string>& headers, const std::string& column) {
+    std::string lowerColumn = convertToLower(column);
+    for (size_t i = 0; i < headers.size(); ++i) {
+        if (convertToLower(headers[i]) == lowerColumn) return i;
+    }
+    return -1;
+}
+
+//helper function to find the index on a table column, returns nullptr if there is none
+const IndexInfo* findIndex(const std::vector<IndexInfo>& indexes, const std::string& column) {
+    for (const auto& index : indexes) {
+        if (index.column == convertToLower(column)) return &index;
+    }
+    return nullptr;
+}
+
+//helper function to tell whether a table has been converted to the columnar format
+bool isColumnarTable(const std::string& tableName) {
+    return fs::exists("database/" + tableName + ".col");
+}
+
+//helper function to open a text table as it was at one commit: the reader stops at the committed
+//length and deleted holds the tombstones in effect then. a table whose file is replaced while it is
+//opened (by VACUUM) is opened again, so the file and its tombstones always belong together
+bool openSnapshot(const std::string& tableName, CsvReader& reader, DeletionMap& deleted, TableSnapshot& snapshot) {
+    std::string path = "database/" + tableName + ".txt";
+    while (true) {
+        snapshot = readSnapshot(tableName);
+        if (!reader.open(path, snapshot.length)) return false;
+        deleted.load(tableName, reader.fileId(), snapshot.deleted);
+        if (readSnapshot(tableName).generation == snapshot.generation) return true;
+    }
+}
+
+//helper function to note the deleted rows a scan passes over, for EXPLAIN
+std::string deletedLabel(const DeletionMap& deleted) {
+    if (deleted.empty()) return "";
+    return ", " + std::to_string(deleted.size()) + (deleted.size() == 1 ? " deleted row" : " deleted rows") + " skipped";
+}
+
+//a text table parsed into memory, kept between commands in server mode. deleted rows are left out
+struct CachedTable {
+    std::vector<std::string> headers;
+    RowBuffer rows;
+    std::vector<std::uint64_t> offsets; //byte offset of each row in the table file
+    fs::file_time_type modified;
+    TableSnapshot snapshot; //the committed state the rows were read at
+};
+
+//parsed text tables keyed by name, reloaded when the file's mtime or committed state changes
+class TableCache {
+public:
+    //returns nullptr when caching is off or the table is not a readable text table
+    std::shared_ptr<const CachedTable> get(const std::string& tableName) {
+        if (!settings.cacheTables) return nullptr;
+
+        std::string path = "database/" + tableName + ".txt";
+        std::error_code ec;
+        auto modified = fs::last_write_time(path, ec);
+        if (ec) return nullptr;
+        TableSnapshot snapshot = readSnapshot(tableName);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = tables.find(tableName);
+            const TableSnapshot* loaded = it != tables.end() ? &it->second->snapshot : nullptr;
+            if (loaded && it->second->modified == modified && loaded->length == snapshot.length &&
+                loaded->deleted == snapshot.deleted && loaded->generation == snapshot.generation) {
+                return it->second;
             }
         }
 
-        //create database directory if it doesn't exist
-        if (!fs::exists("database")) {
-            fs::create_directory("database");
-                    fs::permissions("database", 
-                        fs::perms::owner_all | fs::perms::group_all | fs::perms::others_all,
-                        fs::perm_options::replace);
+        auto table = std::make_shared<CachedTable>();
+        CsvReader reader;
+        DeletionMap deleted;
+        std::string_view line;
+        if (!openSnapshot(tableName, reader, deleted, table->snapshot) || !reader.nextLine(line)) return nullptr;
+        splitRow(line, table->headers);
+        std::uint64_t offset = line.size() + 1;
+        std::vector<std::string_view> fields;
+        size_t cursor = 0;
+        while (reader.nextLine(line)) {
+            if (deleted.empty() || !deleted.contains(offset, cursor)) {
+                splitRow(line, fields);
+                table->rows.add(fields);
+                table->offsets.push_back(offset);
+            }
+            offset += line.size() + 1;
         }
+        table->modified = modified;
 
-        //create table file and write column headers
-        std::ofstream outFile("database/" + tableName + ".txt");
-        outFile << cleanedColumns.str() << "\n"; 
-        outFile.close();
+        std::lock_guard<std::mutex> lock(mutex);
+        tables[tableName] = table;
+        return table;
+    }
 
-        // Set file permissions to 777
-        fs::permissions("database/"+ tableName + ".txt",
-                        fs::perms::owner_all | fs::perms::group_all | fs::perms::others_all,
-                        fs::perm_options::replace);
+    void invalidate(const std::string& tableName) {
+        std::lock_guard<std::mutex> lock(mutex);
+        tables.erase(tableName);
+    }
 
-        std::cout << "Table '" << tableName << "' created successfully.\n";
-    } else {
-        std::cout << "Error: Invalid CREATE TABLE syntax.\n";
-    }
-}
-
-//func to insert values into a table (file)
-void addToTable(const std::string& sql_cmd) {
-    //parse the insert command using regex
-    std::regex insertRegex("INSERT\\s+INTO\\s+(\\w+)\\s+VALUES\\s*\\(\\s*(.+?)\\s*\\)", std::regex::icase);
-    std::smatch match;
-    
-    if (std::regex_search(sql_cmd, match, insertRegex)) {
-        std::string tableName = convertToLower(match[1]);
-        std::string values = match[2];
-        
-        //clean up the values string, preserving spaces inside quotes
-        std::stringstream cleanedValues;
-        bool insideQuotes = false;
-        bool afterComma = false;
-        
-        for (char c : values) {
-            if (c == '\'') {
-                //toggle quote state
-                insideQuotes = !insideQuotes;
-                cleanedValues << c;
-            } else if (c == ',' && !insideQuotes) {
-                cleanedValues << c;
-                afterComma = true;
-            } else if (afterComma && std::isspace(c) && !insideQuotes) {
-                //skip spaces after comma when not in quotes
-                continue;
-            } else {
-                cleanedValues << c;
-                afterComma = false;
-            }
+private:
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<const CachedTable>> tables;
+};
+
+TableCache tableCache;
+
+//the parts of a text table's file a filtered scan reads: the blocks its zone map cannot rule out,
+//merged where they are adjacent. without a filter or a zone map that matches the file it is every row.
+//a table with no zone map, or a stale one, has it built and saved by its first filtered scan, so a
+//table that is never written again is pruned too
+struct ScanRanges {
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> ranges; //[begin, end) byte offsets
+    size_t blocks = 0;  //blocks of the zone map, 0 if none was used
+    size_t skipped = 0; //blocks left out
+};
+
+ScanRanges planRanges(const std::string& tableName, const RowFilter* filter, std::uint64_t dataStart,
+                      std::uint64_t fileSize) {
+    ScanRanges scan;
+    ZoneMap zones;
+    bool zoned = false;
+    if (filter) {
+        zoned = zones.load(tableName);
+        if (!zoned && zones.build(tableName)) {
+            zones.save(tableName); //a map that could not be saved still serves this scan
+            zoned = true;
         }
-
-        //check if table exists before inserting
-        std::ifstream checkFile("database/" + tableName + ".txt");
-        if (!checkFile) {
-            std::cout << "Error: Table '" << tableName << "' does not exist.\n";
-            return;
+    }
+    if (!zoned || zones.end() != fileSize) {
+        if (fileSize > dataStart) scan.ranges.push_back({dataStart, fileSize});
+        return scan;
+    }
+    scan.blocks = zones.blocks().size();
+    for (const auto& block : zones.blocks()) {
+        if (!filter->mayMatch(block.columns)) {
+            ++scan.skipped;
+        } else if (!scan.ranges.empty() && scan.ranges.back().second == block.offset) {
+            scan.ranges.back().second = block.offset + block.bytes;
+        } else {
+            scan.ranges.push_back({block.offset, block.offset + block.bytes});
         }
-        checkFile.close();
+    }
+    return scan;
+}
 
-        //add the new values to the table file
-        std::ofstream outFile("database/" + tableName + ".txt", std::ios::app);
-        outFile << cleanedValues.str() << "\n";
-        std::cout << "Values inserted into '" << tableName << "' successfully.\n";
-    } else {
-        std::cout << "Error: Invalid INSERT INTO syntax.\n";
+//helper function to describe what a zone map saved a scan, for EXPLAIN
+std::string rangeLabel(const ScanRanges& scan) {
+    if (scan.blocks == 0) return "";
+    return ", zone maps skip " + std::to_string(scan.skipped) + " of " + std::to_string(scan.blocks) + " blocks";
+}
+
+//helper function to cut the parts of a mapped table that a scan reads out of the file
+std::vector<std::string_view> rangePieces(std::string_view data, const ScanRanges& scan) {
+    std::vector<std::string_view> pieces;
+    for (const auto& [begin, end] : scan.ranges) {
+        if (begin < data.size()) pieces.push_back(data.substr(begin, std::min<std::uint64_t>(end, data.size()) - begin));
     }
+    return pieces;
 }
 
-//func to display table content
-void showTable(const std::string& tableName) {
-    std::ifstream inFile("database/" + tableName + ".txt");
-    if (!inFile) {
-        std::cout << "Error: Table '" << tableName << "' does not exist.\n";
-        return;
+//sequential reader over the rows of a table in either storage format
+class TableScan {
+public:
+    bool open(const std::string& tableName) {
+        columnar = isColumnarTable(tableName);
+        if (columnar) {
+            if (!table.open("database/" + tableName + ".col")) return false;
+            headers = table.columnNames();
+            sizeBytes = table.fileSize();
+            return true;
+        }
+        cached = tableCache.get(tableName);
+        if (cached) {
+            headers = cached->headers;
+            sizeBytes = cached->snapshot.length;
+            generation = cached->snapshot.generation;
+            return true;
+        }
+        TableSnapshot snapshot;
+        if (!openSnapshot(tableName, textFile, deleted, snapshot)) return false;
+        std::string_view line;
+        textFile.nextLine(line);
+        splitRow(line, headers);
+        sizeBytes = textFile.size();
+        generation = snapshot.generation;
+        fileId = textFile.fileId();
+        return true;
     }
 
-    //read and display all lines from the table file
-    std::string line;
-    while (std::getline(inFile, line)) {
-        auto values = tokenize(line, ',');
-        for (const auto& value : values) {
-            std::cout << std::setw(15) << std::left << value;
+    bool next(Row& row) {
+        if (cached) {
+            if (nextRow >= cached->rows.size()) return false;
+            BufferedRow cells = cached->rows[nextRow++];
+            row.resize(cells.size());
+            for (size_t c = 0; c < row.size(); ++c) row[c].assign(cells[c]);
+            return true;
         }
-        std::cout << "\n";
+        if (columnar) {
+            if (nextRow >= table.rowCount()) return false;
+            char scratch[ColumnTable::kScratchSize];
+            row.resize(table.rowWidth(nextRow));
+            for (size_t c = 0; c < row.size(); ++c) row[c] = table.cell(c, nextRow, scratch);
+            ++nextRow;
+            return true;
+        }
+        std::string_view line;
+        while (true) {
+            //move on to the next range at the end of one
+            while (ranged && range < skipping.ranges.size() && textFile.offset() >= skipping.ranges[range].second) {
+                if (++range < skipping.ranges.size()) textFile.seek(skipping.ranges[range].first);
+            }
+            if (ranged && range >= skipping.ranges.size()) return false;
+            std::uint64_t offset = textFile.offset();
+            if (!textFile.nextLine(line)) return false;
+            bytesRead += line.size() + 1;
+            if (deleted.empty() || !deleted.contains(offset, deletedCursor)) break;
+        }
+        splitRow(line, row);
+        return true;
     }
-}
 
-//func to display selected columns with optional filtering
+    //restart at the first data row
+    void rewind() {
+        nextRow = 0;
+        deletedCursor = 0;
+        if (ranged) {
+            range = 0;
+            if (!skipping.ranges.empty()) textFile.seek(skipping.ranges[0].first);
+        } else if (!columnar && !cached) {
+            std::string_view line;
+            textFile.seek(0);
+            textFile.nextLine(line);
+        }
+    }
 
-void showTableWithFilters(const std::string& tableName, const std::vector<std::string>& selectedCols,
-                          const std::string& whereCol = "", const std::string& whereOp = "=",
-                          const std::string& whereValue = "") {
-    std::ifstream inFile("database/" + tableName + ".txt");
-    if (!inFile) {
-        std::cout << "Error: Table '" << tableName << "' does not exist.\n";
-        return;
+    //reads only the blocks of a text table whose zone map does not rule out filter; called before
+    //the first row is read
+    void skipBlocks(const std::string& tableName, const RowFilter& filter) {
+        if (columnar || cached) return;
+        skipping = planRanges(tableName, &filter, textFile.offset(), sizeBytes);
+        ranged = true;
+        rewind();
     }
 
-    //read header line and parse column names
+    bool inMemory() const { return cached != nullptr; }
+
+    //true for a columnar table written with compression
+    bool compressed() const { return columnar && table.compressed(); }
+
+    //how the table is read, for EXPLAIN
+    std::string label(const std::string& tableName) const;
+
+    std::vector<std::string> headers;
+    std::uintmax_t sizeBytes = 0;
+    std::uintmax_t bytesRead = 0; //text consumed by next() so far
+    bool columnar = false;
+    DeletionMap deleted;          //rows of a text file that next() passes over
+    std::uint64_t generation = 0; //of the text table read, see TableSnapshot
+    std::uint64_t fileId = 0;     //of the text file read, 0 for a table read from memory
+
+private:
+    CsvReader textFile;
+    std::shared_ptr<const CachedTable> cached;
+    ColumnTable table;
+    ScanRanges skipping;
+    bool ranged = false;
+    size_t range = 0;
+    std::uint64_t nextRow = 0;
+    size_t deletedCursor = 0;
+};
+
+//helper function to send the header of a result: the names at the selected positions
+void sendHeader(const std::vector<std::string>& names, const std::vector<int>& selectedIndexes) {
     std::string line;
-    std::getline(inFile, line);
-    auto headers = tokenize(line, ',');
+    for (size_t i = 0; i < selectedIndexes.size(); ++i) {
+        if (i > 0) line += ',';
+        line += names[selectedIndexes[i]];
+    }
+    resultSink().header(line);
+}
 
+//helper function to map selected column names to header positions, prints an error if one is missing
+bool selectColumns(const std::vector<std::string>& headers, const std::vector<std::string>& selectedCols,
+                   std::vector<int>& selectedIndexes) {
     std::vector<std::string> lowerHeaders;
     for (const auto& header : headers) {
         lowerHeaders.push_back(convertToLower(header));
     }
 
-    //determine which columns to display
-    std::vector<int> selectedIndexes;
     if (selectedCols.size() == 1 && selectedCols[0] == "*") {
         for (size_t i = 0; i < headers.size(); ++i) {
             selectedIndexes.push_back(i);
         }
-    } else {
-        for (const auto& col : selectedCols) {
-            std::string lowerCol = convertToLower(col);
-            auto it = std::find(lowerHeaders.begin(), lowerHeaders.end(), lowerCol);
-            if (it != lowerHeaders.end()) {
-                selectedIndexes.push_back(std::distance(lowerHeaders.begin(), it));
-            } else {
-                std::cout << "Error: Column '" << col << "' not found in table.\n";
-                return;
-            }
+        return true;
+    }
+    for (const auto& col : selectedCols) {
+        std::string lowerCol = convertToLower(col);
+        auto it = std::find(lowerHeaders.begin(), lowerHeaders.end(), lowerCol);
+        if (it != lowerHeaders.end()) {
+            selectedIndexes.push_back(std::distance(lowerHeaders.begin(), it));
+        } else {
+            out() << "Error: Column '" << col << "' not found in table.\n";
+            return false;
         }
     }
+    return true;
+}
 
-    //display header row
-    for (size_t i = 0; i < selectedIndexes.size(); ++i) {
-        std::cout << headers[selectedIndexes[i]];
-        if (i < selectedIndexes.size() - 1) std::cout << ",";
+//helper function to compile a WHERE expression against the columns of a row, printing an error if
+//a constant does not fit its column's type
+bool prepareFilter(const Condition& where, const std::vector<ValueType>& types,
+                   const std::function<int(const ColumnRef&)>& resolve, RowFilter& filter) {
+    std::string error;
+    if (!filter.prepare(where, types, resolve, error)) {
+        out() << error << "\n";
+        return false;
     }
-    std::cout << "\n";
+    return true;
+}
 
-    //process and display data rows
-    while (std::getline(inFile, line)) {
-        auto values = tokenize(line, ',');
+//helper function to list the terms of a WHERE expression that must all hold: the operands of a
+//top-level AND, or the whole expression
+std::vector<const Condition*> conjuncts(const Condition& where) {
+    std::vector<const Condition*> terms;
+    if (where.type != Condition::Type::And) {
+        terms.push_back(&where);
+        return terms;
+    }
+    for (const auto& child : where.children) terms.push_back(&child);
+    return terms;
+}
 
-        //apply WHERE id present
-        bool matchesCondition = true;
-        if (!whereCol.empty()) {
-            std::string lowerWhereCol = convertToLower(whereCol);
-            auto it = std::find(lowerHeaders.begin(), lowerHeaders.end(), lowerWhereCol);
-            if (it == lowerHeaders.end()) continue; //invalid column
-            int whereIndex = std::distance(lowerHeaders.begin(), it);
-
-            if (whereIndex >= values.size()) continue;
-
-            std::string cellValue = values[whereIndex];
-
-            //handle the comparison
-            if (whereOp == "=") {
-                matchesCondition = (cellValue == whereValue);
-            } else if (whereOp == "!=") {
-                matchesCondition = (cellValue != whereValue);
-            } else {
-                //try numeric comparison
-                try {
-                    double cellNum = std::stod(cellValue);
-                    double whereNum = std::stod(whereValue);
-
-                    if (whereOp == ">") {
-                        matchesCondition = (cellNum > whereNum);
-                    } else if (whereOp == "<") {
-                        matchesCondition = (cellNum < whereNum);
-                    } else if (whereOp == ">=") {
-                        matchesCondition = (cellNum >= whereNum);
-                    } else if (whereOp == "<=") {
-                        matchesCondition = (cellNum <= whereNum);
-                    } else {
-                        matchesCondition = false;
-                    }
-                } catch (...) {
-                    matchesCondition = false; //skip row if non-numeric comparison failed
-                }
-            }
+//helper function to collect the tables a WHERE expression names
+void conditionTables(const Condition& where, std::vector<std::string>& tables) {
+    if (where.children.empty()) {
+        if (std::find(tables.begin(), tables.end(), where.column.table) == tables.end()) {
+            tables.push_back(where.column.table);
         }
+        return;
+    }
+    for (const auto& child : where.children) conditionTables(child, tables);
+}
 
-        if (!matchesCondition) continue;
+//helper function to find a test in a WHERE expression on a column qualified with a table other
+//than tableName, nullptr if there is none
+const Condition* findForeignColumn(const Condition& where, const std::string& tableName) {
+    if (where.children.empty()) {
+        return !where.column.table.empty() && where.column.table != tableName ? &where : nullptr;
+    }
+    for (const auto& child : where.children) {
+        if (const Condition* found = findForeignColumn(child, tableName)) return found;
+    }
+    return nullptr;
+}
 
-        //display selected columns
-        for (size_t i = 0; i < selectedIndexes.size(); ++i) {
-            int idx = selectedIndexes[i];
-            if (idx < values.size()) {
-                std::cout << values[idx];
-            }
-            if (i < selectedIndexes.size() - 1) std::cout << ",";
+//one ORDER BY key resolved to a position in the values being sorted
+struct SortColumn {
+    int index;
+    bool descending;
+    ValueType type;
+};
+
+//helper function to resolve ORDER BY columns; resolve maps a column reference to its position
+//in a row, or -1. prints an error and returns false if a column is missing
+bool planOrder(const std::vector<OrderKey>& orderBy, const std::vector<ValueType>& types,
+               const std::function<int(const ColumnRef&)>& resolve, const std::string& scope,
+               std::vector<SortColumn>& sortColumns) {
+    for (const auto& key : orderBy) {
+        int index = resolve(key.column);
+        if (index < 0) {
+            const ColumnRef& ref = key.column;
+            out() << "Error: Column '" << (ref.table.empty() ? ref.column : ref.table + "." + ref.column)
+                  << "' not found in " << scope << ".\n";
+            return false;
         }
-        std::cout << "\n";
+        sortColumns.push_back({index, key.descending, types[index]});
     }
+    return true;
 }
 
+//helper function to build the sort key of a row from its ORDER BY values
+template <typename Values>
+void buildSortKey(std::string& key, const std::vector<SortColumn>& sortColumns, const Values& values) {
+    key.clear();
+    for (const auto& col : sortColumns) {
+        std::string_view cell = col.index < static_cast<int>(values.size()) ? std::string_view(values[col.index]) : "";
+        appendSortKey(key, col.type, cell, col.descending);
+    }
+}
 
-//handle DESC tables 
+//helper function to create the sorter that orders and limits a query's output lines,
+//nullptr when the query has neither ORDER BY nor LIMIT
+std::unique_ptr<RowSorter> makeSorter(const std::vector<OrderKey>& orderBy, std::optional<std::uint64_t> limit) {
+    if (orderBy.empty() && !limit) return nullptr;
+    SortOptions options;
+    options.memoryBudget = settings.sortMemory;
+    options.limit = limit;
+    options.keyed = !orderBy.empty();
+    return std::make_unique<RowSorter>(options, [](const std::string& text) { resultSink().rows(text); });
+}
 
-void describeTable(const std::string& sql_cmd) {
-    std::regex descRegex(R"(DESC\s+(\w+))", std::regex::icase);
-    std::smatch match;
+//helper function to name a column reference as the query wrote it
+std::string columnLabel(const ColumnRef& ref) {
+    std::string name = ref.table.empty() ? ref.column : ref.table + "." + ref.column;
+    return ref.function.empty() ? name : ref.function + "(" + name + ")";
+}
 
-    if (std::regex_match(sql_cmd, match, descRegex)) {
-        std::string tableName = convertToLower(match[1]);
-        std::ifstream inFile("database/" + tableName + ".txt");
+//helper function to format a size in bytes for EXPLAIN
+std::string byteLabel(std::uintmax_t bytes) {
+    char text[32];
+    if (bytes >= (1u << 20)) std::snprintf(text, sizeof(text), "%.1f MiB", bytes / 1048576.0);
+    else if (bytes >= 1024) std::snprintf(text, sizeof(text), "%.1f KiB", bytes / 1024.0);
+    else std::snprintf(text, sizeof(text), "%ju bytes", bytes);
+    return text;
+}
 
-        if (!inFile) {
-            std::cout << "Error: Table '" << tableName << "' does not exist.\n";
-            return;
-        }
+//helper function to describe the select list for EXPLAIN
+std::string projectLabel(const std::vector<std::string>& columns) {
+    std::string label = "Project:";
+    for (size_t i = 0; i < columns.size(); ++i) label += (i ? ", " : " ") + columns[i];
+    return label;
+}
 
-        std::string headerLine;
-        if (std::getline(inFile, headerLine)) {
-            auto headers = tokenize(headerLine, ',');
-            std::cout << "Columns in table '" << tableName << "':\n";
-            for (const auto& col : headers) {
-                std::cout << "- " << col << "\n";
+//helper function to write a WHERE expression back as SQL
+std::string conditionText(const Condition& where) {
+    using Type = Condition::Type;
+    auto operand = [](const Condition& child) {
+        bool group = child.type == Type::And || child.type == Type::Or;
+        return group ? "(" + conditionText(child) + ")" : conditionText(child);
+    };
+    std::string column = columnLabel(where.column);
+    switch (where.type) {
+        case Type::Compare: return column + " " + where.op + " " + where.value.raw;
+        case Type::Like: return column + " LIKE " + where.value.raw;
+        case Type::Between: return column + " BETWEEN " + where.values[0].raw + " AND " + where.values[1].raw;
+        case Type::In: {
+            std::string text = column + " IN (";
+            for (size_t i = 0; i < where.values.size(); ++i) text += (i ? ", " : "") + where.values[i].raw;
+            return text + ")";
+        }
+        case Type::Not: return "NOT " + operand(where.children[0]);
+        default: {
+            std::string text;
+            for (size_t i = 0; i < where.children.size(); ++i) {
+                if (i > 0) text += where.type == Type::And ? " AND " : " OR ";
+                text += operand(where.children[i]);
             }
-        } else {
-            std::cout << "Error: Table '" << tableName << "' is empty.\n";
+            return text;
         }
-    } else {
-        std::cout << "Error: Invalid DESC syntax. Use: DESC tablename\n";
-    }
-}
-
-//handle JOIN operations between two tables
-
-void processJoin(const std::string& sql_cmd) {
-    //updated regex: supports table.col OP value in WHERE
-    std::regex joinRegex(
-        R"(SELECT\s+(.+?)\s+FROM\s+(\w+)\s+JOIN\s+(\w+)\s+ON\s+(\w+)\.(\w+)\s*=\s*(\w+)\.(\w+)(?:\s+WHERE\s+(\w+)\.(\w+)\s*(=|!=|<=|>=|<|>)\s*'?(.*?)'?)?\s*$)",
-        std::regex::icase
-    );
-    std::smatch match;
-
-    if (std::regex_search(sql_cmd, match, joinRegex)) {
-        std::string columns     = match[1];
-        std::string table1      = convertToLower(match[2]);
-        std::string table2      = convertToLower(match[3]);
-        std::string joinTable1  = convertToLower(match[4]);
-        std::string joinCol1    = convertToLower(match[5]);
-        std::string joinTable2  = convertToLower(match[6]);
-        std::string joinCol2    = convertToLower(match[7]);
-
-        std::string whereTable  = match[8].matched ? convertToLower(match[8].str()) : "";
-        std::string whereCol    = match[9].matched ? convertToLower(match[9].str()) : "";
-        std::string whereOp     = match[10].matched ? match[10].str() : "";
-        std::string whereVal    = match[11].matched ? match[11].str() : "";
-
-       // std::cout << "whereTable=" << whereTable << " whereCol=" << whereCol 
-         //         << " whereOp=" << whereOp << " whereVal=" << whereVal << "\n";
-
-        //validate files
-        std::ifstream table1File("database/" + table1 + ".txt");
-        std::ifstream table2File("database/" + table2 + ".txt");
-        if (!table1File || !table2File) {
-            std::cout << "Error: One or both tables do not exist.\n";
-            return;
+    }
+}
+
+//helper function to describe a compiled WHERE expression for EXPLAIN
+std::string filterLabel(const Condition& where, const RowFilter& filter, const std::vector<ValueType>& types) {
+    std::string label = "Filter: " + conditionText(where);
+    if (filter.neverMatches()) return label + " (no such column, no rows)";
+    if (filter.columns().size() == 1 && types[filter.columns()[0]] != ValueType::Any) {
+        label += " (" + std::string(typeName(types[filter.columns()[0]])) + ")";
+    }
+    return label;
+}
+
+//helper function to add the operator of a query's sorter to the EXPLAIN plan
+PlanOperator* addSortOperator(int depth, const std::vector<OrderKey>& orderBy, std::optional<std::uint64_t> limit) {
+    if (!activeProfile() || (orderBy.empty() && !limit)) return nullptr;
+    if (orderBy.empty()) return addOperator(depth, "Limit: " + std::to_string(*limit));
+    std::string label = "Sort:";
+    for (size_t i = 0; i < orderBy.size(); ++i) {
+        label += (i ? ", " : " ") + columnLabel(orderBy[i].column);
+        if (orderBy[i].descending) label += " DESC";
+    }
+    if (limit) label += " LIMIT " + std::to_string(*limit) + " (bounded heap)";
+    else label += " (in memory up to " + byteLabel(settings.sortMemory) + ", then external merge)";
+    return addOperator(depth, label);
+}
+
+//helper function to print the rows of a sorter, recording how it ordered them for EXPLAIN ANALYZE
+void finishSorter(RowSorter& sorter, PlanOperator* op, bool keyed) {
+    {
+        SectionTimer timer(op);
+        sorter.finish();
+    }
+    if (!op) return;
+    op->rowsOut = sorter.rowsEmitted();
+    if (sorter.runsWritten() > 0) op->notes.push_back("wrote " + std::to_string(sorter.runsWritten()) + " runs to disk");
+    else if (keyed && !sorter.keptInHeap()) op->notes.push_back("sorted in memory");
+    if (sorter.peakBytes() > 0) op->notes.push_back("peak " + byteLabel(sorter.peakBytes()) + " of buffered rows");
+}
+
+//helper function to label a scan of a columnar table, with how many columns are encoded
+std::string columnarLabel(const std::string& tableName, const ColumnTable& table) {
+    std::string label = "Columnar Scan on " + tableName + " (" + std::to_string(table.rowCount()) + " rows, mapped";
+    if (table.compressed()) {
+        size_t encoded = 0;
+        for (size_t c = 0; c < table.columnCount(); ++c) encoded += table.encoded(c);
+        label += ", " + std::to_string(encoded) + " of " + std::to_string(table.columnCount()) + " columns encoded";
+    }
+    return label + ")";
+}
+
+std::string TableScan::label(const std::string& tableName) const {
+    if (columnar) return columnarLabel(tableName, table);
+    if (cached) return "Cached Scan on " + tableName + " (" + std::to_string(cached->rows.size()) + " rows in memory)";
+    return "Seq Scan on " + tableName + " (text, " + byteLabel(sizeBytes) + rangeLabel(skipping) + deletedLabel(deleted) +
+           ")";
+}
+
+//helper function to create an empty text table: its file with the header line, its schema and an
+//empty zone map. what was kept for an earlier table of that name is dropped
+void createTableFile(const std::string& tableName, const std::vector<std::string>& names,
+                     const std::vector<ValueType>& types) {
+    //create database directory if it doesn't exist
+    if (!fs::exists("database")) {
+        fs::create_directory("database");
+                fs::permissions("database", 
+                    fs::perms::owner_all | fs::perms::group_all | fs::perms::others_all,
+                    fs::perm_options::replace);
+    }
+
+    //other processes wait to append until the new file is in place
+    AppendLock lock;
+    lock.lock(tableName);
+
+    //a recreated table starts as text without indexes
+    dropIndexes(tableName);
+    dropZoneMap(tableName);
+    dropStats(tableName);
+    fs::remove("database/" + tableName + ".col");
+    saveSchema(tableName, names, types);
+
+    //create table file and write column headers, swapped in whole so readers see the old table or the new
+    std::string header = joinValues(names);
+    std::string path = "database/" + tableName + ".txt";
+    std::ofstream outFile(path + ".tmp");
+    outFile << header << "\n";
+    outFile.close();
+
+    // Set file permissions to 777
+    fs::permissions(path + ".tmp",
+                    fs::perms::owner_all | fs::perms::group_all | fs::perms::others_all,
+                    fs::perm_options::replace);
+    fs::rename(path + ".tmp", path);
+    lock.publishRewrite(header.size() + 1);
+    dropTombstones(tableName);
+
+    //the zone map grows with the rows added to the table
+    ZoneMap zones;
+    zones.reset(names.size(), header.size() + 1);
+    zones.save(tableName);
+
+    tableCache.invalidate(tableName);
+}
+
+//func to create a table (file)
+void buildTable(const CreateTableStmt& stmt) {
+    const std::string& tableName = stmt.table;
+
+    //columns may be declared with a type ("gpa DOUBLE"); the header holds only the names
+    std::vector<std::string> names(stmt.columns.size());
+    std::vector<ValueType> types(stmt.columns.size());
+    for (size_t i = 0; i < stmt.columns.size(); ++i) parseColumnDef(stmt.columns[i], names[i], types[i]);
+
+    //a table created over a materialized view replaces it
+    dropView(tableName);
+    createTableFile(tableName, names, types);
+    out() << "Table '" << tableName << "' created successfully.\n";
+}
+
+//helper function to refuse writes to a materialized view, whose rows come only from its query
+bool rejectViewWrite(const std::string& tableName) {
+    if (!isMaterializedView(tableName)) return false;
+    out() << "Error: '" << tableName << "' is a materialized view; its rows come from its query.\n";
+    return true;
+}
+
+//appends batches of rows to a text table and keeps its indexes in sync. every row of a batch
+//is checked against the table's column count and column types before any of the batch is written.
+//a batch may also delete rows of the table, which readers then stop seeing as the batch appears
+class TableLoader {
+public:
+    //prints an error and returns false if rows cannot be added to the table
+    bool open(const std::string& table) {
+        tableName = table;
+
+        //columnar tables are read-only snapshots
+        if (isColumnarTable(tableName)) {
+            out() << "Error: Table '" << tableName << "' is stored in columnar format; "
+                      << "use CONVERT TABLE " << tableName << " TO TEXT before inserting.\n";
+            return false;
         }
 
-        //headers
-        std::string line, header1, header2;
-        std::getline(table1File, header1);
-        std::getline(table2File, header2);
-        auto headers1 = tokenize(header1, ',');
-        auto headers2 = tokenize(header2, ',');
-
-        int joinIdx1 = -1, joinIdx2 = -1;
-        for (size_t i = 0; i < headers1.size(); ++i)
-            if (convertToLower(headers1[i]) == joinCol1) joinIdx1 = i;
-        for (size_t i = 0; i < headers2.size(); ++i)
-            if (convertToLower(headers2[i]) == joinCol2) joinIdx2 = i;
-        if (joinIdx1 == -1 || joinIdx2 == -1) {
-            std::cout << "Error: Join columns not found.\n";
-            return;
+        //check if table exists before inserting
+        std::string path = "database/" + tableName + ".txt";
+        if (!fs::exists(path)) {
+            out() << "Error: Table '" << tableName << "' does not exist.\n";
+            return false;
         }
 
-        //column selection
-        std::vector<std::string> selectedCols = columns == "*" ? std::vector<std::string>{"*"} : tokenize(columns, ',');
-        for (auto& col : selectedCols) {
-            col.erase(0, col.find_first_not_of(" \t"));
-            col.erase(col.find_last_not_of(" \t") + 1);
+        //the table is appended to by one writer at a time, of any process, until the loader is closed
+        if (!lock.lock(tableName)) {
+            out() << "Error: Could not lock table '" << tableName << "' for writing.\n";
+            return false;
+        }
+        std::ifstream checkFile(path);
+        std::string headerLine;
+        std::getline(checkFile, headerLine);
+        splitRow(headerLine, headers);
+        types = loadSchema(tableName, headers.size());
+        typed = std::any_of(types.begin(), types.end(), [](ValueType type) { return type != ValueType::Any; });
+
+        if (!appender.open(path)) {
+            out() << "Error: Could not open table '" << tableName << "' for writing.\n";
+            return false;
         }
+        firstOffset = committedEnd = appender.size();
+        deletedRows = lock.deletedRows();
+
+        //rows are added to the table's zone map as they are written. a table without one, or with one
+        //that no longer matches its file, has it built from its rows first
+        zonesReady = zones.load(tableName) || zones.build(tableName);
+
+        //open every index of the table once for the whole load
+        for (const auto& index : loadIndexes(tableName)) {
+            int col = findColumn(headers, index.column);
+            auto tree = std::make_unique<BPlusTree>();
+            if (col >= 0 && tree->open(indexPath(tableName, index.name))) {
+                indexTrees.emplace_back(col, std::move(tree));
+            }
+        }
+        return true;
+    }
 
-        //combined headers
-        std::vector<std::string> combinedHeaders;
-        for (const auto& h : headers1) combinedHeaders.push_back(table1 + "." + h);
-        for (const auto& h : headers2) combinedHeaders.push_back(table2 + "." + h);
+    //appends the rows and commits them with one write (and fdatasync with --sync), together with
+    //tombstones for the rows in deleted. returns false without writing anything if a row is
+    //rejected, with badRow set to its position (see rowProblem), or false with badRow = npos if
+    //writing failed.
+    bool appendBatch(const std::vector<std::string_view>& input, size_t& badRow,
+                     const std::vector<Tombstone>& deleted = {}) {
+        for (size_t i = 0; i < input.size(); ++i) {
+            if (countFields(input[i]) != headers.size()) {
+                badRow = i;
+                return false;
+            }
+        }
 
-        std::vector<int> selectedIndices;
-        if (selectedCols[0] == "*") {
-            for (size_t i = 0; i < combinedHeaders.size(); ++i) selectedIndices.push_back(i);
-        } else {
-            for (const auto& col : selectedCols) {
-                bool found = false;
-                for (size_t i = 0; i < combinedHeaders.size(); ++i) {
-                    if (convertToLower(combinedHeaders[i]) == convertToLower(col)) {
-                        selectedIndices.push_back(i);
-                        found = true;
-                        break;
-                    }
+        //values of typed columns are checked and written in their stored form
+        const std::vector<std::string_view>* batch = &input;
+        std::vector<std::string_view> values;
+        if (typed) {
+            rows.assign(input.begin(), input.end());
+            rewritten.resize(input.size());
+            std::vector<std::string> stored(headers.size());
+            for (size_t i = 0; i < input.size(); ++i) {
+                splitRow(input[i], values);
+                for (size_t col = values.size(); col < stored.size(); ++col) stored[col].clear();
+                if (!normalizeRow(values, stored)) {
+                    badRow = i;
+                    return false;
                 }
-                if (!found) {
-                    std::cout << "Error: Column '" << col << "' not found in joined tables.\n";
-                    return;
+                if (std::equal(values.begin(), values.end(), stored.begin())) continue;
+                rewritten[i] = joinValues(stored);
+                rows[i] = rewritten[i];
+            }
+            batch = &rows;
+        }
+
+        lock.beginWrite();
+        rowOffsets.clear();
+        for (const auto& row : *batch) rowOffsets.push_back(appender.append(row));
+
+        bool committed = appender.commit(settings.syncWrites) && appendTombstones(tableName, deleted, settings.syncWrites);
+        //indexes and zones learn the rows only once they are committed: the next writer cuts off a
+        //failed batch and reuses its offsets for other rows
+        if (committed && (!indexTrees.empty() || zonesReady)) {
+            for (size_t i = 0; i < batch->size(); ++i) {
+                std::string_view row = (*batch)[i];
+                splitRow(row, values);
+                if (zonesReady) zones.add(rowOffsets[i], row.size() + 1, values);
+                for (auto& [col, tree] : indexTrees) {
+                    if (col >= static_cast<int>(values.size())) continue;
+                    tree->insert(indexEntryKey(std::string(values[col]), rowOffsets[i]), rowOffsets[i]);
                 }
             }
         }
+        //a zone map that was not saved no longer matches the table, and is rebuilt by the next load or
+        //filtered scan
+        zonesReady = committed && zonesReady && zones.save(tableName);
+        tableCache.invalidate(tableName);
+
+        //readers see the batch once it is all written; a failed batch is cut off by the next writer
+        if (committed) {
+            committedEnd = appender.size();
+            deletedRows += deleted.size();
+            lock.publish(committedEnd, deletedRows);
+        }
+        badRow = std::string::npos;
+        return committed;
+    }
 
-        //print header
-        for (size_t i = 0; i < selectedIndices.size(); ++i) {
-            std::cout << combinedHeaders[selectedIndices[i]];
-            if (i < selectedIndices.size() - 1) std::cout << ",";
-        }
-        std::cout << "\n";
-
-        //load data
-        std::vector<std::vector<std::string>> table1Data, table2Data;
-        table1File.clear(); table1File.seekg(0); std::getline(table1File, line);
-        while (std::getline(table1File, line)) table1Data.push_back(tokenize(line, ','));
-        table2File.clear(); table2File.seekg(0); std::getline(table2File, line);
-        while (std::getline(table2File, line)) table2Data.push_back(tokenize(line, ','));
-
-        //join and display
-        for (const auto& row1 : table1Data) {
-            for (const auto& row2 : table2Data) {
-                if (row1[joinIdx1] == row2[joinIdx2]) {
-                    bool pass = true;
-
-                    if (!whereCol.empty()) {
-                        std::string val;
-                        bool found = false;
-
-                        if (whereTable == table1) {
-                            for (size_t i = 0; i < headers1.size(); ++i) {
-                                if (convertToLower(headers1[i]) == whereCol) {
-                                    val = row1[i]; found = true; break;
-                                }
-                            }
-                        } else if (whereTable == table2) {
-                            for (size_t i = 0; i < headers2.size(); ++i) {
-                                if (convertToLower(headers2[i]) == whereCol) {
-                                    val = row2[i]; found = true; break;
-                                }
-                            }
-                        }
-
-                        if (found) {
-                            //comparison
-                            if (whereOp == "=") pass = val == whereVal;
-                            else if (whereOp == "!=") pass = val != whereVal;
-                            else {
-                                double dVal = std::stod(val), dTarget = std::stod(whereVal);
-                                if (whereOp == ">") pass = dVal > dTarget;
-                                else if (whereOp == "<") pass = dVal < dTarget;
-                                else if (whereOp == ">=") pass = dVal >= dTarget;
-                                else if (whereOp == "<=") pass = dVal <= dTarget;
-                            }
-                        } else pass = false;
-                    }
+    //lets other writers append; the loader cannot be used after this
+    void close() { lock.unlock(); }
 
-                    if (!pass) continue;
+    //the bytes of the table file holding the rows committed through this loader
+    std::uint64_t appendedFrom() const { return firstOffset; }
+    std::uint64_t appendedTo() const { return committedEnd; }
 
-                    std::vector<std::string> combinedRow = row1;
-                    combinedRow.insert(combinedRow.end(), row2.begin(), row2.end());
+    //tombstones of the table, with those committed through this loader
+    std::uint64_t tombstones() const { return deletedRows; }
 
-                    for (size_t i = 0; i < selectedIndices.size(); ++i) {
-                        std::cout << combinedRow[selectedIndices[i]];
-                        if (i < selectedIndices.size() - 1) std::cout << ",";
-                    }
-                    std::cout << "\n";
-                }
+    //why appendBatch rejected a row, to follow "Row N" or "Line N of 'file'" in an error
+    std::string rowProblem(std::string_view row) const {
+        size_t count = countFields(row);
+        if (count != headers.size()) {
+            return "has " + std::to_string(count) + " values, table '" + tableName + "' has " +
+                   std::to_string(headers.size()) + " columns.";
+        }
+        std::vector<std::string_view> values;
+        std::string stored;
+        splitRow(row, values);
+        for (size_t col = 0; col < values.size(); ++col) {
+            if (!normalizeValue(types[col], values[col], stored)) {
+                return "has value '" + std::string(values[col]) + "' for " + typeName(types[col]) + " column '" +
+                       headers[col] + "'.";
             }
         }
-    } else {
-        std::cout << "Error: Invalid JOIN syntax.\n";
+        return "could not be written.";
     }
-}
 
+private:
+    bool normalizeRow(const std::vector<std::string_view>& values, std::vector<std::string>& stored) const {
+        for (size_t col = 0; col < values.size(); ++col) {
+            if (!normalizeValue(types[col], values[col], stored[col])) return false;
+        }
+        return true;
+    }
 
+    std::string tableName;
+    AppendLock lock;
+    std::uint64_t firstOffset = 0, committedEnd = 0;
+    std::uint64_t deletedRows = 0; //tombstones of the table
+    std::vector<std::string> headers;
+    std::vector<ValueType> types;
+    bool typed = false;
+    std::vector<std::string_view> rows;     //the batch with rewritten rows swapped in
+    std::vector<std::string> rewritten;
+    std::vector<std::uint64_t> rowOffsets;  //where each row of the batch was appended
+    TableAppender appender;
+    std::vector<std::pair<int, std::unique_ptr<BPlusTree>>> indexTrees;
+    ZoneMap zones;
+    bool zonesReady = false;
+};
+
+void refreshViews(const std::string& tableName, std::uint64_t from, std::uint64_t to);
+void recomputeViews(const std::string& tableName);
+
+//func to insert values into a table (file), one line per (...) group
+void addToTable(const InsertStmt& stmt) {
+    const std::string& tableName = stmt.table;
+    TableLoader loader;
+    if (rejectViewWrite(tableName) || !loader.open(tableName)) return;
+
+    std::vector<std::string> lines;
+    for (const auto& row : stmt.rows) {
+        std::vector<std::string> values;
+        for (const auto& value : row) values.push_back(value.raw);
+        lines.push_back(joinValues(values));
+    }
+    std::vector<std::string_view> batch(lines.begin(), lines.end());
 
-//process the SQL command and route to appropriate handler function
-void executeSqlCommand(const std::string& sql_cmd) {
-    //convert to lowercase for case-insensitive command matching
-    std::string lowerCmd = convertToLower(sql_cmd);
-    
-    //route to appropriate function based on command type
-    if (lowerCmd.find("create table") == 0) {
-        buildTable(sql_cmd);
-    } else if (lowerCmd.find("insert into") == 0) {
-        addToTable(sql_cmd);
-    } else if (lowerCmd.find("desc") == 0) {
-        describeTable(sql_cmd);  
-    } else if (lowerCmd.find("select") == 0) {
-        //determine if it's a JOIN query or a simple SELECT
-        if (lowerCmd.find("join") != std::string::npos) {
-            processJoin(sql_cmd);
+    size_t badRow;
+    if (!loader.appendBatch(batch, badRow)) {
+        if (badRow == std::string::npos) {
+            out() << "Error: Could not write to table '" << tableName << "'.\n";
         } else {
-            //handle regular SELECT statements with or without WHERE clause
-            std::regex selectRegex;
-            std::smatch match;
-            
-            //handle SELECT with WHERE clause
-            if (lowerCmd.find("where") != std::string::npos) {
-                  selectRegex = std::regex( R"(SELECT\s+(.+?)\s+FROM\s+(\w+)\s+WHERE\s+(\w+)\s*(=|!=|>=|<=|<|>)\s*'?(.*?)'?(?:\s|$))",std::regex::icase  );
-
-                if (std::regex_search(sql_cmd, match, selectRegex)) {
-                    //extract components from the regex match
-                    std::string columns = match[1];
-                    std::string tableName = convertToLower(match[2]);
-                    std::string whereCol = convertToLower(match[3]);
-                   // std::string whereValue = match[4];
-		    std::string whereOp = match[4];
-                    std::string whereValue = match[5];
-                    
-                    //parse the column list
-                    std::vector<std::string> selectedCols;
-                    if (columns == "*") {
-                        selectedCols.push_back("*");
-                    } else {
-                        //split comma-separated column list and trim spaces
-                        std::stringstream ss(columns);
-                        std::string col;
-                        while (std::getline(ss, col, ',')) {
-                            col.erase(0, col.find_first_not_of(" \t"));
-                            col.erase(col.find_last_not_of(" \t") + 1);
-                            selectedCols.push_back(col);
-                        }
-                    }
-                    
-                    //display the table with column selection and filtering
-                    showTableWithFilters(tableName, selectedCols, whereCol,whereOp,  whereValue);
-                } else {
-                    std::cout << "Error: Invalid SELECT WITH WHERE syntax.\n";
-                }
-            } 
-            //handle simple SELECT without WHERE
-            else {
-                selectRegex = std::regex("SELECT\\s+(.+?)\\s+FROM\\s+(\\w+)", std::regex::icase);
-                
-                if (std::regex_search(sql_cmd, match, selectRegex)) {
-                    //extract components from regex match
-                    std::string columns = match[1];
-                    std::string tableName = convertToLower(match[2]);
-                    
-                    //parse column list
-                    std::vector<std::string> selectedCols;
-                    if (columns == "*") {
-                        selectedCols.push_back("*");
-                    } else {
-                        //split comma-separated column list and trim spaces
-                        std::stringstream ss(columns);
-                        std::string col;
-                        while (std::getline(ss, col, ',')) {
-                            col.erase(0, col.find_first_not_of(" \t"));
-                            col.erase(col.find_last_not_of(" \t") + 1);
-                            selectedCols.push_back(col);
-                        }
-                    }
-                    
-                    //display table with column selection
-                    showTableWithFilters(tableName, selectedCols);
-                } else {
-                    std::cout << "Error: Invalid SELECT syntax.\n";
-                }
+            out() << "Error: Row " << badRow + 1 << " " << loader.rowProblem(batch[badRow]) << "\n";
+        }
+        return;
+    }
+
+    if (lines.size() == 1) out() << "Values inserted into '" << tableName << "' successfully.\n";
+    else out() << lines.size() << " rows inserted into '" << tableName << "' successfully.\n";
+
+    //the views over the table get the new rows before other writers may go on, so concurrent writers
+    //refresh them one at a time
+    refreshViews(tableName, loader.appendedFrom(), loader.appendedTo());
+    loader.close();
+}
+
+//func to bulk load the lines of a CSV file into a table
+void copyIntoTable(const CopyStmt& stmt) {
+    const std::string& tableName = stmt.table;
+    std::ifstream inFile(stmt.path, std::ios::binary);
+    if (!inFile) {
+        out() << "Error: Could not open file '" << stmt.path << "'.\n";
+        return;
+    }
+    TableLoader loader;
+    if (rejectViewWrite(tableName) || !loader.open(tableName)) return;
+
+    //read the file in large chunks; the complete lines of each chunk are loaded as one batch
+    //and a partial last line is carried over to the next chunk
+    const size_t chunkSize = TableAppender::kBufferSize;
+    std::string data;
+    std::vector<std::string_view> batch;
+    std::vector<size_t> lineNumbers;
+    size_t lineNumber = 0, copied = 0;
+    bool skipHeader = stmt.header;
+
+    while (true) {
+        size_t carried = data.size();
+        data.resize(carried + chunkSize);
+        inFile.read(&data[carried], chunkSize);
+        data.resize(carried + inFile.gcount());
+        bool last = !inFile;
+
+        size_t end = data.size();
+        if (!last) {
+            size_t newline = data.rfind('\n');
+            end = newline == std::string::npos ? 0 : newline + 1;
+        }
+
+        batch.clear();
+        lineNumbers.clear();
+        for (size_t pos = 0; pos < end;) {
+            size_t newline = data.find('\n', pos);
+            if (newline == std::string::npos || newline > end) newline = end;
+            std::string_view line(data.data() + pos, newline - pos);
+            pos = newline + 1;
+            ++lineNumber;
+
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            if (skipHeader) {
+                skipHeader = false;
+                continue;
             }
+            if (line.empty()) continue;
+            batch.push_back(line);
+            lineNumbers.push_back(lineNumber);
         }
-    } else {
-        std::cout << "Error: Unrecognized SQL command.\n";
+
+        size_t badRow;
+        if (!batch.empty() && !loader.appendBatch(batch, badRow)) {
+            if (badRow == std::string::npos) {
+                out() << "Error: Could not write to table '" << tableName << "'.\n";
+            } else {
+                out() << "Error: Line " << lineNumbers[badRow] << " of '" << stmt.path << "' "
+                      << loader.rowProblem(batch[badRow]) << "\n";
+            }
+            out() << copied << " rows were copied before the failing batch.\n";
+            refreshViews(tableName, loader.appendedFrom(), loader.appendedTo());
+            loader.close();
+            return;
+        }
+        copied += batch.size();
+
+        data.erase(0, end);
+        if (last) break;
+    }
+
+    out() << copied << " rows copied into '" << tableName << "' successfully.\n";
+    refreshViews(tableName, loader.appendedFrom(), loader.appendedTo());
+    loader.close();
+}
+
+//func to build a B+tree index over one column of a table
+void createIndex(const CreateIndexStmt& stmt) {
+    const std::string& indexName = stmt.index;
+    const std::string& tableName = stmt.table;
+    const std::string& column = stmt.column;
+
+    //index entries point at byte offsets in the text file
+    if (isColumnarTable(tableName)) {
+        out() << "Error: Indexes are only supported on text tables.\n";
+        return;
+    }
+
+    //no rows are appended while the index is built, so it covers every row of the file
+    std::string path = "database/" + tableName + ".txt";
+    AppendLock lock;
+    CsvReader reader;
+    if (!fs::exists(path) || !lock.lock(tableName) || !reader.open(path)) {
+        out() << "Error: Table '" << tableName << "' does not exist.\n";
+        return;
+    }
+
+    std::string_view line;
+    std::vector<std::string> headers;
+    reader.nextLine(line);
+    splitRow(line, headers);
+    int col = findColumn(headers, column);
+    if (col < 0) {
+        out() << "Error: Column '" << column << "' not found in table.\n";
+        return;
+    }
+    for (const auto& index : loadIndexes(tableName)) {
+        if (index.name == indexName) {
+            out() << "Error: Index '" << indexName << "' already exists on '" << tableName << "'.\n";
+            return;
+        }
+    }
+
+    //collect (key, row offset) for every row that is not deleted, then bulk load the tree in key order
+    DeletionMap deleted;
+    deleted.load(tableName, reader.fileId(), lock.deletedRows());
+    std::vector<std::pair<std::string, std::uint64_t>> entries;
+    std::uint64_t offset = line.size() + 1;
+    std::vector<std::string_view> values;
+    size_t cursor = 0;
+    while (reader.nextLine(line)) {
+        splitRow(line, values);
+        if (col < static_cast<int>(values.size()) && (deleted.empty() || !deleted.contains(offset, cursor))) {
+            entries.emplace_back(indexEntryKey(std::string(values[col]), offset), offset);
+        }
+        offset += line.size() + 1;
+    }
+    std::sort(entries.begin(), entries.end());
+
+    if (!BPlusTree::create(indexPath(tableName, indexName), entries)) {
+        out() << "Error: Could not write index '" << indexName << "'.\n";
+        return;
     }
+    registerIndex(tableName, {indexName, column});
+    out() << "Index '" << indexName << "' created on '" << tableName << "(" << column << ")'.\n";
 }
 
-//main function, entry point of the program
-int main(int argc, char* argv[]) {
-    //check if a command line argument is provided
-    if (argc < 2) {
-        std::cout << "Usage: " << argv[0] << " 'SQL command'\n";
-        return 1;
+//func to migrate a table between the text and columnar storage formats
+void convertTable(const ConvertStmt& stmt) {
+    const std::string& tableName = stmt.table;
+    bool toColumnar = stmt.toColumnar;
+    std::string formatName = !toColumnar ? "text" : stmt.compressed ? "compressed columnar" : "columnar";
+    std::string textPath = "database/" + tableName + ".txt";
+    std::string columnarPath = "database/" + tableName + ".col";
+    if (rejectViewWrite(tableName)) return;
+
+    AppendLock lock;
+    TableScan scan;
+    if ((fs::exists(textPath) && !lock.lock(tableName)) || !scan.open(tableName)) {
+        out() << "Error: Table '" << tableName << "' does not exist.\n";
+        return;
+    }
+    if (scan.columnar == toColumnar && (!toColumnar || scan.compressed() == stmt.compressed)) {
+        out() << "Table '" << tableName << "' is already in " << formatName << " format.\n";
+        return;
+    }
+
+    //write the new file next to the old one and swap it in once complete
+    std::string target = toColumnar ? columnarPath : textPath;
+    bool written;
+    if (toColumnar) {
+        written = writeColumnTable(target + ".tmp", scan.headers,
+                                   [&](Row& row) { return scan.next(row); },
+                                   [&]() { scan.rewind(); }, stmt.compressed);
+    } else {
+        std::ofstream outFile(target + ".tmp");
+        Row row;
+        auto writeRow = [&](const Row& cells) {
+            for (size_t i = 0; i < cells.size(); ++i) {
+                outFile << cells[i];
+                if (i < cells.size() - 1) outFile << ",";
+            }
+            outFile << "\n";
+        };
+        writeRow(scan.headers);
+        while (scan.next(row)) writeRow(row);
+        written = static_cast<bool>(outFile);
+    }
+    if (!written) {
+        fs::remove(target + ".tmp");
+        out() << "Error: Could not convert table '" << tableName << "'.\n";
+        return;
+    }
+
+    fs::rename(target + ".tmp", target);
+    fs::permissions(target,
+                    fs::perms::owner_all | fs::perms::group_all | fs::perms::others_all,
+                    fs::perm_options::replace);
+    fs::remove(toColumnar ? textPath : columnarPath);
+    if (!toColumnar) lock.publishRewrite(fs::file_size(target));
+
+    //the deleted rows were left out of the new file
+    dropTombstones(tableName);
+
+    //indexes hold text file offsets, so they do not survive a conversion; a text table gets a new
+    //zone map
+    dropIndexes(tableName);
+    dropZoneMap(tableName);
+    ZoneMap zones;
+    if (!toColumnar && zones.build(tableName)) zones.save(tableName);
+    tableCache.invalidate(tableName);
+
+    //the rows are the same, only the bytes per row change
+    TableStats stats;
+    if (loadStats(tableName, stats)) {
+        stats.bytes = fs::file_size(target);
+        saveStats(tableName, stats);
     }
-    
-    //get SQL command from command line argument
-    std::string sql_cmd = argv[1];
-    
-    //process SQL command
 
+    out() << "Table '" << tableName << "' converted to " << formatName << " format.\n";
+}
+
+//helper function to collect the statistics the join planner uses: the rows of a table and, per
+//column, its distinct, empty and numeric cells with the range of the numbers
+TableStats collectStats(TableScan& scan) {
+    //distinct cells are counted exactly until a column has kExactDistinct of them, then estimated
+    //from the column's sketch
+    size_t columns = scan.headers.size();
+    std::vector<ColumnZone> zones(columns);
+    std::vector<std::unordered_set<std::string>> seen(columns);
+    TableStats stats;
+    Row row;
+    while (scan.next(row)) {
+        ++stats.rows;
+        for (size_t c = 0; c < row.size() && c < columns; ++c) {
+            zones[c].add(row[c]);
+            if (seen[c].size() <= TableStats::kExactDistinct) seen[c].insert(row[c]);
+        }
+    }
+    stats.bytes = scan.sizeBytes;
+    for (size_t c = 0; c < columns; ++c) {
+        ColumnStats column;
+        column.name = scan.headers[c];
+        column.distinct = seen[c].size() <= TableStats::kExactDistinct ? seen[c].size() : zones[c].distinct();
+        column.empty = zones[c].empty;
+        column.numbers = zones[c].numbers;
+        column.minNumber = zones[c].minNumber;
+        column.maxNumber = zones[c].maxNumber;
+        stats.columns.push_back(std::move(column));
+    }
+    return stats;
+}
 
-    executeSqlCommand(sql_cmd);
-    
-    return 0;
+//func to collect and save the statistics of a table
+void analyzeTable(const AnalyzeStmt& stmt) {
+    const std::string& tableName = stmt.table;
+    TableScan scan;
+    if (!scan.open(tableName)) {
+        out() << "Error: Table '" << tableName << "' does not exist.\n";
+        return;
+    }
+    TableStats stats = collectStats(scan);
+    saveStats(tableName, stats);
+    out() << "Table '" << tableName << "' analyzed: " << stats.rows << " rows, " << stats.columns.size()
+          << " columns.\n";
 }
 
+//func to display selected columns of a columnar table with optional filtering
+void showColumnarTable(const std::string& tableName, const std::vector<std::string>& selectedCols,
+                       const Condition* where, const std::vector<OrderKey>& orderBy,
+                       std::optional<std::uint64_t> limit) {
+    ColumnTable table;
+    if (!table.open("database/" + tableName + ".col")) {
+        out() << "Error: Table '" << tableName << "' could not be read.\n";
+        return;
+    }
+    const auto& headers = table.columnNames();
 
+    //determine which columns to display
+    std::vector<int> selectedIndexes;
+    if (!selectColumns(headers, selectedCols, selectedIndexes)) return;
+
+    auto types = loadSchema(tableName, headers.size());
+    auto resolve = [&](const ColumnRef& ref) {
+        return !ref.table.empty() && ref.table != tableName ? -1 : findColumn(headers, ref.column);
+    };
+    RowFilter filter;
+    if (where && !prepareFilter(*where, types, resolve, filter)) return;
+
+    std::vector<SortColumn> sortColumns;
+    if (!planOrder(orderBy, types, resolve, "table", sortColumns)) return;
+    auto sorter = makeSorter(orderBy, limit);
+
+    //a single range comparison on a numeric column compares the stored values without parsing text
+    int whereIndex = -1;
+    Predicate predicate;
+    std::string error;
+    if (where && where->type == Condition::Type::Compare && !filter.neverMatches()) {
+        whereIndex = filter.columns()[0];
+        predicate.prepare(types[whereIndex], where->op, where->value.text, headers[whereIndex], error);
+    }
+    bool numericRange = whereIndex >= 0 && predicate.comparesNumbers() &&
+                        (table.columnType(whereIndex) == ColumnType::Int64 ||
+                         table.columnType(whereIndex) == ColumnType::Double);
+
+    //a filter that reads one encoded column is run once per dictionary entry, so each row only
+    //looks up its code, and a run-length column is filtered a run at a time
+    int codeColumn = -1;
+    std::vector<char> codeMatches;
+    bool missingMatches = false;
+    if (where && !numericRange && !filter.neverMatches() && filter.columns().size() == 1 &&
+        table.encoded(filter.columns()[0])) {
+        codeColumn = filter.columns()[0];
+        std::vector<std::string_view> entry(codeColumn + 1);
+        for (std::uint32_t code = 0; code < table.dictionarySize(codeColumn); ++code) {
+            entry[codeColumn] = table.dictionaryEntry(codeColumn, code);
+            codeMatches.push_back(filter(entry));
+        }
+        missingMatches = filter(std::vector<std::string_view>());
+    }
+    bool runSkipping = codeColumn >= 0 && table.columnType(codeColumn) == ColumnType::RunLength && !table.ragged();
+
+    PlanOperator *sortOp = nullptr, *projectOp = nullptr, *filterOp = nullptr, *scanOp = nullptr;
+    if (activeProfile()) {
+        int depth = 0;
+        if ((sortOp = addSortOperator(depth, orderBy, limit))) ++depth;
+        projectOp = addOperator(depth++, projectLabel(selectedCols), Phase::Output);
+        if (where) {
+            std::string label = filterLabel(*where, filter, types);
+            if (numericRange) label += ", compared as stored numbers";
+            else if (runSkipping) label += ", decided per run of codes";
+            else if (codeColumn >= 0) label += ", compared as dictionary codes";
+            filterOp = addOperator(depth++, label, Phase::Predicate);
+        }
+        scanOp = addOperator(depth, columnarLabel(tableName, table), Phase::Parse);
+    }
+    if (!beginExecution()) return;
 
+    //display header row
+    sendHeader(headers, selectedIndexes);
+
+    if (filter.neverMatches()) return; //invalid column matches no rows
+
+    //only the pages of the WHERE columns and the selected columns are touched. each WHERE column
+    //gets its own scratch space, since numbers are formatted into it
+    char scratch[ColumnTable::kScratchSize];
+    const auto& filterColumns = filter.columns();
+    std::vector<char> filterScratch(filterColumns.size() * ColumnTable::kScratchSize);
+    std::vector<std::string_view> cells;
+    std::string line, key, text;
+    RowProbe probe(analyzing());
+    std::uint64_t run = 0;
+    for (std::uint64_t row = 0; row < table.rowCount() && !(sorter && sorter->done()); ++row) {
+        //runs whose code fails the filter are passed over without visiting their rows
+        if (runSkipping) {
+            while (table.runEnd(codeColumn, run) <= row) ++run;
+            if (!codeMatches[table.runCode(codeColumn, run)]) {
+                row = table.runEnd(codeColumn, run) - 1;
+                continue;
+            }
+        }
+        probe.startRow();
+        size_t width = table.rowWidth(row);
+        probe.stage(scanOp);
+        if (numericRange) {
+            bool matchesCondition = whereIndex < static_cast<int>(width) &&
+                                    predicate.matchesNumber(table.numberAt(whereIndex, row));
+            probe.stage(filterOp, matchesCondition);
+            if (!matchesCondition) continue;
+        } else if (runSkipping) {
+            probe.stage(filterOp);
+        } else if (codeColumn >= 0) {
+            bool matchesCondition = codeColumn < static_cast<int>(width) ? codeMatches[table.codeAt(codeColumn, row)]
+                                                                         : missingMatches;
+            probe.stage(filterOp, matchesCondition);
+            if (!matchesCondition) continue;
+        } else if (where) {
+            cells.resize(width);
+            for (size_t i = 0; i < filterColumns.size() && filterColumns[i] < static_cast<int>(width); ++i) {
+                cells[filterColumns[i]] =
+                    table.cell(filterColumns[i], row, filterScratch.data() + i * ColumnTable::kScratchSize);
+            }
+            bool matchesCondition = filter(cells);
+            probe.stage(filterOp, matchesCondition);
+            if (!matchesCondition) continue;
+        }
 
+        //display selected columns
+        line.clear();
+        for (size_t i = 0; i < selectedIndexes.size(); ++i) {
+            int idx = selectedIndexes[i];
+            if (idx < static_cast<int>(width)) {
+                line += table.cell(idx, row, scratch);
+            }
+            if (i < selectedIndexes.size() - 1) line += ',';
+        }
+        if (!sorter) {
+            text += line;
+            text += '\n';
+            if (text.size() >= 64 * 1024) {
+                resultSink().rows(text);
+                text.clear();
+            }
+            probe.stage(projectOp);
+            continue;
+        }
+        key.clear();
+        for (const auto& col : sortColumns) {
+            std::string_view cell = col.index < static_cast<int>(width) ? table.cell(col.index, row, scratch) : "";
+            appendSortKey(key, col.type, cell, col.descending);
+        }
+        probe.stage(projectOp);
+        sorter->add(key, line);
+        probe.stage(sortOp, false);
+    }
+    probe.flush();
+    if (!text.empty()) resultSink().rows(text);
+    if (sorter) finishSorter(*sorter, sortOp, !orderBy.empty());
+}
+
+//helper function to pick the WHERE term an index answers: an equality, IN list, range or BETWEEN on
+//an indexed column that every matching row satisfies, preferring equality and IN. index ranges are
+//numeric, so they cannot answer a range over a TEXT column
+const Condition* indexedTerm(const Condition& where, const std::vector<std::string>& headers,
+                             const std::vector<ValueType>& types, const std::vector<IndexInfo>& indexes,
+                             const IndexInfo*& index) {
+    const Condition* best = nullptr;
+    for (const Condition* term : conjuncts(where)) {
+        bool equality = term->type == Condition::Type::In ||
+                        (term->type == Condition::Type::Compare && term->op == "=");
+        bool range = (term->type == Condition::Type::Compare && term->op != "=" && term->op != "!=") ||
+                     term->type == Condition::Type::Between;
+        if ((!equality && !range) || (best && !equality)) continue;
+        int column = findColumn(headers, term->column.column);
+        if (column < 0 || (range && types[column] == ValueType::Text)) continue;
+        const IndexInfo* found = findIndex(indexes, term->column.column);
+        if (!found) continue;
+        best = term;
+        index = found;
+        if (equality) break;
+    }
+    return best;
+}
+
+//helper function to look up the offsets of the rows an indexed WHERE term can match, ascending
+std::vector<std::uint64_t> lookupTerm(BPlusTree& tree, const Condition& term, ValueType type) {
+    std::vector<std::uint64_t> offsets;
+    std::string error;
+    auto lookup = [&](const std::string& op, const Literal& value) {
+        Predicate predicate;
+        predicate.prepare(type, op, value.text, term.column.column, error);
+        auto found = lookupIndex(tree, op, predicate.lookupValue());
+        offsets.insert(offsets.end(), found.begin(), found.end());
+    };
+    if (term.type == Condition::Type::Between) {
+        Predicate low, high;
+        low.prepare(type, ">=", term.values[0].text, term.column.column, error);
+        high.prepare(type, "<=", term.values[1].text, term.column.column, error);
+        return lookupIndexBetween(tree, low.lookupValue(), high.lookupValue());
+    }
+    if (term.type != Condition::Type::In) {
+        lookup(term.op, term.value);
+        return offsets;
+    }
+    for (const auto& value : term.values) lookup("=", value);
+    std::sort(offsets.begin(), offsets.end());
+    offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+    return offsets;
+}
+
+//func to display selected columns with optional filtering
+
+void showTableWithFilters(const std::string& tableName, const std::vector<std::string>& selectedCols,
+                          const Condition* where, const std::vector<OrderKey>& orderBy,
+                          std::optional<std::uint64_t> limit) {
+    if (isColumnarTable(tableName)) {
+        showColumnarTable(tableName, selectedCols, where, orderBy, limit);
+        return;
+    }
+
+    //in server mode the parsed rows are already in memory
+    std::string path = "database/" + tableName + ".txt";
+    auto cached = tableCache.get(tableName);
+    CsvReader reader;
+    DeletionMap deleted;
+    TableSnapshot snapshot;
+    std::string_view line;
+    std::vector<std::string> headers;
+    size_t headerLength = 0;
+    if (cached) {
+        headers = cached->headers;
+        snapshot = cached->snapshot;
+    } else {
+        if (!openSnapshot(tableName, reader, deleted, snapshot)) {
+            out() << "Error: Table '" << tableName << "' does not exist.\n";
+            return;
+        }
+
+        //read header line and parse column names
+        reader.nextLine(line);
+        splitRow(line, headers);
+        headerLength = line.size() + 1;
+    }
+
+    //determine which columns to display
+    std::vector<int> selectedIndexes;
+    if (!selectColumns(headers, selectedCols, selectedIndexes)) return;
+
+    //the WHERE constants are parsed once, for the declared types of their columns
+    auto types = loadSchema(tableName, headers.size());
+    auto resolve = [&](const ColumnRef& ref) {
+        return !ref.table.empty() && ref.table != tableName ? -1 : findColumn(headers, ref.column);
+    };
+    RowFilter filter;
+    if (where && !prepareFilter(*where, types, resolve, filter)) return;
+
+    //ORDER BY and LIMIT pass the output lines through a sorter
+    std::vector<SortColumn> sortColumns;
+    if (!planOrder(orderBy, types, resolve, "table", sortColumns)) return;
+    auto sorter = makeSorter(orderBy, limit);
+
+    //an index on a column the WHERE pins down lets us seek straight to the candidate rows, which
+    //are then filtered by the whole expression
+    const IndexInfo* index = nullptr;
+    const Condition* indexed = nullptr;
+    auto indexes = loadIndexes(tableName);
+    if (where && !filter.neverMatches()) indexed = indexedTerm(*where, headers, types, indexes, index);
+    //the tree is read while no writer changes it; a writer at work, or a table file replaced since it
+    //was opened, leaves the query to a scan
+    AppendLock indexLock;
+    BPlusTree tree;
+    bool useIndex = indexed && indexLock.tryLockShared(tableName) &&
+                    readSnapshot(tableName).generation == snapshot.generation &&
+                    tree.open(indexPath(tableName, index->name));
+
+    //a scan reads only the blocks the zone map cannot rule out
+    ScanRanges ranges;
+    std::uintmax_t scanBytes = 0;
+    if (!useIndex && !cached) {
+        ranges = planRanges(tableName, where ? &filter : nullptr, headerLength, reader.size());
+        for (const auto& [begin, end] : ranges.ranges) scanBytes += end - begin;
+    }
+
+    //large files are filtered in parallel, one line-aligned morsel per task. sorted rows are
+    //numbered in the order they reach the sorter, so they are passed on in table order; a LIMIT
+    //without ORDER BY reads sequentially to stop early
+    MorselOptions options;
+    options.threads = settings.scanThreads;
+    options.ordered = settings.orderedScans || sorter;
+    bool keylessLimit = sorter && orderBy.empty();
+    MappedFile file;
+    bool parallel = !useIndex && !cached && options.threads > 1 && !keylessLimit &&
+                    scanBytes >= 2 * options.morselSize && file.open(path, reader.size()) &&
+                    file.fileId() == reader.fileId();
+
+    PlanOperator *sortOp = nullptr, *projectOp = nullptr, *filterOp = nullptr, *scanOp = nullptr;
+    if (activeProfile()) {
+        int depth = 0;
+        if ((sortOp = addSortOperator(depth, orderBy, limit))) ++depth;
+        projectOp = addOperator(depth++, projectLabel(selectedCols), Phase::Output);
+        if (where) filterOp = addOperator(depth++, filterLabel(*where, filter, types), Phase::Predicate);
+        std::string scan;
+        if (useIndex) {
+            scan = "Index Scan on " + tableName + " using " + index->name + " (" + conditionText(*indexed) +
+                   deletedLabel(deleted) + ")";
+        } else if (cached) {
+            scan = "Cached Scan on " + tableName + " (" + std::to_string(cached->rows.size()) + " rows in memory)";
+        } else if (parallel) {
+            scan = "Parallel Scan on " + tableName + " (text, " + byteLabel(file.data().size()) + rangeLabel(ranges) +
+                   deletedLabel(deleted) + ", " + std::to_string(options.threads) + " threads, " +
+                   byteLabel(options.morselSize) + " morsels, " + (options.ordered ? "ordered" : "unordered") + ")";
+        } else {
+            scan = "Seq Scan on " + tableName + " (text, " + byteLabel(reader.size()) + rangeLabel(ranges) +
+                   deletedLabel(deleted) + ")";
+        }
+        scanOp = addOperator(depth, scan, Phase::Parse);
+    }
+    if (!beginExecution()) return;
+    bool profiled = analyzing();
+
+    //display header row
+    sendHeader(headers, selectedIndexes);
+
+    if (filter.neverMatches()) return;
+
+    //filter one data row and append its selected columns to text; rows read from the file are
+    //views into the reader's buffer, so only the printed values are touched. rows that are
+    //sorted are appended as sort records instead of lines
+    auto processRow = [&](const auto& values, std::string& text, RowProbe& probe) {
+        //apply WHERE id present
+        if (where) {
+            bool pass = filter(values);
+            probe.stage(filterOp, pass);
+            if (!pass) return;
+        }
+
+        thread_local std::string line, key;
+        std::string& target = sorter ? line : text;
+        if (sorter) line.clear();
+
+        //display selected columns
+        for (size_t i = 0; i < selectedIndexes.size(); ++i) {
+            int idx = selectedIndexes[i];
+            if (idx < static_cast<int>(values.size())) {
+                target += values[idx];
+            }
+            if (i < selectedIndexes.size() - 1) target += ',';
+        }
+        if (!sorter) {
+            text += '\n';
+            probe.stage(projectOp);
+            return;
+        }
+        buildSortKey(key, sortColumns, values);
+        appendSortRecord(text, key, line);
+        probe.stage(projectOp);
+    };
+
+    //output is gathered in a buffer and written in large pieces
+    std::string text;
+    auto emitText = [&](const std::string& output) {
+        if (!sorter) {
+            if (!output.empty()) resultSink().rows(output);
+            return;
+        }
+        SectionTimer timer(sortOp);
+        sorter->addRecords(output);
+    };
+    auto flushText = [&](bool force) {
+        if (force || text.size() >= 64 * 1024) {
+            emitText(text);
+            text.clear();
+        }
+    };
+    auto finishOutput = [&]() {
+        flushText(true);
+        if (sorter) finishSorter(*sorter, sortOp, !orderBy.empty());
+    };
+    auto stopped = [&]() { return sorter && sorter->done(); };
+    std::vector<std::string_view> fields;
+
+    if (useIndex) {
+        RowProbe probe(profiled);
+        std::vector<std::uint64_t> offsets = lookupTerm(tree, *indexed, types[findColumn(headers, indexed->column.column)]);
+        indexLock.unlock();
+        for (auto offset : offsets) {
+            probe.startRow();
+            if (cached) {
+                auto it = std::lower_bound(cached->offsets.begin(), cached->offsets.end(), offset);
+                if (it != cached->offsets.end() && *it == offset) {
+                    probe.stage(scanOp);
+                    processRow(cached->rows[it - cached->offsets.begin()], text, probe);
+                }
+            } else if (deleted.empty() || !deleted.contains(offset)) {
+                reader.seek(offset);
+                if (reader.nextLine(line)) {
+                    splitRow(line, fields);
+                    probe.read(scanOp, line.size() + 1);
+                    probe.stage(scanOp);
+                    processRow(fields, text, probe);
+                }
+            }
+            flushText(false);
+            if (stopped()) break;
+        }
+        probe.flush();
+        finishOutput();
+        return;
+    }
+
+    //process and display data rows
+    if (cached) {
+        RowProbe probe(profiled);
+        for (size_t i = 0; i < cached->rows.size(); ++i) {
+            probe.startRow();
+            probe.stage(scanOp);
+            processRow(cached->rows[i], text, probe);
+            flushText(false);
+            if (stopped()) break;
+        }
+        probe.flush();
+        finishOutput();
+        return;
+    }
+
+    if (parallel) {
+        auto filterMorsel = [&](std::string_view lines, std::string& output) {
+            std::vector<std::string_view> values;
+            RowProbe probe(profiled);
+            size_t cursor = 0;
+            while (!lines.empty()) {
+                probe.startRow();
+                size_t newline = lines.find('\n');
+                std::string_view row = lines.substr(0, newline);
+                lines.remove_prefix(newline == std::string_view::npos ? lines.size() : newline + 1);
+                if (!deleted.empty() && deleted.contains(row.data() - file.data().data(), cursor)) {
+                    probe.stage(scanOp, false);
+                    continue;
+                }
+                splitRow(row, values);
+                probe.read(scanOp, row.size() + 1);
+                probe.stage(scanOp);
+                processRow(values, output, probe);
+            }
+        };
+        scanMorsels(rangePieces(file.data(), ranges), options, filterMorsel, emitText);
+        finishOutput();
+        return;
+    }
+
+    RowProbe probe(profiled);
+    size_t cursor = 0;
+    for (const auto& [begin, end] : ranges.ranges) {
+        reader.seek(begin);
+        while (!stopped() && reader.offset() < end) {
+            std::uint64_t offset = reader.offset();
+            probe.startRow();
+            if (!reader.nextLine(line)) break;
+            if (!deleted.empty() && deleted.contains(offset, cursor)) {
+                probe.stage(scanOp, false);
+                continue;
+            }
+            splitRow(line, fields);
+            probe.read(scanOp, line.size() + 1);
+            probe.stage(scanOp);
+            processRow(fields, text, probe);
+            flushText(false);
+        }
+    }
+    probe.flush();
+    finishOutput();
+}
+
+
+//func to compact a text table: its file is rewritten without the deleted rows, and its indexes, zone
+//map and statistics are rebuilt for the rows' new offsets. quiet leaves out the summary, for a
+//compaction DELETE or UPDATE start
+void vacuumTable(const std::string& tableName, bool quiet) {
+    std::string path = "database/" + tableName + ".txt";
+    if (isColumnarTable(tableName)) {
+        if (!quiet) out() << "Table '" << tableName << "' has no deleted rows.\n";
+        return;
+    }
+
+    //no rows are appended or deleted while the table is rewritten
+    AppendLock lock;
+    CsvReader reader;
+    if (!fs::exists(path) || !lock.lock(tableName) || !reader.open(path)) {
+        out() << "Error: Table '" << tableName << "' does not exist.\n";
+        return;
+    }
+    DeletionMap deleted;
+    deleted.load(tableName, reader.fileId(), lock.deletedRows());
+    if (deleted.empty()) {
+        if (!quiet) out() << "Table '" << tableName << "' has no deleted rows.\n";
+        return;
+    }
+
+    std::string_view line;
+    std::vector<std::string> headers;
+    reader.nextLine(line);
+    splitRow(line, headers);
+
+    //the live rows are copied to a new file; each index collects its entries at their new offsets
+    struct RebuiltIndex {
+        std::string path;
+        int column;
+        std::vector<std::pair<std::string, std::uint64_t>> entries;
+    };
+    std::vector<RebuiltIndex> indexes;
+    for (const auto& index : loadIndexes(tableName)) {
+        indexes.push_back({indexPath(tableName, index.name), findColumn(headers, index.column), {}});
+    }
+    std::ofstream outFile(path + ".tmp", std::ios::binary);
+    outFile << line << '\n';
+    std::uint64_t offset = line.size() + 1, newOffset = offset;
+    std::vector<std::string_view> values;
+    size_t cursor = 0;
+    while (reader.nextLine(line)) {
+        bool live = !deleted.contains(offset, cursor);
+        offset += line.size() + 1;
+        if (!live) continue;
+        if (!indexes.empty()) splitRow(line, values);
+        for (auto& index : indexes) {
+            if (index.column < 0 || index.column >= static_cast<int>(values.size())) continue;
+            index.entries.emplace_back(indexEntryKey(std::string(values[index.column]), newOffset), newOffset);
+        }
+        outFile << line << '\n';
+        newOffset += line.size() + 1;
+    }
+    outFile.close();
+    bool written = static_cast<bool>(outFile);
+    for (auto& index : indexes) {
+        std::sort(index.entries.begin(), index.entries.end());
+        written = written && BPlusTree::create(index.path + ".tmp", index.entries);
+    }
+    if (!written) {
+        std::error_code ec;
+        fs::remove(path + ".tmp", ec);
+        for (const auto& index : indexes) fs::remove(index.path + ".tmp", ec);
+        out() << "Error: Could not vacuum table '" << tableName << "'.\n";
+        return;
+    }
+
+    //the new file and its indexes are in place before readers learn that the file was replaced;
+    //until then a reader that opens the new file finds no tombstones for it and skips nothing
+    fs::permissions(path + ".tmp",
+                    fs::perms::owner_all | fs::perms::group_all | fs::perms::others_all,
+                    fs::perm_options::replace);
+    fs::rename(path + ".tmp", path);
+    for (const auto& index : indexes) fs::rename(index.path + ".tmp", index.path);
+    lock.publishRewrite(newOffset);
+    dropTombstones(tableName);
+
+    dropZoneMap(tableName);
+    ZoneMap zones;
+    if (zones.build(tableName)) zones.save(tableName);
+    tableCache.invalidate(tableName);
+
+    //statistics are kept up to date only for a table that was analyzed
+    TableStats stats;
+    TableScan scan;
+    if (loadStats(tableName, stats) && scan.open(tableName)) saveStats(tableName, collectStats(scan));
+
+    if (!quiet) {
+        out() << "Table '" << tableName << "' vacuumed: " << deleted.size()
+              << (deleted.size() == 1 ? " deleted row" : " deleted rows") << " removed, "
+              << byteLabel(offset - newOffset) << " freed.\n";
+    }
+}
+
+//func to delete the rows of a text table that match a WHERE clause or, given assignments, to update
+//them. each row is deleted with a tombstone and an updated row is appended again with its new values,
+//all in one commit. a table whose deleted rows pass settings.vacuumThreshold is compacted afterwards
+void changeRows(const std::string& tableName, const std::optional<Condition>& where,
+                const std::vector<Assignment>* assignments) {
+    if (rejectViewWrite(tableName)) return;
+    if (isColumnarTable(tableName)) {
+        out() << "Error: Table '" << tableName << "' is stored in columnar format; "
+              << "use CONVERT TABLE " << tableName << " TO TEXT before " << (assignments ? "updating" : "deleting")
+              << " rows.\n";
+        return;
+    }
+
+    //the rows are read under the loader's lock, so the whole file holds committed rows
+    TableLoader loader;
+    if (!loader.open(tableName)) return;
+    CsvReader reader;
+    if (!reader.open("database/" + tableName + ".txt")) {
+        out() << "Error: Table '" << tableName << "' does not exist.\n";
+        return;
+    }
+    DeletionMap deleted;
+    deleted.load(tableName, reader.fileId(), loader.tombstones());
+    std::string_view line;
+    std::vector<std::string> headers;
+    reader.nextLine(line);
+    splitRow(line, headers);
+    std::uint64_t headerLength = line.size() + 1;
+    auto types = loadSchema(tableName, headers.size());
+
+    std::vector<std::pair<int, std::string>> changes;
+    if (assignments) {
+        for (const auto& assignment : *assignments) {
+            int col = findColumn(headers, assignment.column);
+            if (col < 0) {
+                out() << "Error: Column '" << assignment.column << "' not found in table.\n";
+                return;
+            }
+            changes.emplace_back(col, assignment.value.raw);
+        }
+    }
+
+    RowFilter filter;
+    if (where) {
+        const Condition* foreign = findForeignColumn(*where, tableName);
+        if (foreign) {
+            out() << "Error: Column '" << foreign->column.table << "." << foreign->column.column
+                  << "' not found in table.\n";
+            return;
+        }
+        auto resolve = [&](const ColumnRef& ref) {
+            return !ref.table.empty() && ref.table != tableName ? -1 : findColumn(headers, ref.column);
+        };
+        if (!prepareFilter(*where, types, resolve, filter)) return;
+    }
+
+    //a matching row gets a tombstone and, for UPDATE, its new version
+    std::vector<Tombstone> tombstones;
+    std::vector<std::string> updated;
+    std::vector<std::string_view> fields;
+    std::vector<std::string> cells;
+    auto visit = [&](std::uint64_t offset, std::string_view row) {
+        splitRow(row, fields);
+        if (where && !filter(fields)) return;
+        tombstones.push_back({offset, row.size() + 1});
+        if (!assignments) return;
+        cells.assign(fields.begin(), fields.end());
+        if (cells.size() < headers.size()) cells.resize(headers.size());
+        for (const auto& [col, value] : changes) cells[col] = value;
+        updated.push_back(joinValues(cells));
+    };
+
+    //the rows are found through an index on a column the WHERE pins down, or by scanning the blocks
+    //the zone map cannot rule out
+    const IndexInfo* index = nullptr;
+    const Condition* indexed = nullptr;
+    auto indexes = loadIndexes(tableName);
+    if (where && !filter.neverMatches()) indexed = indexedTerm(*where, headers, types, indexes, index);
+    BPlusTree tree;
+    if (indexed && tree.open(indexPath(tableName, index->name))) {
+        for (auto offset : lookupTerm(tree, *indexed, types[findColumn(headers, indexed->column.column)])) {
+            if (!deleted.empty() && deleted.contains(offset)) continue;
+            reader.seek(offset);
+            if (reader.nextLine(line)) visit(offset, line);
+        }
+    } else if (!filter.neverMatches()) {
+        size_t cursor = 0;
+        for (const auto& [begin, end] : planRanges(tableName, where ? &filter : nullptr, headerLength,
+                                                   reader.size()).ranges) {
+            reader.seek(begin);
+            while (reader.offset() < end) {
+                std::uint64_t offset = reader.offset();
+                if (!reader.nextLine(line)) break;
+                if (deleted.empty() || !deleted.contains(offset, cursor)) visit(offset, line);
+            }
+        }
+    }
+
+    size_t changed = tombstones.size();
+    std::vector<std::string_view> batch(updated.begin(), updated.end());
+    size_t badRow;
+    if (changed > 0 && !loader.appendBatch(batch, badRow, tombstones)) {
+        if (badRow == std::string::npos) {
+            out() << "Error: Could not write to table '" << tableName << "'.\n";
+        } else {
+            out() << "Error: An updated row " << loader.rowProblem(batch[badRow]) << "\n";
+        }
+        return;
+    }
+    out() << changed << (changed == 1 ? " row " : " rows ") << (assignments ? "updated in '" : "deleted from '")
+          << tableName << "'.\n";
+
+    //the views over the table are recomputed before other writers may go on; compaction takes the
+    //lock again
+    if (changed > 0) recomputeViews(tableName);
+    std::uint64_t dead = deleted.deadBytes();
+    for (const auto& tombstone : tombstones) dead += tombstone.bytes;
+    std::uint64_t size = loader.appendedTo();
+    loader.close();
+    if (changed > 0 && settings.vacuumThreshold > 0 && dead * 100 >= settings.vacuumThreshold * size) {
+        vacuumTable(tableName, true);
+    }
+}
+
+//an aggregate query resolved against the columns of the rows it reads
+struct AggregatePlan {
+    std::vector<int> groupColumns;
+    std::vector<AggregateSpec> aggregates;
+    std::vector<std::pair<bool, size_t>> outputs; //per select item: aggregate?, index into aggregates or groupColumns
+    std::vector<std::string> labels;              //header row
+    std::vector<SortColumn> order;                //ORDER BY over group keys, then aggregate results
+};
+
+//helper function to check if a SELECT computes aggregates
+bool isAggregateQuery(const SelectStmt& stmt) {
+    if (!stmt.groupBy.empty()) return true;
+    for (const auto& col : stmt.columns) {
+        if (!col.function.empty()) return true;
+    }
+    for (const auto& key : stmt.orderBy) {
+        if (!key.column.function.empty()) return true;
+    }
+    return false;
+}
+
+//helper function to resolve the select list and GROUP BY of an aggregate query; resolve maps a
+//column reference to its position in a row, or -1. prints an error and returns false on failure
+bool planAggregates(const SelectStmt& stmt, const std::vector<std::string>& headers,
+                    const std::vector<ValueType>& types, const std::function<int(const ColumnRef&)>& resolve,
+                    const std::string& scope, AggregatePlan& plan) {
+    auto nameOf = [](const ColumnRef& ref) { return ref.table.empty() ? ref.column : ref.table + "." + ref.column; };
+    auto find = [&](const ColumnRef& ref, int& index) {
+        index = resolve(ref);
+        if (index < 0) out() << "Error: Column '" << nameOf(ref) << "' not found in " << scope << ".\n";
+        return index >= 0;
+    };
+
+    if (stmt.columns.empty()) {
+        out() << "Error: SELECT * cannot be used with GROUP BY.\n";
+        return false;
+    }
+    for (const auto& ref : stmt.groupBy) {
+        int index;
+        if (!find(ref, index)) return false;
+        plan.groupColumns.push_back(index);
+    }
+
+    for (const auto& ref : stmt.columns) {
+        if (ref.function.empty()) {
+            int index;
+            if (!find(ref, index)) return false;
+            auto it = std::find(plan.groupColumns.begin(), plan.groupColumns.end(), index);
+            if (it == plan.groupColumns.end()) {
+                out() << "Error: Column '" << nameOf(ref) << "' must appear in GROUP BY or inside an aggregate.\n";
+                return false;
+            }
+            plan.outputs.emplace_back(false, it - plan.groupColumns.begin());
+            plan.labels.push_back(headers[index]);
+            continue;
+        }
+
+        AggregateSpec spec;
+        aggregateFunction(ref.function, spec.function);
+        if (ref.column != "*") {
+            if (!find(ref, spec.column)) return false;
+            spec.type = types[spec.column];
+            bool numeric = spec.function == AggregateFunction::Sum || spec.function == AggregateFunction::Avg;
+            if (numeric && spec.type == ValueType::Text) {
+                out() << "Error: " << ref.function << " needs a numeric column; '" << nameOf(ref) << "' is TEXT.\n";
+                return false;
+            }
+        }
+        plan.outputs.emplace_back(true, plan.aggregates.size());
+        plan.aggregates.push_back(spec);
+        plan.labels.push_back(ref.function + "(" + (spec.column < 0 ? "*" : headers[spec.column]) + ")");
+    }
+
+    //ORDER BY may use grouped columns and aggregates, including ones that are not printed
+    for (const auto& key : stmt.orderBy) {
+        const ColumnRef& ref = key.column;
+        int index;
+        if (ref.function.empty()) {
+            if (!find(ref, index)) return false;
+            auto it = std::find(plan.groupColumns.begin(), plan.groupColumns.end(), index);
+            if (it == plan.groupColumns.end()) {
+                out() << "Error: Column '" << nameOf(ref) << "' must appear in GROUP BY or inside an aggregate.\n";
+                return false;
+            }
+            plan.order.push_back({static_cast<int>(it - plan.groupColumns.begin()), key.descending, types[index]});
+            continue;
+        }
+
+        AggregateSpec spec;
+        aggregateFunction(ref.function, spec.function);
+        if (ref.column != "*") {
+            if (!find(ref, spec.column)) return false;
+            spec.type = types[spec.column];
+        }
+        auto same = [&](const AggregateSpec& other) {
+            return other.function == spec.function && other.column == spec.column;
+        };
+        auto it = std::find_if(plan.aggregates.begin(), plan.aggregates.end(), same);
+        if (it == plan.aggregates.end()) it = plan.aggregates.insert(plan.aggregates.end(), spec);
+        bool keepsType = spec.function == AggregateFunction::Min || spec.function == AggregateFunction::Max;
+        plan.order.push_back({static_cast<int>(plan.groupColumns.size() + (it - plan.aggregates.begin())),
+                              key.descending, keepsType ? spec.type : ValueType::Any});
+    }
+    return true;
+}
+
+//helper function to print the result of an aggregate query, one line per group
+void printGroups(const SelectStmt& stmt, const AggregatePlan& plan, GroupTable& groups, PlanOperator* aggregateOp,
+                 PlanOperator* sortOp) {
+    resultSink().header(joinValues(plan.labels));
+    auto sorter = makeSorter(stmt.orderBy, stmt.limit);
+    std::string text, key;
+    std::vector<std::string> values; //group keys, then aggregate results
+    std::uint64_t groupCount = 0;
+    groups.forEachGroup([&](const std::vector<std::string_view>& keys, const std::vector<AggregateState>& states) {
+        ++groupCount;
+        values.assign(keys.begin(), keys.end());
+        for (size_t i = 0; i < plan.aggregates.size(); ++i) values.push_back(states[i].result(plan.aggregates[i]));
+
+        std::string line;
+        for (size_t i = 0; i < plan.outputs.size(); ++i) {
+            auto [isAggregate, index] = plan.outputs[i];
+            line += values[isAggregate ? keys.size() + index : index];
+            if (i < plan.outputs.size() - 1) line += ',';
+        }
+        if (sorter) {
+            SectionTimer timer(sortOp);
+            buildSortKey(key, plan.order, values);
+            sorter->add(key, line);
+            return;
+        }
+        text += line;
+        text += '\n';
+        if (text.size() >= 64 * 1024) {
+            resultSink().rows(text);
+            text.clear();
+        }
+    });
+    if (!text.empty()) resultSink().rows(text);
+    if (aggregateOp) aggregateOp->rowsOut = groupCount;
+    if (sorter) finishSorter(*sorter, sortOp, !stmt.orderBy.empty());
+}
+
+//helper function to add the operators of an aggregate query above its input to the EXPLAIN plan;
+//depth is set to the level of the input
+void addAggregateOperators(const SelectStmt& stmt, const std::string& parallelism, int& depth,
+                           PlanOperator*& aggregateOp, PlanOperator*& sortOp) {
+    depth = 0;
+    if (!activeProfile()) return;
+    if ((sortOp = addSortOperator(depth, stmt.orderBy, stmt.limit))) ++depth;
+    std::string label = stmt.groupBy.empty() ? "Aggregate:" : "Hash Aggregate: GROUP BY";
+    for (size_t i = 0; i < stmt.groupBy.size(); ++i) label += (i ? ", " : " ") + columnLabel(stmt.groupBy[i]);
+    if (!stmt.groupBy.empty()) label += ";";
+    for (size_t i = 0; i < stmt.columns.size(); ++i) {
+        if (stmt.columns[i].function.empty()) continue;
+        label += (label.back() == ';' || label.back() == ':' ? " " : ", ") + columnLabel(stmt.columns[i]);
+    }
+    aggregateOp = addOperator(depth++, label + parallelism);
+}
+
+//func to run a SELECT with aggregates over one table. text tables are mapped and aggregated
+//in morsels; each scan thread fills its own group table and the tables are merged at the end
+void showAggregates(const SelectStmt& stmt) {
+    const std::string& tableName = stmt.table;
+    TableScan scan;
+    if (!scan.open(tableName)) {
+        out() << "Error: Table '" << tableName << "' does not exist.\n";
+        return;
+    }
+    const auto& headers = scan.headers;
+    auto types = loadSchema(tableName, headers.size());
+    auto resolve = [&](const ColumnRef& ref) {
+        return !ref.table.empty() && ref.table != tableName ? -1 : findColumn(headers, ref.column);
+    };
+
+    AggregatePlan plan;
+    if (!planAggregates(stmt, headers, types, resolve, "table", plan)) return;
+
+    //a WHERE on a missing column matches no rows
+    RowFilter filter;
+    if (stmt.where && !prepareFilter(*stmt.where, types, resolve, filter)) return;
+    auto matches = [&](const auto& values) {
+        if (values.empty()) return false; //blank line
+        return !stmt.where || filter(values);
+    };
+
+    GroupTable groups(plan.groupColumns, plan.aggregates);
+    MappedFile file;
+    bool morsels = !scan.columnar && !settings.cacheTables &&
+                   file.open("database/" + tableName + ".txt", scan.sizeBytes) && file.fileId() == scan.fileId;
+    MorselOptions options;
+    options.threads = settings.scanThreads;
+
+    //either way only the blocks the zone map cannot rule out are read
+    ScanRanges ranges;
+    if (morsels) {
+        size_t headerEnd = file.data().find('\n');
+        std::uint64_t dataStart = headerEnd == std::string_view::npos ? file.data().size() : headerEnd + 1;
+        ranges = planRanges(tableName, stmt.where ? &filter : nullptr, dataStart, file.data().size());
+    } else if (stmt.where) {
+        scan.skipBlocks(tableName, filter);
+    }
+
+    int depth;
+    PlanOperator *aggregateOp = nullptr, *sortOp = nullptr, *filterOp = nullptr, *scanOp = nullptr;
+    std::string parallelism = morsels && options.threads > 1
+                                  ? " (" + std::to_string(options.threads) + " threads, partial tables merged)"
+                                  : "";
+    addAggregateOperators(stmt, parallelism, depth, aggregateOp, sortOp);
+    if (activeProfile()) {
+        if (stmt.where) filterOp = addOperator(depth++, filterLabel(*stmt.where, filter, types), Phase::Predicate);
+        std::string label = morsels ? "Morsel Scan on " + tableName + " (text, " + byteLabel(file.data().size()) +
+                                          rangeLabel(ranges) + deletedLabel(scan.deleted) + ", " +
+                                          byteLabel(options.morselSize) + " morsels)"
+                                    : scan.label(tableName);
+        scanOp = addOperator(depth, label, Phase::Parse);
+    }
+    if (!beginExecution()) return;
+    bool profiled = analyzing();
+
+    if (morsels) {
+        std::vector<GroupTable> partials(std::max<size_t>(options.threads, 1), groups);
+        forEachMorsel(rangePieces(file.data(), ranges), options, [&](size_t worker, size_t morsel, std::string_view lines) {
+            //rows are ordered by morsel, then by line, so groups keep their scan order
+            std::uint64_t order = static_cast<std::uint64_t>(morsel) << 32;
+            std::vector<std::string_view> values;
+            RowProbe probe(profiled);
+            size_t cursor = 0;
+            while (!lines.empty()) {
+                probe.startRow();
+                size_t newline = lines.find('\n');
+                std::string_view row = lines.substr(0, newline);
+                lines.remove_prefix(newline == std::string_view::npos ? lines.size() : newline + 1);
+                if (!scan.deleted.empty() && scan.deleted.contains(row.data() - file.data().data(), cursor)) {
+                    probe.stage(scanOp, false);
+                    continue;
+                }
+                splitRow(row, values);
+                probe.read(scanOp, row.size() + 1);
+                probe.stage(scanOp);
+                bool pass = matches(values);
+                if (stmt.where) probe.stage(filterOp, pass);
+                if (pass) {
+                    partials[worker].add(values, order);
+                    probe.stage(aggregateOp, false);
+                }
+                ++order;
+            }
+        });
+        SectionTimer timer(aggregateOp);
+        for (auto& partial : partials) groups.merge(partial);
+    } else {
+        Row row;
+        std::uint64_t order = 0;
+        RowProbe probe(profiled);
+        while (true) {
+            probe.startRow();
+            if (!scan.next(row)) break;
+            probe.stage(scanOp);
+            bool pass = matches(row);
+            if (stmt.where) probe.stage(filterOp, pass);
+            if (pass) {
+                groups.add(row, order);
+                probe.stage(aggregateOp, false);
+            }
+            ++order;
+        }
+        probe.read(scanOp, scan.bytesRead);
+    }
+    printGroups(stmt, plan, groups, aggregateOp, sortOp);
+}
+
+//helper function to list the columns of a table with their declared types
+void printColumns(const std::string& tableName, const std::vector<std::string>& headers) {
+    auto types = loadSchema(tableName, headers.size());
+    out() << "Columns in table '" << tableName << "':\n";
+    for (size_t i = 0; i < headers.size(); ++i) {
+        out() << "- " << headers[i];
+        if (types[i] != ValueType::Any) out() << " " << typeName(types[i]);
+        out() << "\n";
+    }
+}
+
+//handle DESC tables 
+
+void describeTable(const DescStmt& stmt) {
+    const std::string& tableName = stmt.table;
+    if (isColumnarTable(tableName)) {
+        TableScan scan;
+        if (!scan.open(tableName)) {
+            out() << "Error: Table '" << tableName << "' could not be read.\n";
+            return;
+        }
+        printColumns(tableName, scan.headers);
+        return;
+    }
+
+    CsvReader reader;
+    if (!reader.open("database/" + tableName + ".txt")) {
+        out() << "Error: Table '" << tableName << "' does not exist.\n";
+        return;
+    }
+
+    std::string_view headerLine;
+    if (reader.nextLine(headerLine)) {
+        std::vector<std::string> headers;
+        splitRow(headerLine, headers);
+        printColumns(tableName, headers);
+    } else {
+        out() << "Error: Table '" << tableName << "' is empty.\n";
+    }
+}
+
+//one table of a join: its scan, the WHERE terms pushed down to it, and what the planner expects of it
+struct JoinTable {
+    std::string name;
+    TableScan scan;
+    std::vector<ValueType> types;
+    size_t offset = 0;   //position of its first column among the joined columns
+    size_t keyWidth = 0; //rows with fewer cells lack a join column and match nothing
+    Condition where;     //the WHERE terms that read only this table
+    RowFilter filter;
+    const RowFilter* rowFilter = nullptr;
+    TableEstimate estimate;
+    double rows = 0;             //rows expected to pass where
+    std::uintmax_t sizeHint = 0; //bytes of those rows, for the hash join's choice of build side
+    PlanOperator *scanOp = nullptr, *filterOp = nullptr;
+};
+
+//an ON condition: column1 of table1 equals column2 of table2, the table its JOIN added
+struct JoinEdge {
+    size_t table1 = 0, table2 = 0;
+    int column1 = -1, column2 = -1;
+    std::string name1, name2; //the columns as the query names them
+};
+
+//one step of a left-deep join: the table joined to the rows joined before it, on edge, and the
+//rows the planner expects out of the step. the first step has no edge
+struct JoinStep {
+    size_t table = 0;
+    const JoinEdge* edge = nullptr;
+    double rows = 0;
+};
+
+//helper function to estimate the rows of joining outer rows to inner rows on a key with the given
+//distinct values on either side: each key value of the side with more of them meets its share of
+//the other side
+double joinRows(double outerRows, double outerDistinct, double innerRows, double innerDistinct) {
+    double distinct = std::max({std::min(outerDistinct, outerRows), std::min(innerDistinct, innerRows), 1.0});
+    return std::max(1.0, outerRows * innerRows / distinct);
+}
+
+//helper function to choose the order three or more tables are joined in. the first table is the one
+//expected to keep the fewest rows after its WHERE terms; each later step joins the table, connected
+//to those joined so far, that keeps the intermediate result smallest
+std::vector<JoinStep> planJoinOrder(const std::vector<JoinTable>& tables, const std::vector<JoinEdge>& edges) {
+    std::vector<JoinStep> steps;
+    std::vector<bool> joined(tables.size(), false);
+    size_t first = 0;
+    for (size_t t = 1; t < tables.size(); ++t) {
+        if (tables[t].rows < tables[first].rows) first = t;
+    }
+    steps.push_back({first, nullptr, tables[first].rows});
+    joined[first] = true;
+
+    //every JOIN connects its table to one before it, so some edge always leads out of the joined tables
+    while (steps.size() < tables.size()) {
+        JoinStep best;
+        for (const auto& edge : edges) {
+            if (joined[edge.table1] == joined[edge.table2]) continue;
+            bool forward = joined[edge.table1];
+            size_t outer = forward ? edge.table1 : edge.table2;
+            size_t inner = forward ? edge.table2 : edge.table1;
+            double outerDistinct = tables[outer].estimate.distinct(forward ? edge.column1 : edge.column2);
+            double innerDistinct = tables[inner].estimate.distinct(forward ? edge.column2 : edge.column1);
+            double rows = joinRows(steps.back().rows, std::min(outerDistinct, tables[outer].rows), tables[inner].rows,
+                                   innerDistinct);
+            if (!best.edge || rows < best.rows || (rows == best.rows && inner < best.table)) best = {inner, &edge, rows};
+        }
+        joined[best.table] = true;
+        steps.push_back(best);
+    }
+    return steps;
+}
+
+//helper function to write a row position as 8 big-endian bytes, so positions compare bytewise in order
+void writeOrdinal(std::string& cell, std::uint64_t ordinal) {
+    cell.resize(8);
+    for (int i = 7; i >= 0; --i, ordinal >>= 8) cell[i] = static_cast<char>(ordinal & 0xff);
+}
+
+//handle JOIN operations between two or more tables
+
+void processJoin(const SelectStmt& stmt) {
+    //validate tables; a table joined twice would need an alias to tell its columns apart
+    std::vector<JoinTable> tables(stmt.joins.size() + 1);
+    for (size_t t = 0; t < tables.size(); ++t) {
+        tables[t].name = t == 0 ? stmt.table : stmt.joins[t - 1].table;
+        for (size_t u = 0; u < t; ++u) {
+            if (tables[u].name == tables[t].name) {
+                out() << "Error: Table '" << tables[t].name << "' appears more than once in the join.\n";
+                return;
+            }
+        }
+    }
+    for (auto& table : tables) {
+        if (table.scan.open(table.name)) continue;
+        if (tables.size() == 2) out() << "Error: One or both tables do not exist.\n";
+        else out() << "Error: Table '" << table.name << "' does not exist.\n";
+        return;
+    }
+    bool twoWay = tables.size() == 2;
+
+    //each ON compares a column of its JOIN's table with a column of a table before it
+    std::vector<JoinEdge> edges;
+    for (size_t j = 0; j < stmt.joins.size(); ++j) {
+        const JoinClause& join = stmt.joins[j];
+        size_t added = j + 1;
+        bool reversed = join.left.table == tables[added].name;
+        const ColumnRef& earlierRef = reversed ? join.right : join.left;
+        const ColumnRef& addedRef = reversed ? join.left : join.right;
+        JoinEdge edge;
+        edge.table1 = edge.table2 = added;
+        for (size_t t = 0; t < added; ++t) {
+            if (tables[t].name == earlierRef.table) edge.table1 = t;
+        }
+        if (edge.table1 == added || addedRef.table != tables[added].name) {
+            out() << "Error: JOIN " << tables[added].name << " must compare a column of " << tables[added].name
+                  << " with a column of a table before it.\n";
+            return;
+        }
+        edge.column1 = findColumn(tables[edge.table1].scan.headers, earlierRef.column);
+        edge.column2 = findColumn(tables[added].scan.headers, addedRef.column);
+        if (edge.column1 == -1 || edge.column2 == -1) {
+            out() << "Error: Join columns not found.\n";
+            return;
+        }
+        edge.name1 = earlierRef.column;
+        edge.name2 = addedRef.column;
+        tables[edge.table1].keyWidth = std::max<size_t>(tables[edge.table1].keyWidth, edge.column1 + 1);
+        tables[added].keyWidth = std::max<size_t>(tables[added].keyWidth, edge.column2 + 1);
+        edges.push_back(std::move(edge));
+    }
+
+    //column selection
+    std::vector<std::string> selectedCols = columnNames(stmt.columns);
+
+    //combined headers, each table's columns from its offset on
+    std::vector<std::string> combinedHeaders;
+    std::vector<ValueType> combinedTypes;
+    for (auto& table : tables) {
+        table.offset = combinedHeaders.size();
+        table.types = loadSchema(table.name, table.scan.headers.size());
+        for (const auto& h : table.scan.headers) combinedHeaders.push_back(table.name + "." + h);
+        combinedTypes.insert(combinedTypes.end(), table.types.begin(), table.types.end());
+    }
+    auto resolve = [&](const ColumnRef& ref) {
+        std::string name = ref.table + "." + convertToLower(ref.column);
+        for (size_t i = 0; i < combinedHeaders.size(); ++i) {
+            if (!ref.table.empty() && convertToLower(combinedHeaders[i]) == name) return static_cast<int>(i);
+        }
+        return -1;
+    };
+
+    //an aggregate query groups the joined rows instead of printing them
+    AggregatePlan plan;
+    std::optional<GroupTable> groups;
+    if (isAggregateQuery(stmt)) {
+        if (!planAggregates(stmt, combinedHeaders, combinedTypes, resolve, "joined tables", plan)) return;
+        groups.emplace(plan.groupColumns, plan.aggregates);
+    }
+
+    //otherwise ORDER BY and LIMIT pass the joined lines through a sorter
+    std::vector<SortColumn> sortColumns;
+    std::unique_ptr<RowSorter> sorter;
+    if (!groups) {
+        if (!planOrder(stmt.orderBy, combinedTypes, resolve, "joined tables", sortColumns)) return;
+        sorter = makeSorter(stmt.orderBy, stmt.limit);
+    }
+
+    std::vector<int> selectedIndices;
+    if (groups) {
+        //columns were resolved by the plan
+    } else if (selectedCols[0] == "*") {
+        for (size_t i = 0; i < combinedHeaders.size(); ++i) selectedIndices.push_back(i);
+    } else {
+        for (const auto& col : selectedCols) {
+            bool found = false;
+            for (size_t i = 0; i < combinedHeaders.size(); ++i) {
+                if (convertToLower(combinedHeaders[i]) == convertToLower(col)) {
+                    selectedIndices.push_back(i);
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                out() << "Error: Column '" << col << "' not found in joined tables.\n";
+                return;
+            }
+        }
+    }
+
+    //the WHERE terms that read one table are applied to its rows before they are joined, so rows
+    //that cannot match are never hashed or probed; the other terms are applied to the joined rows.
+    //a term on another table, or on a missing column, matches no rows
+    Condition pairWhere;
+    pairWhere.type = Condition::Type::And;
+    for (auto& table : tables) table.where.type = Condition::Type::And;
+    if (stmt.where) {
+        for (const Condition* term : conjuncts(*stmt.where)) {
+            std::vector<std::string> names;
+            conditionTables(*term, names);
+            Condition* side = &pairWhere;
+            for (auto& table : tables) {
+                if (names.size() == 1 && names[0] == table.name) side = &table.where;
+            }
+            side->children.push_back(*term);
+        }
+    }
+    auto resolveIn = [](const JoinTable& table) {
+        return [&table](const ColumnRef& ref) {
+            return ref.table == table.name ? findColumn(table.scan.headers, ref.column) : -1;
+        };
+    };
+    RowFilter pairFilter;
+    for (auto& table : tables) {
+        if (table.where.children.empty()) continue;
+        if (!prepareFilter(table.where, table.types, resolveIn(table), table.filter)) return;
+        table.rowFilter = &table.filter;
+    }
+    if (!pairWhere.children.empty() && !prepareFilter(pairWhere, combinedTypes, resolve, pairFilter)) return;
+    for (auto& table : tables) {
+        if (table.rowFilter) table.scan.skipBlocks(table.name, table.filter);
+    }
+
+    //what each table is expected to keep after its WHERE terms, from the statistics ANALYZE
+    //collected; a table never analyzed is expected to keep all of its rows
+    for (auto& table : tables) {
+        table.estimate = estimateTable(table.name, table.scan.sizeBytes);
+        double selectivity = table.rowFilter ? estimateSelectivity(table.where, table.estimate, resolveIn(table)) : 1;
+        table.rows = std::max(1.0, table.estimate.rows * selectivity);
+        table.sizeHint = static_cast<std::uintmax_t>(table.scan.sizeBytes * selectivity);
+    }
+
+    //a much smaller outer table probes an index on the inner join column instead of scanning it
+    std::vector<IndexInfo> innerIndexes;
+    const IndexInfo* joinIndex = nullptr;
+    AppendLock indexLock;
+    BPlusTree tree;
+    bool indexJoin = false;
+    if (twoWay) {
+        innerIndexes = loadIndexes(tables[1].name);
+        joinIndex = findIndex(innerIndexes, edges[0].name2);
+        indexJoin = joinIndex && !tables[1].scan.columnar && tables[0].sizeHint * 8 < tables[1].scan.sizeBytes &&
+                    indexLock.tryLockShared(tables[1].name) &&
+                    readSnapshot(tables[1].name).generation == tables[1].scan.generation &&
+                    tree.open(indexPath(tables[1].name, joinIndex->name));
+    }
+
+    //three or more tables are joined left-deep in the planned order. the hash join of each step
+    //builds on whichever input is expected to be smaller: the table it adds, or the rows joined so
+    //far at the bytes of the tables they hold
+    std::vector<JoinStep> steps;
+    std::vector<std::uintmax_t> stepHints;
+    if (!twoWay) {
+        steps = planJoinOrder(tables, edges);
+        stepHints.assign(steps.size(), tables[steps[0].table].sizeHint);
+        double tupleBytes = tables[steps[0].table].estimate.rowBytes + 8;
+        for (size_t k = 2; k < steps.size(); ++k) {
+            tupleBytes += tables[steps[k - 1].table].estimate.rowBytes + 8;
+            stepHints[k] = static_cast<std::uintmax_t>(steps[k - 1].rows * tupleBytes);
+        }
+    }
+    auto buildsLeft = [&](size_t k) { return stepHints[k] < tables[steps[k].table].sizeHint; };
+
+    int depth = 0;
+    PlanOperator *aggregateOp = nullptr, *sortOp = nullptr, *projectOp = nullptr, *filterOp = nullptr;
+    std::vector<PlanOperator*> joinOps(tables.size(), nullptr); //joinOps[k] joins the k-th table in join order
+    if (groups) {
+        addAggregateOperators(stmt, "", depth, aggregateOp, sortOp);
+    } else if (activeProfile()) {
+        if ((sortOp = addSortOperator(depth, stmt.orderBy, stmt.limit))) ++depth;
+        projectOp = addOperator(depth++, projectLabel(selectedCols), Phase::Output);
+    }
+    if (activeProfile()) {
+        if (!pairWhere.children.empty()) {
+            filterOp = addOperator(depth++, filterLabel(pairWhere, pairFilter, combinedTypes), Phase::Predicate);
+        }
+        //each input is its scan, under the filter pushed down to it
+        auto addInput = [&](JoinTable& table, int inputDepth, const std::string& label) {
+            if (table.rowFilter) {
+                table.filterOp = addOperator(inputDepth++, filterLabel(table.where, table.filter, table.types),
+                                             Phase::Predicate);
+            }
+            table.scanOp = addOperator(inputDepth, label, Phase::Parse);
+        };
+        auto condition = [&](const JoinEdge& edge) {
+            return tables[edge.table1].name + "." + edge.name1 + " = " + tables[edge.table2].name + "." + edge.name2;
+        };
+        auto expected = [](double rows) { return "~" + std::to_string(std::llround(rows)) + " rows expected"; };
+        std::string grace = ", grace partitions past " + byteLabel(settings.joinMemory) + ")";
+        if (indexJoin) {
+            joinOps[1] = addOperator(depth++, "Index Nested Loop Join: " + condition(edges[0]) + " (" + tables[0].name +
+                                                  " probes index " + joinIndex->name + ")");
+            addInput(tables[0], depth, tables[0].scan.label(tables[0].name));
+            addInput(tables[1], depth,
+                     "Index Lookup on " + tables[1].name + " using " + joinIndex->name + deletedLabel(tables[1].scan.deleted));
+        } else if (twoWay) {
+            const std::string& build = tables[0].sizeHint < tables[1].sizeHint ? tables[0].name : tables[1].name;
+            std::string estimate;
+            if (tables[0].estimate.analyzed || tables[1].estimate.analyzed) {
+                estimate = ", " + expected(joinRows(tables[0].rows, tables[0].estimate.distinct(edges[0].column1),
+                                                    tables[1].rows, tables[1].estimate.distinct(edges[0].column2)));
+            }
+            joinOps[1] = addOperator(depth++, "Hash Join: " + condition(edges[0]) + " (build " + build + estimate + grace);
+            addInput(tables[0], depth, tables[0].scan.label(tables[0].name));
+            addInput(tables[1], depth, tables[1].scan.label(tables[1].name));
+        } else {
+            //a left-deep tree: each join reads the join below it, or the first table, and the table it adds
+            int topDepth = depth;
+            for (size_t k = steps.size() - 1; k >= 1; --k) {
+                const std::string& build = buildsLeft(k) ? (k == 1 ? tables[steps[0].table].name : "joined rows")
+                                                         : tables[steps[k].table].name;
+                joinOps[k] = addOperator(depth++, "Hash Join: " + condition(*steps[k].edge) + " (build " + build + ", " +
+                                                      expected(steps[k].rows) + grace);
+            }
+            for (size_t k = 0; k < steps.size(); ++k) {
+                JoinTable& table = tables[steps[k].table];
+                addInput(table, k == 0 ? depth : topDepth + static_cast<int>(steps.size() - k), table.scan.label(table.name));
+            }
+        }
+    }
+    if (!beginExecution()) return;
+    bool profiled = analyzing();
+
+    //print header
+    if (!groups) sendHeader(combinedHeaders, selectedIndices);
+
+    //filter a joined row and display its selected columns
+    size_t width = combinedHeaders.size();
+    std::vector<std::string_view> combined; //the cells of every table, each from its offset on
+    std::uint64_t pairCount = 0;
+    std::string line, key, text;
+    RowProbe pairProbe(profiled);
+    std::vector<std::unique_ptr<RowProbe>> probes;
+    for (size_t t = 0; t < tables.size(); ++t) probes.push_back(std::make_unique<RowProbe>(profiled));
+    PlanOperator* joinOp = joinOps.back();
+    auto emitLine = [&]() {
+        text += line;
+        text += '\n';
+        if (text.size() >= 64 * 1024) {
+            resultSink().rows(text);
+            text.clear();
+        }
+        pairProbe.stage(projectOp);
+    };
+    auto emitCombined = [&]() {
+        if (!pairWhere.children.empty()) {
+            bool pass = pairFilter(combined);
+            pairProbe.stage(filterOp, pass);
+            if (!pass) return;
+        }
+
+        if (groups) {
+            groups->add(combined, pairCount++);
+            pairProbe.stage(aggregateOp, false);
+            return;
+        }
+        if (sorter && sorter->done()) return;
+
+        line.clear();
+        for (size_t i = 0; i < selectedIndices.size(); ++i) {
+            line += combined[selectedIndices[i]];
+            if (i < selectedIndices.size() - 1) line += ',';
+        }
+        if (sorter) {
+            buildSortKey(key, sortColumns, combined);
+            pairProbe.stage(projectOp);
+            sorter->add(key, line);
+            pairProbe.stage(sortOp, false);
+            return;
+        }
+        emitLine();
+    };
+    auto emitPair = [&](const auto& row1, const auto& row2) {
+        pairProbe.startRow();
+        pairProbe.stage(joinOp);
+        size_t offset2 = tables[1].offset;
+        if (groups || sorter || !pairWhere.children.empty()) {
+            combined.clear();
+            for (size_t i = 0; i < row1.size() && i < offset2; ++i) combined.push_back(row1[i]);
+            combined.resize(offset2);
+            for (size_t i = 0; i < row2.size(); ++i) combined.push_back(row2[i]);
+            combined.resize(width);
+            emitCombined();
+            return;
+        }
+
+        //index into the concatenation of both rows without building it
+        line.clear();
+        for (size_t i = 0; i < selectedIndices.size(); ++i) {
+            size_t idx = selectedIndices[i];
+            if (idx < offset2 && idx < row1.size()) line += row1[idx];
+            else if (idx >= offset2 && idx - offset2 < row2.size()) line += row2[idx - offset2];
+            if (i < selectedIndices.size() - 1) line += ',';
+        }
+        emitLine();
+    };
+
+    //the join's own time is what is left of the whole join after its inputs and outputs
+    auto joinStart = std::chrono::steady_clock::now();
+    std::uint64_t joinAllocations = threadAllocations();
+    auto readRow = [&](TableScan& scan, RowProbe& probe, PlanOperator* scanOp, const RowFilter* filter,
+                       PlanOperator* filterOp, Row& row) {
+        while (true) {
+            probe.startRow();
+            if (!scan.next(row)) return false;
+            probe.stage(scanOp);
+            if (!filter) return true;
+            bool pass = (*filter)(row);
+            probe.stage(filterOp, pass);
+            if (pass) return true;
+        }
+    };
+    auto readTable = [&](JoinTable& table, RowProbe& probe, Row& row) {
+        return readRow(table.scan, probe, table.scanOp, table.rowFilter, table.filterOp, row);
+    };
+    if (indexJoin) {
+        JoinTable &outer = tables[0], &inner = tables[1];
+        int joinIdx1 = edges[0].column1, joinIdx2 = edges[0].column2;
+        CsvReader innerFile;
+        innerFile.open("database/" + inner.name + ".txt", inner.scan.sizeBytes);
+        std::string_view line2;
+        Row row1, row2;
+        while (readTable(outer, *probes[0], row1)) {
+            if (joinIdx1 >= static_cast<int>(row1.size())) continue;
+            for (auto offset : lookupIndex(tree, "=", row1[joinIdx1])) {
+                if (!inner.scan.deleted.empty() && inner.scan.deleted.contains(offset)) continue;
+                probes[1]->startRow();
+                innerFile.seek(offset);
+                if (!innerFile.nextLine(line2)) continue;
+                splitRow(line2, row2);
+                probes[1]->read(inner.scanOp, line2.size() + 1);
+                probes[1]->stage(inner.scanOp);
+                if (joinIdx2 >= static_cast<int>(row2.size()) || row2[joinIdx2] != row1[joinIdx1]) continue;
+                if (inner.rowFilter) {
+                    bool pass = inner.filter(row2);
+                    probes[1]->stage(inner.filterOp, pass);
+                    if (!pass) continue;
+                }
+                emitPair(row1, row2);
+            }
+        }
+    } else if (twoWay) {
+        //join the two tables, building a hash table on the smaller one
+        JoinInput left{[&](Row& row) { return readTable(tables[0], *probes[0], row); },
+                       static_cast<size_t>(edges[0].column1), tables[0].sizeHint};
+        JoinInput right{[&](Row& row) { return readTable(tables[1], *probes[1], row); },
+                        static_cast<size_t>(edges[0].column2), tables[1].sizeHint};
+
+        JoinOptions options;
+        options.memoryBudget = settings.joinMemory;
+        JoinStats stats;
+        options.stats = &stats;
+
+        hashJoin(left, right, options, [&](BufferedRow row1, BufferedRow row2) { emitPair(row1, row2); });
+        if (joinOp) {
+            joinOp->notes.push_back(stats.grace ? "grace hash join, " + std::to_string(stats.partitions) + " partitions"
+                                                : "in memory");
+            joinOp->notes.push_back("peak " + byteLabel(stats.peakBytes) + " of buffered rows");
+        }
+    } else {
+        //the steps join tuples: the cells of every table at their offsets, then per table the position
+        //of its row, empty until the table is joined. the rows joined so far are kept in a spool that
+        //moves them to temp files past the join memory
+        size_t count = tables.size();
+        std::vector<size_t> cellTable(width + count); //the table each cell of a tuple belongs to
+        for (size_t t = 0; t < count; ++t) {
+            for (size_t c = 0; c < tables[t].scan.headers.size(); ++c) cellTable[tables[t].offset + c] = t;
+            cellTable[width + t] = t;
+        }
+        auto tableTuples = [&](size_t t) -> RowReader {
+            return [&, t, row = Row(), position = std::uint64_t(0)](Row& tuple) mutable {
+                JoinTable& table = tables[t];
+                while (readTable(table, *probes[t], row)) {
+                    std::uint64_t ordinal = position++;
+                    if (row.size() < table.keyWidth) continue;
+                    tuple.resize(width + count);
+                    for (auto& cell : tuple) cell.clear();
+                    for (size_t c = 0; c < row.size() && c < table.scan.headers.size(); ++c) {
+                        tuple[table.offset + c].swap(row[c]);
+                    }
+                    writeOrdinal(tuple[width + t], ordinal);
+                    return true;
+                }
+                return false;
+            };
+        };
+
+        std::unique_ptr<RowSpool> joinedRows;
+        std::vector<std::string_view> merged(width + count);
+        std::vector<bool> fromRight(count);
+        JoinOptions options;
+        options.memoryBudget = settings.joinMemory;
+        options.ordered = false; //the rows are put in FROM order once all tables are joined
+        for (size_t k = 1; k < steps.size(); ++k) {
+            const JoinEdge& edge = *steps[k].edge;
+            size_t inner = steps[k].table;
+            bool forward = edge.table2 == inner;
+            size_t outer = forward ? edge.table1 : edge.table2;
+            int outerColumn = forward ? edge.column1 : edge.column2;
+            int innerColumn = forward ? edge.column2 : edge.column1;
+            RowReader joinedTuples = [&](Row& tuple) { return joinedRows->next(tuple); };
+            JoinInput left{k == 1 ? tableTuples(steps[0].table) : joinedTuples,
+                           tables[outer].offset + outerColumn, stepHints[k]};
+            JoinInput right{tableTuples(inner), tables[inner].offset + innerColumn, tables[inner].sizeHint};
+            JoinStats stats;
+            options.stats = &stats;
+            //the last step's rows are read back sorted by the positions of their rows, in FROM order
+            auto nextRows = k + 1 < steps.size() ? std::make_unique<RowSpool>(options)
+                                                 : std::make_unique<RowSpool>(options, width, width + count);
+
+            auto stepStart = std::chrono::steady_clock::now();
+            std::uint64_t stepAllocations = threadAllocations();
+            hashJoin(left, right, options, [&](BufferedRow row1, BufferedRow row2) {
+                for (size_t t = 0; t < count; ++t) fromRight[t] = !row2[width + t].empty();
+                for (size_t i = 0; i < merged.size(); ++i) merged[i] = fromRight[cellTable[i]] ? row2[i] : row1[i];
+                nextRows->add(merged);
+            });
+            joinedRows = std::move(nextRows);
+
+            //a step's own time is what is left after the scans it read
+            if (PlanOperator* op = joinOps[k]) {
+                std::uint64_t total = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now() - stepStart).count();
+                std::uint64_t allocations = threadAllocations() - stepAllocations;
+                std::vector<size_t> read{inner};
+                if (k == 1) read.push_back(steps[0].table);
+                for (size_t t : read) {
+                    probes[t]->flush();
+                    for (auto* input : {tables[t].scanOp, tables[t].filterOp}) {
+                        if (!input) continue;
+                        total -= std::min<std::uint64_t>(total, input->nanos);
+                        allocations -= std::min<std::uint64_t>(allocations, input->allocations);
+                    }
+                }
+                op->nanos = total;
+                op->allocations = allocations;
+                op->rowsOut = joinedRows->size();
+                op->notes.push_back(stats.grace ? "grace hash join, " + std::to_string(stats.partitions) + " partitions"
+                                                : "in memory");
+                op->notes.push_back("peak " + byteLabel(stats.peakBytes) + " of buffered rows");
+                if (joinedRows->runsWritten() > 0) {
+                    op->notes.push_back("joined rows spilled in " + std::to_string(joinedRows->runsWritten()) + " runs");
+                }
+            }
+        }
+
+        //the joined rows go out in the order a nested loop over the tables in FROM order gives,
+        //whatever order they were joined in; the spool sorts and merges them as they are read
+        Row tuple;
+        auto nextOrdered = [&]() {
+            if (!joinOp) return joinedRows->next(tuple);
+            auto orderStart = std::chrono::steady_clock::now();
+            bool more = joinedRows->next(tuple);
+            joinOp->nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                                  orderStart).count();
+            return more;
+        };
+        while (nextOrdered()) {
+            pairProbe.startRow();
+            combined.clear();
+            for (size_t i = 0; i < width; ++i) combined.push_back(tuple[i]);
+            emitCombined();
+        }
+    }
+    if (!text.empty()) resultSink().rows(text);
+    pairProbe.flush();
+    for (auto& probe : probes) probe->flush();
+    if (joinOp) {
+        for (size_t t = 0; t < tables.size(); ++t) {
+            if (tables[t].scanOp && !(indexJoin && t == 1)) tables[t].scanOp->bytesRead += tables[t].scan.bytesRead;
+        }
+    }
+    if (joinOp && twoWay) {
+        std::uint64_t total = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() -
+                                                                                   joinStart).count();
+        std::uint64_t allocations = threadAllocations() - joinAllocations;
+        for (auto* op : {aggregateOp, sortOp, projectOp, filterOp, tables[0].filterOp, tables[1].filterOp,
+                         tables[0].scanOp, tables[1].scanOp}) {
+            if (!op) continue;
+            total -= std::min<std::uint64_t>(total, op->nanos);
+            allocations -= std::min<std::uint64_t>(allocations, op->allocations);
+        }
+        joinOp->nanos = total;
+        joinOp->allocations = allocations;
+    }
+
+    if (groups) printGroups(stmt, plan, *groups, aggregateOp, sortOp);
+    if (sorter) finishSorter(*sorter, sortOp, !stmt.orderBy.empty());
+}
+
+
+//prepared statements, shared by every connection of a server
+std::unordered_map<std::string, std::shared_ptr<const PrepareStmt>> preparedStatements;
+std::mutex preparedMutex;
+
+//serializes writers against readers when commands run concurrently (server mode)
+std::shared_mutex tablesLock;
+
+//func to run a SELECT, routing to the join, aggregate or single table handler
+void runSelect(const SelectStmt& stmt) {
+    if (!stmt.joins.empty()) {
+        processJoin(stmt);
+        return;
+    }
+    if (isAggregateQuery(stmt)) {
+        showAggregates(stmt);
+        return;
+    }
+    std::vector<std::string> selectedCols = columnNames(stmt.columns);
+    if (!stmt.where) {
+        showTableWithFilters(stmt.table, selectedCols, nullptr, stmt.orderBy, stmt.limit);
+        return;
+    }
+
+    //a column qualified with another table is an error here, not a test that matches no rows
+    const Condition* foreign = findForeignColumn(*stmt.where, stmt.table);
+    if (foreign) {
+        out() << "Error: Column '" << foreign->column.table << "." << foreign->column.column << "' not found in table.\n";
+        return;
+    }
+    showTableWithFilters(stmt.table, selectedCols, &*stmt.where, stmt.orderBy, stmt.limit);
+}
+
+//func to run EXPLAIN: the query registers its plan with a profile and, under ANALYZE, runs with its
+//output counted instead of printed. nothing is printed after an error while planning
+void explainQuery(const ExplainStmt& stmt) {
+    QueryProfile profile(stmt.analyze, out());
+    {
+        OutputCapture capture(profile.stream());
+        ResultCapture results(textSink);
+        ProfileScope scope(profile);
+        runSelect(stmt.query);
+    }
+    profile.end();
+    if (profile.started()) profile.print(out());
+}
+
+//writes the result of a view's query into the view's table: a new table made from the result's
+//columns when materializing the view, or the existing one when rows are added to it
+class ViewWriter : public ResultSink {
+public:
+    ViewWriter(const std::string& view, bool create) : view(view), create(create) {}
+
+    void header(std::string_view line) override {
+        if (create) {
+            std::vector<std::string> names;
+            splitRow(line, names);
+            std::vector<std::string> columns = viewColumns(names);
+            createTableFile(view, columns, std::vector<ValueType>(columns.size(), ValueType::Any));
+        }
+        opened = loader.open(view);
+    }
+
+    void rows(std::string_view lines) override {
+        if (!opened || failed) return;
+        batch.clear();
+        for (size_t pos = 0; pos < lines.size();) {
+            size_t newline = lines.find('\n', pos);
+            if (newline == std::string_view::npos) newline = lines.size();
+            batch.push_back(lines.substr(pos, newline - pos));
+            pos = newline + 1;
+        }
+        size_t badRow;
+        if (!loader.appendBatch(batch, badRow)) failed = true;
+        else written += batch.size();
+    }
+
+    void message(std::string_view text) override {
+        out().write(text.data(), text.size());
+    }
+
+    //false if the query produced no result or it could not be written
+    bool ok() const { return opened && !failed; }
+
+    std::uint64_t rowCount() const { return written; }
+
+    //lets other writers at the view, see TableLoader
+    void close() { loader.close(); }
+    std::uint64_t appendedFrom() const { return loader.appendedFrom(); }
+    std::uint64_t appendedTo() const { return loader.appendedTo(); }
+
+private:
+    std::string view;
+    bool create;
+    TableLoader loader;
+    bool opened = false, failed = false;
+    std::uint64_t written = 0;
+    std::vector<std::string_view> batch;
+};
+
+//helper function to run a view's query into the writer's table. on failure error holds what went wrong
+bool materializeView(ViewWriter& writer, const std::string& view, const SelectStmt& query, std::string& error) {
+    std::ostringstream messages;
+    {
+        OutputCapture capture(messages);
+        ResultCapture results(writer);
+        runSelect(query);
+    }
+    writer.close();
+    if (writer.ok()) return true;
+    error = messages.str();
+    if (error.empty()) error = "Error: Could not write to table '" + view + "'.\n";
+    return false;
+}
+
+//helper function to report a view that could not be brought up to date
+void reportViewError(const std::string& view, std::string error) {
+    if (error.rfind("Error: ", 0) == 0) error.erase(0, 7);
+    out() << "Error: Materialized view '" << view << "' could not be refreshed: " << error;
+}
+
+void recomputeViews(const std::string& tableName);
+
+//func to run a view's query again over all of its tables, keeping the view's indexes
+void recomputeView(const std::string& view, const SelectStmt& query) {
+    std::vector<IndexInfo> indexes = loadIndexes(view);
+    ViewWriter writer(view, true);
+    std::string error;
+    if (!materializeView(writer, view, query, error)) {
+        reportViewError(view, error);
+        return;
+    }
+    {
+        std::ostringstream discarded;
+        OutputCapture capture(discarded);
+        for (const auto& index : indexes) createIndex({index.name, view, index.column});
+    }
+    recomputeViews(view);
+}
+
+//func to rebuild every view over a table whose rows were replaced
+void recomputeViews(const std::string& tableName) {
+    for (const auto& view : dependentViews(tableName)) {
+        SelectStmt query;
+        if (loadView(view, query)) recomputeView(view, query);
+    }
+}
+
+//helper function to write the rows in bytes [from, to) of a table file as a table of their own, with
+//the table's header and column types
+bool writeDeltaTable(const std::string& tableName, const std::string& delta, std::uint64_t from, std::uint64_t to) {
+    std::ifstream inFile("database/" + tableName + ".txt", std::ios::binary);
+    std::string headerLine;
+    if (!std::getline(inFile, headerLine)) return false;
+    std::vector<std::string> headers;
+    splitRow(headerLine, headers);
+    saveSchema(delta, headers, loadSchema(tableName, headers.size()));
+
+    std::ofstream outFile("database/" + delta + ".txt", std::ios::binary);
+    outFile << headerLine << "\n";
+    inFile.seekg(from);
+    std::vector<char> buffer(CsvReader::kBlockSize);
+    for (std::uint64_t left = to - from; left > 0 && inFile;) {
+        inFile.read(buffer.data(), std::min<std::uint64_t>(left, buffer.size()));
+        outFile.write(buffer.data(), inFile.gcount());
+        left -= inFile.gcount();
+    }
+    return inFile && outFile;
+}
+
+//func to bring the views over a table up to date after rows were appended to it in bytes [from, to).
+//a view whose query can run over the new rows alone (see isIncremental) gets the rows that query
+//returns for them, read from a temporary table holding just those rows; any other view is recomputed
+void refreshViews(const std::string& tableName, std::uint64_t from, std::uint64_t to) {
+    std::vector<std::string> views = dependentViews(tableName);
+    if (views.empty() || from >= to) return;
+
+    //the temporary table is named for this process and refresh, as other processes refresh views too
+    static std::atomic<std::uint64_t> refreshes{0};
+    std::string delta = tableName + ".delta." + std::to_string(::getpid()) + "." + std::to_string(++refreshes);
+    bool deltaWritten = false;
+    for (const auto& view : views) {
+        SelectStmt query;
+        if (!loadView(view, query)) continue;
+        if (!isIncremental(query)) {
+            recomputeView(view, query);
+            continue;
+        }
+        if (!deltaWritten && !(deltaWritten = writeDeltaTable(tableName, delta, from, to))) {
+            reportViewError(view, "Could not write the new rows of '" + tableName + "'.\n");
+            continue;
+        }
+
+        //the rows of the view's query that involve a new row are those it returns with the table
+        //swapped for the new rows, since only this one table changed
+        SelectStmt deltaQuery = query;
+        renameTable(deltaQuery, tableName, delta);
+        ViewWriter writer(view, false);
+        std::string error;
+        if (!materializeView(writer, view, deltaQuery, error)) {
+            reportViewError(view, error);
+            continue;
+        }
+        refreshViews(view, writer.appendedFrom(), writer.appendedTo());
+    }
+
+    std::error_code ec;
+    fs::remove("database/" + delta + ".txt", ec);
+    dropSchema(delta);
+    tableCache.invalidate(delta);
+}
+
+//func to create a materialized view: a table holding the result of a query, kept up to date as
+//rows are added to the tables the query reads
+void createView(const CreateViewStmt& stmt) {
+    const std::string& viewName = stmt.view;
+    if (fs::exists("database/" + viewName + ".txt") || isColumnarTable(viewName)) {
+        out() << "Error: Table '" << viewName << "' already exists.\n";
+        return;
+    }
+
+    ViewWriter writer(viewName, true);
+    std::string error;
+    if (!materializeView(writer, viewName, stmt.query, error)) {
+        std::error_code ec;
+        fs::remove("database/" + viewName + ".txt", ec);
+        dropZoneMap(viewName);
+        out() << error;
+        return;
+    }
+    saveView(viewName, stmt.query);
+    out() << "Materialized view '" << viewName << "' created with " << writer.rowCount() << " rows.\n";
+}
+
+//results of recent queries, used with --result-cache
+ResultCache resultCache;
+
+//func to run a SELECT through the result cache: a query repeated on unchanged tables replays its
+//result, any other query runs and keeps its result if it is small enough
+void cachedSelect(const SelectStmt& stmt) {
+    std::string key = ResultCache::key(stmt);
+    if (key.empty()) {
+        runSelect(stmt);
+        return;
+    }
+    if (auto entry = resultCache.find(key)) {
+        replayResult(*entry, resultSink());
+        return;
+    }
+
+    //no single result may take more than a quarter of the cache
+    ResultRecorder recorder(resultSink(), settings.resultCache / 4);
+    {
+        ResultCapture capture(recorder);
+        runSelect(stmt);
+    }
+    if (auto entry = recorder.take()) resultCache.insert(key, std::move(entry), settings.resultCache);
+}
+
+//func to run one parsed statement
+void executeStatement(const Statement& statement) {
+    if (auto* prepare = std::get_if<PrepareStmt>(&statement.node)) {
+        std::lock_guard<std::mutex> lock(preparedMutex);
+        preparedStatements[prepare->name] = std::make_shared<const PrepareStmt>(*prepare);
+        out() << "Statement '" << prepare->name << "' prepared.\n";
+        return;
+    }
+
+    if (auto* execute = std::get_if<ExecuteStmt>(&statement.node)) {
+        std::shared_ptr<const PrepareStmt> prepared;
+        {
+            std::lock_guard<std::mutex> lock(preparedMutex);
+            auto it = preparedStatements.find(execute->name);
+            if (it != preparedStatements.end()) prepared = it->second;
+        }
+        if (!prepared) {
+            out() << "Error: Prepared statement '" << execute->name << "' does not exist.\n";
+            return;
+        }
+        if (static_cast<int>(execute->args.size()) != prepared->paramCount) {
+            out() << "Error: Prepared statement '" << execute->name << "' expects " << prepared->paramCount
+                  << " parameter(s), got " << execute->args.size() << ".\n";
+            return;
+        }
+        executeStatement(bindParameters(*prepared, execute->args));
+        return;
+    }
+
+    //reads share the tables, anything that writes holds them exclusively
+    if (auto* select = std::get_if<SelectStmt>(&statement.node)) {
+        std::shared_lock<std::shared_mutex> lock(tablesLock);
+        if (settings.resultCache) cachedSelect(*select);
+        else runSelect(*select);
+    } else if (auto* explain = std::get_if<ExplainStmt>(&statement.node)) {
+        std::shared_lock<std::shared_mutex> lock(tablesLock);
+        explainQuery(*explain);
+    } else if (auto* desc = std::get_if<DescStmt>(&statement.node)) {
+        std::shared_lock<std::shared_mutex> lock(tablesLock);
+        describeTable(*desc);
+    } else {
+        std::unique_lock<std::shared_mutex> lock(tablesLock);
+        if (auto* create = std::get_if<CreateTableStmt>(&statement.node)) {
+            buildTable(*create);
+            recomputeViews(create->table);
+        } else if (auto* view = std::get_if<CreateViewStmt>(&statement.node)) {
+            createView(*view);
+        } else if (auto* index = std::get_if<CreateIndexStmt>(&statement.node)) {
+            createIndex(*index);
+        } else if (auto* insert = std::get_if<InsertStmt>(&statement.node)) {
+            addToTable(*insert);
+        } else if (auto* copy = std::get_if<CopyStmt>(&statement.node)) {
+            copyIntoTable(*copy);
+        } else if (auto* convert = std::get_if<ConvertStmt>(&statement.node)) {
+            convertTable(*convert);
+        } else if (auto* analyze = std::get_if<AnalyzeStmt>(&statement.node)) {
+            analyzeTable(*analyze);
+        } else if (auto* remove = std::get_if<DeleteStmt>(&statement.node)) {
+            changeRows(remove->table, remove->where, nullptr);
+        } else if (auto* update = std::get_if<UpdateStmt>(&statement.node)) {
+            changeRows(update->table, update->where, &update->assignments);
+        } else if (auto* vacuum = std::get_if<VacuumStmt>(&statement.node)) {
+            vacuumTable(vacuum->table, false);
+        }
+    }
+}
+
+//process the SQL command(s) and route each statement to its handler
+void executeSqlCommand(const std::string& sql_cmd) {
+    std::vector<Statement> statements;
+    std::string error;
+    parseSql(sql_cmd, statements, error);
+
+    //statements before a syntax error still run, in order
+    for (const auto& statement : statements) executeStatement(statement);
+    if (!error.empty()) out() << error << "\n";
+}
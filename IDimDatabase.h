@@ -0,0 +1,71 @@
+#ifndef IDIM_DATABASE_H
+#define IDIM_DATABASE_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+//engine settings, adjustable with command line options
+struct Settings {
+    size_t joinMemory = 256u << 20; //bytes a join may hold in memory before spilling to disk
+    size_t sortMemory = 256u << 20; //bytes of rows ORDER BY may hold in memory before spilling runs
+    bool cacheTables = false;       //keep parsed tables in memory between commands (server mode)
+    bool syncWrites = false;        //fdatasync each batch of inserted rows before reporting success
+    size_t scanThreads = 1;         //threads a large table scan is split across
+    bool orderedScans = true;       //parallel scans print rows in table order
+    size_t resultCache = 0;         //bytes of query results kept to answer repeated queries, 0 for none
+    unsigned vacuumThreshold = 20;  //percent of a text table's bytes in deleted rows at which DELETE and
+                                    //UPDATE compact it with VACUUM, 0 to leave that to VACUUM
+};
+
+extern Settings settings;
+
+//stream the calling thread's command output goes to, std::cout by default
+std::ostream& out();
+
+//redirects the calling thread's command output for as long as it is alive
+class OutputCapture {
+public:
+    explicit OutputCapture(std::ostream& stream);
+    ~OutputCapture();
+
+private:
+    std::ostream* previous;
+};
+
+//receives the results of queries. a result is a header line followed by blocks of data lines, in
+//the table format: comma separated values as stored, each line ending in '\n'. anything else a
+//command prints (confirmations, errors) goes to out()
+class ResultSink {
+public:
+    virtual ~ResultSink() = default;
+
+    //column names of the next result, without the newline
+    virtual void header(std::string_view line) = 0;
+
+    //one or more complete data lines of the current result
+    virtual void rows(std::string_view lines) = 0;
+
+    //complete lines of other output, for sinks a Connection runs commands into (see Database.h)
+    virtual void message(std::string_view text) = 0;
+};
+
+//sink the calling thread's query results go to; by default they are printed to out() as they are
+ResultSink& resultSink();
+
+//redirects the calling thread's query results for as long as it is alive
+class ResultCapture {
+public:
+    explicit ResultCapture(ResultSink& sink);
+    ~ResultCapture();
+
+private:
+    ResultSink* previous;
+};
+
+//process one or more ';'-separated SQL commands and route each to its handler.
+//safe to call from several threads: reads share the tables, writes hold them exclusively.
+void executeSqlCommand(const std::string& sql_cmd);
+
+#endif
@@ -0,0 +1,126 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include "Database.h"
+#include "Protocol.h"
+#include "ResultWriter.h"
+#include "Server.h"
+
+//helper function to parse a byte count with an optional K/M/G suffix, returns 0 if invalid
+size_t parseByteSize(const std::string& str) {
+    size_t pos = 0;
+    unsigned long long value = 0;
+    try {
+        value = std::stoull(str, &pos);
+    } catch (...) {
+        return 0;
+    }
+    std::string suffix = str.substr(pos);
+    std::transform(suffix.begin(), suffix.end(), suffix.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (suffix == "k" || suffix == "kb") value <<= 10;
+    else if (suffix == "m" || suffix == "mb") value <<= 20;
+    else if (suffix == "g" || suffix == "gb") value <<= 30;
+    else if (!suffix.empty()) return 0;
+    return value;
+}
+
+//main function, entry point of the program. sql_database is a client of the library API: it runs
+//the command through a Connection and writes the results in the chosen format
+int main(int argc, char* argv[]) {
+    //read options that come before the SQL command
+    Settings options;
+    bool serve = false;
+    std::string socketPath = kDefaultSocketPath;
+    size_t workers = std::max(2u, std::thread::hardware_concurrency());
+    OutputFormat format = OutputFormat::Text;
+    options.scanThreads = std::max(1u, std::thread::hardware_concurrency());
+    int argi = 1;
+    for (; argi < argc && std::string(argv[argi]).rfind("--", 0) == 0; ++argi) {
+        std::string option = argv[argi];
+        if (option.rfind("--join-memory=", 0) == 0) {
+            options.joinMemory = parseByteSize(option.substr(14));
+            if (options.joinMemory == 0) {
+                std::cout << "Error: Invalid value for --join-memory.\n";
+                return 1;
+            }
+        } else if (option.rfind("--sort-memory=", 0) == 0) {
+            options.sortMemory = parseByteSize(option.substr(14));
+            if (options.sortMemory == 0) {
+                std::cout << "Error: Invalid value for --sort-memory.\n";
+                return 1;
+            }
+        } else if (option.rfind("--scan-threads=", 0) == 0) {
+            options.scanThreads = std::atoi(option.c_str() + 15);
+            if (options.scanThreads == 0) {
+                std::cout << "Error: Invalid value for --scan-threads.\n";
+                return 1;
+            }
+        } else if (option.rfind("--format=", 0) == 0) {
+            if (!parseOutputFormat(option.substr(9), format)) {
+                std::cout << "Error: Invalid value for --format.\n";
+                return 1;
+            }
+        } else if (option.rfind("--result-cache=", 0) == 0) {
+            options.resultCache = parseByteSize(option.substr(15));
+            if (options.resultCache == 0) {
+                std::cout << "Error: Invalid value for --result-cache.\n";
+                return 1;
+            }
+        } else if (option.rfind("--vacuum-threshold=", 0) == 0) {
+            std::string value = option.substr(19);
+            if (value.empty() || value.size() > 3 || !std::all_of(value.begin(), value.end(), ::isdigit) ||
+                std::stoi(value) > 100) {
+                std::cout << "Error: Invalid value for --vacuum-threshold.\n";
+                return 1;
+            }
+            options.vacuumThreshold = std::stoi(value);
+        } else if (option == "--unordered") {
+            options.orderedScans = false;
+        } else if (option == "--sync") {
+            options.syncWrites = true;
+        } else if (option == "--serve" || option.rfind("--serve=", 0) == 0) {
+            serve = true;
+            if (option.size() > 8) socketPath = option.substr(8);
+        } else if (option.rfind("--workers=", 0) == 0) {
+            workers = std::atoi(option.c_str() + 10);
+            if (workers == 0) {
+                std::cout << "Error: Invalid value for --workers.\n";
+                return 1;
+            }
+        } else {
+            std::cout << "Error: Unknown option '" << option << "'.\n";
+            return 1;
+        }
+    }
+
+    //server mode keeps parsed tables in memory and answers sql_client requests
+    if (serve) {
+        options.cacheTables = true;
+        Database database(options);
+        return runServer(socketPath, workers);
+    }
+
+    //check if a command line argument is provided
+    if (argi >= argc) {
+        std::cout << "Usage: " << argv[0] << " [--join-memory=SIZE] [--sort-memory=SIZE] [--scan-threads=N] [--result-cache=SIZE] [--vacuum-threshold=PCT] [--unordered] [--sync] [--format=text|csv|tsv|binary] 'SQL command'\n"
+                  << "       " << argv[0] << " [--join-memory=SIZE] [--sort-memory=SIZE] [--scan-threads=N] [--result-cache=SIZE] [--vacuum-threshold=PCT] [--unordered] [--sync] --serve[=SOCKET] [--workers=N]\n";
+        return 1;
+    }
+
+    //get SQL command from command line argument
+    std::string sql_cmd = argv[argi];
+
+    //process SQL command, with the whole output going through one buffer
+    Database database(options);
+    BufferedWriter writer(STDOUT_FILENO);
+    FormatSink sink(format, writer);
+    database.connect().execute(sql_cmd, sink);
+
+    return 0;
+}
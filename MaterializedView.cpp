@@ -0,0 +1,167 @@
+#include "MaterializedView.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string viewPath(const std::string& name) {
+    return "database/" + name + ".view";
+}
+
+std::string registryPath(const std::string& tableName) {
+    return "database/" + tableName + ".views";
+}
+
+void makeShared(const std::string& path) {
+    fs::permissions(path, fs::perms::owner_all | fs::perms::group_all | fs::perms::others_all,
+                    fs::perm_options::replace);
+}
+
+void saveRegistry(const std::string& tableName, const std::vector<std::string>& views) {
+    if (views.empty()) {
+        fs::remove(registryPath(tableName));
+        return;
+    }
+    std::ofstream file(registryPath(tableName));
+    for (const auto& view : views) file << view << "\n";
+    file.close();
+    makeShared(registryPath(tableName));
+}
+
+std::string lowercase(std::string text) {
+    for (auto& c : text) c = std::tolower(static_cast<unsigned char>(c));
+    return text;
+}
+
+//name with every run of characters other than letters, digits and underscores made one underscore
+std::string sanitize(const std::string& name) {
+    std::string clean;
+    for (char c : name) {
+        if (std::isalnum(static_cast<unsigned char>(c)) || c == '_') clean.push_back(c);
+        else if (!clean.empty() && clean.back() != '_') clean.push_back('_');
+    }
+    while (!clean.empty() && clean.back() == '_') clean.pop_back();
+    return clean.empty() ? "column" : clean;
+}
+
+void renameColumn(ColumnRef& ref, const std::string& from, const std::string& to) {
+    if (ref.table == from) ref.table = to;
+}
+
+void renameCondition(Condition& condition, const std::string& from, const std::string& to) {
+    renameColumn(condition.column, from, to);
+    for (auto& child : condition.children) renameCondition(child, from, to);
+}
+
+} // namespace
+
+bool isMaterializedView(const std::string& name) {
+    return fs::exists(viewPath(name));
+}
+
+bool loadView(const std::string& name, SelectStmt& query) {
+    std::ifstream file(viewPath(name));
+    if (!file) return false;
+    std::stringstream text;
+    text << file.rdbuf();
+
+    std::vector<Statement> statements;
+    std::string error;
+    if (!parseSql(text.str(), statements, error) || statements.size() != 1) return false;
+    auto* select = std::get_if<SelectStmt>(&statements[0].node);
+    if (!select) return false;
+    query = std::move(*select);
+    return true;
+}
+
+void saveView(const std::string& name, const SelectStmt& query) {
+    std::ofstream file(viewPath(name));
+    file << queryText(query) << "\n";
+    file.close();
+    makeShared(viewPath(name));
+
+    for (const auto& table : queryTables(query)) {
+        std::vector<std::string> views = dependentViews(table);
+        if (std::find(views.begin(), views.end(), name) != views.end()) continue;
+        views.push_back(name);
+        saveRegistry(table, views);
+    }
+}
+
+void dropView(const std::string& name) {
+    SelectStmt query;
+    if (loadView(name, query)) {
+        for (const auto& table : queryTables(query)) {
+            std::vector<std::string> views = dependentViews(table);
+            views.erase(std::remove(views.begin(), views.end(), name), views.end());
+            saveRegistry(table, views);
+        }
+    }
+    std::error_code ec;
+    fs::remove(viewPath(name), ec);
+}
+
+std::vector<std::string> dependentViews(const std::string& tableName) {
+    std::vector<std::string> views;
+    std::ifstream file(registryPath(tableName));
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty()) views.push_back(line);
+    }
+    return views;
+}
+
+bool isIncremental(const SelectStmt& query) {
+    if (!query.groupBy.empty() || !query.orderBy.empty() || query.limit) return false;
+    return std::none_of(query.columns.begin(), query.columns.end(),
+                        [](const ColumnRef& column) { return !column.function.empty(); });
+}
+
+void renameTable(SelectStmt& query, const std::string& from, const std::string& to) {
+    if (query.table == from) query.table = to;
+    for (auto& column : query.columns) renameColumn(column, from, to);
+    for (auto& join : query.joins) {
+        if (join.table == from) join.table = to;
+        renameColumn(join.left, from, to);
+        renameColumn(join.right, from, to);
+    }
+    if (query.where) renameCondition(*query.where, from, to);
+    for (auto& column : query.groupBy) renameColumn(column, from, to);
+    for (auto& key : query.orderBy) renameColumn(key.column, from, to);
+}
+
+std::vector<std::string> viewColumns(const std::vector<std::string>& resultColumns) {
+    //the column part of each qualified name, empty for other names
+    std::vector<std::string> unqualified(resultColumns.size());
+    for (size_t i = 0; i < resultColumns.size(); ++i) {
+        size_t dot = resultColumns[i].find('.');
+        if (dot != std::string::npos && resultColumns[i].find('(') == std::string::npos) {
+            unqualified[i] = lowercase(resultColumns[i].substr(dot + 1));
+        }
+    }
+
+    std::vector<std::string> names;
+    for (size_t i = 0; i < resultColumns.size(); ++i) {
+        std::string name = resultColumns[i];
+        if (!unqualified[i].empty() && std::count(unqualified.begin(), unqualified.end(), unqualified[i]) == 1) {
+            name = name.substr(name.find('.') + 1);
+        }
+        name = sanitize(name);
+
+        //two results that clean up to the same name are told apart by a number
+        std::string unique = name;
+        for (int n = 2; std::any_of(names.begin(), names.end(),
+                                    [&](const std::string& taken) { return lowercase(taken) == lowercase(unique); });
+             ++n) {
+            unique = name + "_" + std::to_string(n);
+        }
+        names.push_back(unique);
+    }
+    return names;
+}
@@ -0,0 +1,39 @@
+#ifndef MATERIALIZED_VIEW_H
+#define MATERIALIZED_VIEW_H
+
+#include <string>
+#include <vector>
+
+#include "SqlParser.h"
+
+//a materialized view is a text table filled by a SELECT. its query is kept in database/<view>.view
+//and each table the query reads lists the view in database/<table>.views, so a write to the table
+//knows which views to bring up to date
+
+bool isMaterializedView(const std::string& name);
+
+//false if name is not a view or its definition cannot be read
+bool loadView(const std::string& name, SelectStmt& query);
+
+//records the view's query and registers the view with every table it reads
+void saveView(const std::string& name, const SelectStmt& query);
+
+//forgets a view's definition, leaving its table as an ordinary one; does nothing for a table
+void dropView(const std::string& name);
+
+//views whose query reads the table, in the order they were created
+std::vector<std::string> dependentViews(const std::string& tableName);
+
+//true if the view's rows for appended table rows are its query run over those rows alone: a query
+//without aggregates, GROUP BY, ORDER BY or LIMIT
+bool isIncremental(const SelectStmt& query);
+
+//points every reference to table `from` in a query at table `to`
+void renameTable(SelectStmt& query, const std::string& from, const std::string& to);
+
+//column names of a view's table for the column names of its query's result: a qualified name
+//keeps just its column when no other column has that name, otherwise "table_column"; other
+//characters that cannot be in a column name ("COUNT(*)") become underscores
+std::vector<std::string> viewColumns(const std::vector<std::string>& resultColumns);
+
+#endif
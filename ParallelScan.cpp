@@ -0,0 +1,221 @@
+#include "ParallelScan.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile() {
+    if (base) ::munmap(const_cast<char*>(base), size);
+}
+
+bool MappedFile::open(const std::string& path, std::uint64_t limit) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    size = std::min<std::uint64_t>(st.st_size, limit);
+    id = st.st_ino;
+    if (size == 0) {
+        ::close(fd);
+        return true;
+    }
+    void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        size = 0;
+        return false;
+    }
+    base = static_cast<const char*>(mapped);
+    ::madvise(mapped, size, MADV_SEQUENTIAL);
+    return true;
+}
+
+namespace {
+
+//cuts each piece of text into morsels of about morselSize bytes that start and end on line boundaries
+std::vector<std::string_view> splitMorsels(const std::vector<std::string_view>& pieces, size_t morselSize) {
+    std::vector<std::string_view> morsels;
+    for (std::string_view text : pieces) {
+        size_t begin = 0;
+        while (begin < text.size()) {
+            size_t end = begin + morselSize;
+            if (end >= text.size()) {
+                end = text.size();
+            } else {
+                const void* newline = std::memchr(text.data() + end, '\n', text.size() - end);
+                end = newline ? static_cast<const char*>(newline) - text.data() + 1 : text.size();
+            }
+            morsels.push_back(text.substr(begin, end - begin));
+            begin = end;
+        }
+    }
+    return morsels;
+}
+
+//work on one morsel: the pool thread running it, the morsel's position in the file and its lines
+using MorselTask = std::function<void(size_t worker, size_t morsel, std::string_view lines, std::string& output)>;
+
+class MorselPool {
+public:
+    MorselPool(std::vector<std::string_view> pieces, const MorselOptions& options, const MorselTask& process)
+        : morsels(std::move(pieces)), results(morsels.size()), ordered(options.ordered),
+          window(4 * options.threads), process(process), unclaimed(morsels.size()) {
+        //deal the morsels out round robin, so every queue is in file order
+        for (size_t i = 0; i < options.threads; ++i) queues.push_back(std::make_unique<Queue>());
+        for (size_t i = 0; i < morsels.size(); ++i) queues[i % queues.size()]->morsels.push_back(i);
+        emitLimit = ordered ? window : morsels.size();
+    }
+
+    void run(const MorselEmitter& emit) {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < queues.size(); ++i) threads.emplace_back(&MorselPool::work, this, i);
+
+        for (size_t emitted = 0; emitted < morsels.size(); ++emitted) {
+            std::string output;
+            {
+                std::unique_lock<std::mutex> lock(stateMutex);
+                if (ordered) {
+                    stateChanged.wait(lock, [&] { return results[emitted].done; });
+                    output = std::move(results[emitted].output);
+                    ++emitLimit;
+                } else {
+                    stateChanged.wait(lock, [&] { return !finished.empty(); });
+                    output = std::move(results[finished.front()].output);
+                    finished.pop_front();
+                }
+            }
+            stateChanged.notify_all();
+            emit(output);
+        }
+        for (auto& thread : threads) thread.join();
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<size_t> morsels;
+    };
+
+    struct Result {
+        std::string output;
+        bool done = false;
+    };
+
+    //claims the oldest morsel below the emit limit, from its own queue first, then by stealing.
+    //limit receives the emit limit that was applied
+    bool take(size_t self, size_t& morsel, size_t& limit) {
+        limit = emitLimit;
+        for (size_t i = 0; i < queues.size(); ++i) {
+            Queue& queue = *queues[(self + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.morsels.empty() && queue.morsels.front() < limit) {
+                morsel = queue.morsels.front();
+                queue.morsels.pop_front();
+                --unclaimed;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void work(size_t self) {
+        while (unclaimed > 0) {
+            size_t morsel, limit;
+            if (!take(self, morsel, limit)) {
+                //everything left is too far ahead of the output; wait for it to catch up
+                std::unique_lock<std::mutex> lock(stateMutex);
+                stateChanged.wait(lock, [&] { return emitLimit != limit || unclaimed == 0; });
+                continue;
+            }
+
+            std::string output;
+            process(self, morsel, morsels[morsel], output);
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                results[morsel].output = std::move(output);
+                results[morsel].done = true;
+                finished.push_back(morsel);
+            }
+            stateChanged.notify_all();
+        }
+    }
+
+    std::vector<std::string_view> morsels;
+    std::vector<Result> results;
+    std::vector<std::unique_ptr<Queue>> queues;
+    bool ordered;
+    size_t window;
+    const MorselTask& process;
+
+    std::atomic<size_t> unclaimed;
+    std::atomic<size_t> emitLimit{0}; //morsels at or past this index wait (ordered mode)
+    std::mutex stateMutex;
+    std::condition_variable stateChanged;
+    std::deque<size_t> finished;
+};
+
+} // namespace
+
+void scanMorsels(std::string_view text, const MorselOptions& options, const MorselProcessor& process,
+                 const MorselEmitter& emit) {
+    scanMorsels(std::vector<std::string_view>{text}, options, process, emit);
+}
+
+void scanMorsels(const std::vector<std::string_view>& pieces, const MorselOptions& options,
+                 const MorselProcessor& process, const MorselEmitter& emit) {
+    auto morsels = splitMorsels(pieces, options.morselSize);
+
+    //not worth a pool: process in place
+    if (options.threads <= 1 || morsels.size() <= 1) {
+        std::string output;
+        for (auto morsel : morsels) {
+            output.clear();
+            process(morsel, output);
+            emit(output);
+        }
+        return;
+    }
+
+    MorselOptions poolOptions = options;
+    poolOptions.threads = std::min(options.threads, morsels.size());
+    MorselTask task = [&](size_t, size_t, std::string_view lines, std::string& output) { process(lines, output); };
+    MorselPool pool(std::move(morsels), poolOptions, task);
+    pool.run(emit);
+}
+
+void forEachMorsel(std::string_view text, const MorselOptions& options, const MorselConsumer& consume) {
+    forEachMorsel(std::vector<std::string_view>{text}, options, consume);
+}
+
+void forEachMorsel(const std::vector<std::string_view>& pieces, const MorselOptions& options,
+                   const MorselConsumer& consume) {
+    auto morsels = splitMorsels(pieces, options.morselSize);
+    if (options.threads <= 1 || morsels.size() <= 1) {
+        for (size_t i = 0; i < morsels.size(); ++i) consume(0, i, morsels[i]);
+        return;
+    }
+
+    //nothing is emitted, so morsels finish in any order
+    MorselOptions poolOptions = options;
+    poolOptions.threads = std::min(options.threads, morsels.size());
+    poolOptions.ordered = false;
+    MorselTask task = [&](size_t worker, size_t morsel, std::string_view lines, std::string&) {
+        consume(worker, morsel, lines);
+    };
+    MorselPool pool(std::move(morsels), poolOptions, task);
+    pool.run([](const std::string&) {});
+}
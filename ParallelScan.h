@@ -0,0 +1,67 @@
+#ifndef PARALLEL_SCAN_H
+#define PARALLEL_SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//read-only memory mapping of a file, or of its first limit bytes
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool open(const std::string& path, std::uint64_t limit = UINT64_MAX);
+    std::string_view data() const { return {base, size}; }
+
+    //identity (inode) of the mapped file, see CsvReader::fileId
+    std::uint64_t fileId() const { return id; }
+
+private:
+    const char* base = nullptr;
+    size_t size = 0;
+    std::uint64_t id = 0;
+};
+
+struct MorselOptions {
+    size_t threads = 1;
+    size_t morselSize = 4u << 20; //bytes per unit of work
+    bool ordered = true;          //emit morsel results in file order
+};
+
+//turns the complete lines of one morsel into output text; runs on a pool thread
+using MorselProcessor = std::function<void(std::string_view lines, std::string& output)>;
+
+//receives the output of each morsel on the calling thread
+using MorselEmitter = std::function<void(const std::string& output)>;
+
+//splits text into line-aligned morsels and processes them on a work-stealing pool of
+//options.threads threads. each thread starts with every threads-th morsel and steals from the
+//others when it runs out. in ordered mode results are emitted in file order, and threads run at
+//most a few morsels ahead of the oldest one not yet emitted, which bounds buffered output.
+void scanMorsels(std::string_view text, const MorselOptions& options, const MorselProcessor& process,
+                 const MorselEmitter& emit);
+
+//the same over several pieces of a file, each a run of complete lines, in order; a morsel never
+//spans two pieces. used when a scan skips the parts of a file that cannot hold matching rows
+void scanMorsels(const std::vector<std::string_view>& pieces, const MorselOptions& options,
+                 const MorselProcessor& process, const MorselEmitter& emit);
+
+//handles one morsel on a pool thread. worker is the thread's number, below options.threads, so
+//callers can keep one partial result per thread without locking; morsel is its position in the file
+using MorselConsumer = std::function<void(size_t worker, size_t morsel, std::string_view lines)>;
+
+//runs consume over the line-aligned morsels of text on the same work-stealing pool, in no
+//particular order, and returns once every morsel is done
+void forEachMorsel(std::string_view text, const MorselOptions& options, const MorselConsumer& consume);
+
+//the same over several pieces of a file, numbering morsels across all of them
+void forEachMorsel(const std::vector<std::string_view>& pieces, const MorselOptions& options,
+                   const MorselConsumer& consume);
+
+#endif
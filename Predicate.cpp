@@ -0,0 +1,405 @@
+#include "Predicate.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+using Op = Predicate::Op;
+
+template <Op O, typename T>
+bool apply(const T& a, const T& b) {
+    if constexpr (O == Op::Eq) return a == b;
+    else if constexpr (O == Op::Ne) return a != b;
+    else if constexpr (O == Op::Lt) return a < b;
+    else if constexpr (O == Op::Le) return a <= b;
+    else if constexpr (O == Op::Gt) return a > b;
+    else return a >= b;
+}
+
+bool applyNumbers(Op op, double a, double b) {
+    switch (op) {
+        case Op::Eq: return apply<Op::Eq>(a, b);
+        case Op::Ne: return apply<Op::Ne>(a, b);
+        case Op::Lt: return apply<Op::Lt>(a, b);
+        case Op::Le: return apply<Op::Le>(a, b);
+        case Op::Gt: return apply<Op::Gt>(a, b);
+        default: return apply<Op::Ge>(a, b);
+    }
+}
+
+//stored INT and DOUBLE cells are in canonical form, so the whole cell must parse
+bool parseInt(std::string_view cell, std::int64_t& out) {
+    const char* end = cell.data() + cell.size();
+    auto parsed = std::from_chars(cell.data(), end, out);
+    return !cell.empty() && parsed.ec == std::errc() && parsed.ptr == end;
+}
+
+bool parseDouble(std::string_view cell, double& out) {
+    const char* end = cell.data() + cell.size();
+    auto parsed = std::from_chars(cell.data(), end, out);
+    return !cell.empty() && parsed.ec == std::errc() && parsed.ptr == end;
+}
+
+bool parseOp(const std::string& text, Op& op) {
+    if (text == "=") op = Op::Eq;
+    else if (text == "!=") op = Op::Ne;
+    else if (text == "<") op = Op::Lt;
+    else if (text == "<=") op = Op::Le;
+    else if (text == ">") op = Op::Gt;
+    else if (text == ">=") op = Op::Ge;
+    else return false;
+    return true;
+}
+
+//true if text sorts after every cell of a zone
+bool aboveZone(std::string_view text, const ColumnZone& zone) {
+    if (!zone.maxCut) return text > zone.maxText;
+    return text > zone.maxText && text.substr(0, zone.maxText.size()) != zone.maxText;
+}
+
+//whether a cell of a zone can compare to text as op asks, bytewise
+bool textMayMatch(Op op, std::string_view text, const ColumnZone& zone) {
+    std::string_view min = zone.minText, max = zone.maxText;
+    switch (op) {
+        case Op::Eq: return text >= min && !aboveZone(text, zone);
+        case Op::Ne: return zone.minCut || zone.maxCut || min != max || min != text;
+        case Op::Lt: return min < text;
+        case Op::Le: return min <= text;
+        case Op::Gt: return !aboveZone(text, zone) && (zone.maxCut || max > text);
+        default: return !aboveZone(text, zone);
+    }
+}
+
+//whether a number in a zone's range can compare to value as op asks. when the range is not exact
+//a bound may equal value after rounding, so only a range strictly past value rules a block out
+bool numberMayMatch(Op op, double value, bool exact, const ColumnZone& zone) {
+    double min = zone.minNumber, max = zone.maxNumber;
+    switch (op) {
+        case Op::Eq: return value >= min && value <= max;
+        case Op::Ne: return !exact || min != max || min != value;
+        case Op::Lt: return exact ? min < value : min <= value;
+        case Op::Le: return min <= value;
+        case Op::Gt: return exact ? max > value : max >= value;
+        default: return max >= value;
+    }
+}
+
+} // namespace
+
+bool parseLikeStod(std::string_view text, double& out) {
+    //strtod needs a terminated string; short cells are copied to the stack
+    char buffer[64];
+    std::string longText;
+    const char* str = buffer;
+    if (text.size() < sizeof(buffer)) {
+        std::memcpy(buffer, text.data(), text.size());
+        buffer[text.size()] = '\0';
+    } else {
+        longText.assign(text);
+        str = longText.c_str();
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    out = std::strtod(str, &end);
+    return end != str && errno != ERANGE;
+}
+
+template <Predicate::Kind K, Predicate::Op O>
+bool Predicate::compare(std::string_view cell, const Predicate& predicate) {
+    if constexpr (K == Kind::Any) {
+        //untyped columns: text equality, numeric ranges
+        if constexpr (O == Op::Eq || O == Op::Ne) {
+            return apply<O>(cell, std::string_view(predicate.text));
+        } else {
+            double value;
+            return predicate.isNumber && parseLikeStod(cell, value) && apply<O>(value, predicate.doubleValue);
+        }
+    } else if constexpr (K == Kind::Int) {
+        std::int64_t value;
+        return parseInt(cell, value) && apply<O>(value, predicate.intValue);
+    } else if constexpr (K == Kind::IntAsDouble) {
+        std::int64_t value;
+        return parseInt(cell, value) && apply<O>(static_cast<double>(value), predicate.doubleValue);
+    } else if constexpr (K == Kind::Double) {
+        double value;
+        return parseDouble(cell, value) && apply<O>(value, predicate.doubleValue);
+    } else {
+        return apply<O>(cell, std::string_view(predicate.text));
+    }
+}
+
+template <Predicate::Kind K>
+Predicate::Kernel Predicate::kernelFor(Op op) {
+    switch (op) {
+        case Op::Eq: return &compare<K, Op::Eq>;
+        case Op::Ne: return &compare<K, Op::Ne>;
+        case Op::Lt: return &compare<K, Op::Lt>;
+        case Op::Le: return &compare<K, Op::Le>;
+        case Op::Gt: return &compare<K, Op::Gt>;
+        default: return &compare<K, Op::Ge>;
+    }
+}
+
+bool Predicate::prepare(ValueType type, const std::string& opText, const std::string& constant,
+                        const std::string& column, std::string& error) {
+    if (!parseOp(opText, op)) {
+        error = "Error: Unsupported operator '" + opText + "'.";
+        return false;
+    }
+    text = constant;
+
+    std::string stored;
+    switch (type) {
+        case ValueType::Any:
+            kind = Kind::Any;
+            isNumber = parseLikeStod(constant, doubleValue);
+            break;
+        case ValueType::Text:
+            kind = Kind::Text;
+            break;
+        case ValueType::Int:
+            //a fractional constant still compares against integer cells
+            if (normalizeValue(ValueType::Int, constant, stored)) {
+                kind = Kind::Int;
+                parseInt(stored, intValue);
+            } else if (normalizeValue(ValueType::Double, constant, stored)) {
+                kind = Kind::IntAsDouble;
+                parseDouble(stored, doubleValue);
+            } else {
+                error = "Error: Value '" + constant + "' is not a valid INT for column '" + column + "'.";
+                return false;
+            }
+            text = stored;
+            break;
+        case ValueType::Double:
+            if (!normalizeValue(ValueType::Double, constant, stored)) {
+                error = "Error: Value '" + constant + "' is not a valid DOUBLE for column '" + column + "'.";
+                return false;
+            }
+            kind = Kind::Double;
+            parseDouble(stored, doubleValue);
+            text = stored;
+            break;
+    }
+
+    switch (kind) {
+        case Kind::Any: kernel = kernelFor<Kind::Any>(op); break;
+        case Kind::Int: kernel = kernelFor<Kind::Int>(op); break;
+        case Kind::IntAsDouble: kernel = kernelFor<Kind::IntAsDouble>(op); break;
+        case Kind::Double: kernel = kernelFor<Kind::Double>(op); break;
+        case Kind::Text: kernel = kernelFor<Kind::Text>(op); break;
+    }
+    return true;
+}
+
+bool Predicate::comparesNumbers() const {
+    //equality stays on the cell text so large integers compare exactly
+    return kind != Kind::Text && op != Op::Eq && op != Op::Ne;
+}
+
+bool Predicate::matchesNumber(double value) const {
+    switch (kind) {
+        case Kind::Any: return isNumber && applyNumbers(op, value, doubleValue);
+        case Kind::Int: return applyNumbers(op, value, static_cast<double>(intValue));
+        case Kind::IntAsDouble:
+        case Kind::Double: return applyNumbers(op, value, doubleValue);
+        default: return false;
+    }
+}
+
+bool Predicate::mayMatch(const ColumnZone& zone) const {
+    //untyped equality and every test on a TEXT column compare the cell text
+    if (kind == Kind::Text || (kind == Kind::Any && (op == Op::Eq || op == Op::Ne))) {
+        return zone.values > 0 && textMayMatch(op, text, zone);
+    }
+    if (zone.numbers == 0 || (kind == Kind::Any && !isNumber)) return false;
+
+    //integers from 2^53 on do not all convert to distinct doubles
+    const double kExactLimit = 9007199254740992.0;
+    double value = kind == Kind::Int ? static_cast<double>(intValue) : doubleValue;
+    bool exact = kind != Kind::Int || (std::abs(value) < kExactLimit && std::abs(zone.minNumber) < kExactLimit &&
+                                       std::abs(zone.maxNumber) < kExactLimit);
+    return numberMayMatch(op, value, exact, zone);
+}
+
+LikePattern::LikePattern(std::string text) : pattern(std::move(text)) {
+    if (pattern.find('_') != std::string::npos) return;
+    size_t first = pattern.find_first_not_of('%');
+    if (first == std::string::npos) {
+        //only %: anything matches
+        shape = pattern.empty() ? Shape::Exact : Shape::Prefix;
+        return;
+    }
+    size_t last = pattern.find_last_not_of('%');
+    literal = pattern.substr(first, last - first + 1);
+    if (literal.find('%') != std::string::npos) return;
+    bool leading = first > 0, trailing = last + 1 < pattern.size();
+    if (leading && trailing) shape = Shape::Contains;
+    else if (leading) shape = Shape::Suffix;
+    else if (trailing) shape = Shape::Prefix;
+    else shape = Shape::Exact;
+}
+
+bool LikePattern::operator()(std::string_view cell) const {
+    switch (shape) {
+        case Shape::Exact: return cell == literal;
+        case Shape::Prefix: return cell.substr(0, literal.size()) == literal;
+        case Shape::Suffix:
+            return cell.size() >= literal.size() && cell.substr(cell.size() - literal.size()) == literal;
+        case Shape::Contains: return cell.find(literal) != std::string_view::npos;
+        default: break;
+    }
+
+    //greedy match that backtracks to the last % on a mismatch
+    size_t p = 0, c = 0, starP = std::string::npos, starC = 0;
+    while (c < cell.size()) {
+        if (p < pattern.size() && (pattern[p] == '_' || (pattern[p] != '%' && pattern[p] == cell[c]))) {
+            ++p;
+            ++c;
+        } else if (p < pattern.size() && pattern[p] == '%') {
+            starP = p++;
+            starC = c;
+        } else if (starP != std::string::npos) {
+            p = starP + 1;
+            c = ++starC;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '%') ++p;
+    return p == pattern.size();
+}
+
+bool LikePattern::mayMatch(const ColumnZone& zone) const {
+    if (zone.values == 0) return false;
+    if (shape == Shape::Exact) return textMayMatch(Op::Eq, literal, zone);
+    if (shape != Shape::Prefix) return true;
+
+    //the cells that start with literal sort from literal up to the first string past the prefix
+    std::string_view min = zone.minText;
+    bool pastPrefix = min > literal && min.substr(0, literal.size()) != literal;
+    return !aboveZone(literal, zone) && !pastPrefix;
+}
+
+bool RowFilter::prepare(const Condition& where, const std::vector<ValueType>& types,
+                        const std::function<int(const ColumnRef&)>& resolve, std::string& error) {
+    nodes.clear();
+    columnsRead.clear();
+    bool ok = true;
+    compile(where, types, resolve, error, ok);
+    std::sort(columnsRead.begin(), columnsRead.end());
+    columnsRead.erase(std::unique(columnsRead.begin(), columnsRead.end()), columnsRead.end());
+    return ok;
+}
+
+//adds the nodes of one expression, returns the position of its root; constant parts are folded
+size_t RowFilter::compile(const Condition& where, const std::vector<ValueType>& types,
+                          const std::function<int(const ColumnRef&)>& resolve, std::string& error, bool& ok) {
+    size_t index = nodes.size();
+    nodes.emplace_back();
+    Node node;
+    using Type = Condition::Type;
+
+    if (where.type == Type::And || where.type == Type::Or || where.type == Type::Not) {
+        node.type = where.type == Type::And ? Node::Type::And : where.type == Type::Or ? Node::Type::Or
+                                                                                          : Node::Type::Not;
+        //an AND is decided by a false operand, an OR by a true one
+        Node::Type decides = where.type == Type::Or ? Node::Type::True : Node::Type::False;
+        Node::Type neutral = where.type == Type::Or ? Node::Type::False : Node::Type::True;
+        for (const auto& child : where.children) {
+            size_t position = compile(child, types, resolve, error, ok);
+            Node::Type type = nodes[position].type;
+            if (where.type == Type::Not) {
+                if (type == Node::Type::True) node.type = Node::Type::False;
+                else if (type == Node::Type::False) node.type = Node::Type::True;
+                else node.children.push_back(position);
+            } else if (type == decides) {
+                node.type = decides;
+            } else if (type != neutral) {
+                node.children.push_back(position);
+            }
+        }
+        if ((node.type == Node::Type::And || node.type == Node::Type::Or) && node.children.empty()) {
+            node.type = neutral;
+        } else if (node.type == Node::Type::And || node.type == Node::Type::Or) {
+            if (node.children.size() == 1) {
+                Node only = nodes[node.children[0]];
+                node = std::move(only);
+            }
+        }
+        nodes[index] = std::move(node);
+        return index;
+    }
+
+    node.column = resolve(where.column);
+    if (node.column < 0) {
+        node.type = Node::Type::False;
+        nodes[index] = std::move(node);
+        return index;
+    }
+    columnsRead.push_back(node.column);
+    const std::string name = where.column.table.empty() ? where.column.column
+                                                        : where.column.table + "." + where.column.column;
+    ValueType type = types[node.column];
+    auto addTest = [&](const std::string& op, const Literal& value) {
+        node.tests.emplace_back();
+        if (ok && !node.tests.back().prepare(type, op, value.text, name, error)) ok = false;
+    };
+
+    switch (where.type) {
+        case Type::Compare:
+            addTest(where.op, where.value);
+            break;
+        case Type::In:
+            node.any = true;
+            for (const auto& value : where.values) addTest("=", value);
+            break;
+        case Type::Between:
+            addTest(">=", where.values[0]);
+            addTest("<=", where.values[1]);
+            break;
+        default:
+            node.type = Node::Type::Like;
+            node.like = LikePattern(where.value.text);
+            break;
+    }
+    nodes[index] = std::move(node);
+    return index;
+}
+
+bool RowFilter::mayMatch(size_t index, const std::vector<ColumnZone>& zones) const {
+    const Node& node = nodes[index];
+    switch (node.type) {
+        case Node::Type::Test:
+        case Node::Type::Like: {
+            if (node.column >= static_cast<int>(zones.size())) return true;
+            const ColumnZone& zone = zones[node.column];
+            if (node.type == Node::Type::Like) return node.like.mayMatch(zone);
+            for (const auto& test : node.tests) {
+                if (test.mayMatch(zone) == node.any) return node.any;
+            }
+            return !node.any;
+        }
+        case Node::Type::And:
+            for (size_t child : node.children) {
+                if (!mayMatch(child, zones)) return false;
+            }
+            return true;
+        case Node::Type::Or:
+            for (size_t child : node.children) {
+                if (mayMatch(child, zones)) return true;
+            }
+            return false;
+        case Node::Type::False:
+            return false;
+        default:
+            //a block that cannot match the operand of a NOT may still match the NOT
+            return true;
+    }
+}
@@ -0,0 +1,162 @@
+#ifndef PREDICATE_H
+#define PREDICATE_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Schema.h"
+#include "SqlParser.h"
+#include "ZoneMap.h"
+
+//same acceptance rules as std::stod (leading spaces, trailing text ignored, ERANGE rejected)
+//without allocating or throwing
+bool parseLikeStod(std::string_view text, double& out);
+
+//WHERE `cell op constant` on a column of a known type. the constant is parsed once when the
+//predicate is prepared; each row then runs a kernel instantiated for the column type and operator.
+class Predicate {
+public:
+    //false with error set if the operator is unknown or the constant does not fit the column type
+    bool prepare(ValueType type, const std::string& op, const std::string& constant, const std::string& column,
+                 std::string& error);
+
+    bool operator()(std::string_view cell) const { return kernel(cell, *this); }
+
+    //the test for a cell that is already a number (columnar storage), used when comparesNumbers()
+    bool matchesNumber(double value) const;
+    bool comparesNumbers() const;
+
+    //false when no cell of a block with these statistics can pass
+    bool mayMatch(const ColumnZone& zone) const;
+
+    //constant in the stored form of the column, for index lookups
+    const std::string& lookupValue() const { return text; }
+
+    enum class Op { Eq, Ne, Lt, Le, Gt, Ge };
+
+    //how cells are read and what the constant is compared as
+    enum class Kind { Any, Int, IntAsDouble, Double, Text };
+
+private:
+    using Kernel = bool (*)(std::string_view, const Predicate&);
+
+    template <Kind K, Op O>
+    static bool compare(std::string_view cell, const Predicate& predicate);
+
+    template <Kind K>
+    static Kernel kernelFor(Op op);
+
+    Kernel kernel = nullptr;
+    Op op = Op::Eq;
+    Kind kind = Kind::Any;
+    std::string text;          //constant as text, in stored form for numeric columns
+    std::int64_t intValue = 0;
+    double doubleValue = 0;
+    bool isNumber = false;     //the constant parsed as a number (Any columns)
+};
+
+//LIKE pattern: % matches any run of characters, _ any one character. patterns of the common
+//shapes ('abc', 'abc%', '%abc', '%abc%') are matched with one comparison or search
+class LikePattern {
+public:
+    explicit LikePattern(std::string pattern = "");
+
+    bool operator()(std::string_view cell) const;
+
+    //false when no cell of a block with these statistics can match
+    bool mayMatch(const ColumnZone& zone) const;
+
+private:
+    enum class Shape { Exact, Prefix, Suffix, Contains, General };
+
+    std::string pattern;
+    std::string literal; //pattern without its % at the ends, for the simple shapes
+    Shape shape = Shape::General;
+};
+
+//a WHERE expression compiled against the columns of the rows it filters: each column is resolved to
+//its position and each constant parsed for its column's type once, so a row only runs the kernels.
+//a test on a column that is not there matches no rows, as a single condition always has.
+class RowFilter {
+public:
+    //resolve maps a column reference to its position in a row, or -1. false with error set if a
+    //constant does not fit its column's type or an operator is unknown
+    bool prepare(const Condition& where, const std::vector<ValueType>& types,
+                 const std::function<int(const ColumnRef&)>& resolve, std::string& error);
+
+    //values is a row, anything indexable by position whose items convert to string_view; cells
+    //past its end fail their tests
+    template <typename Values>
+    bool operator()(const Values& values) const {
+        return matches(0, values);
+    }
+
+    //false when no row of a block with these per-column statistics can match
+    bool mayMatch(const std::vector<ColumnZone>& zones) const {
+        return nodes.empty() || mayMatch(0, zones);
+    }
+
+    //true when no row can match (every path runs into a missing column)
+    bool neverMatches() const { return !nodes.empty() && nodes[0].type == Node::Type::False; }
+
+    //positions of the columns the expression reads, ascending
+    const std::vector<int>& columns() const { return columnsRead; }
+
+private:
+    struct Node {
+        enum class Type { Test, Like, And, Or, Not, True, False };
+
+        Type type = Type::Test;
+        int column = -1;
+        bool any = false;            //Test: IN matches if any predicate does, the others need all
+        std::vector<Predicate> tests;
+        LikePattern like;
+        std::vector<size_t> children;
+    };
+
+    size_t compile(const Condition& where, const std::vector<ValueType>& types,
+                   const std::function<int(const ColumnRef&)>& resolve, std::string& error, bool& ok);
+
+    bool mayMatch(size_t index, const std::vector<ColumnZone>& zones) const;
+
+    template <typename Values>
+    bool matches(size_t index, const Values& values) const {
+        const Node& node = nodes[index];
+        switch (node.type) {
+            case Node::Type::Test: {
+                if (node.column >= static_cast<int>(values.size())) return false;
+                std::string_view cell = values[node.column];
+                for (const auto& test : node.tests) {
+                    if (test(cell) == node.any) return node.any;
+                }
+                return !node.any;
+            }
+            case Node::Type::Like:
+                return node.column < static_cast<int>(values.size()) && node.like(values[node.column]);
+            case Node::Type::And:
+                for (size_t child : node.children) {
+                    if (!matches(child, values)) return false;
+                }
+                return true;
+            case Node::Type::Or:
+                for (size_t child : node.children) {
+                    if (matches(child, values)) return true;
+                }
+                return false;
+            case Node::Type::Not:
+                return !matches(node.children[0], values);
+            case Node::Type::True:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    std::vector<Node> nodes; //nodes[0] is the root
+    std::vector<int> columnsRead;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <cerrno>
+#include <cstdint>
+#include <string>
+
+#include <unistd.h>
+
+//wire format shared by the server and sql_client: every message, in either direction, is a
+//4-byte big-endian payload length followed by the payload. a request carries one SQL command,
+//its reply carries exactly the text the command prints in one-shot mode.
+
+const char* const kDefaultSocketPath = "sql_database.sock";
+const std::uint32_t kMaxFrameSize = 1u << 30;
+
+inline bool writeAll(int fd, const char* data, std::size_t len) {
+    while (len > 0) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+inline bool readAll(int fd, char* data, std::size_t len) {
+    while (len > 0) {
+        ssize_t n = ::read(fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+inline bool writeFrame(int fd, const std::string& payload) {
+    std::uint32_t len = payload.size();
+    unsigned char header[4] = {static_cast<unsigned char>(len >> 24), static_cast<unsigned char>(len >> 16),
+                               static_cast<unsigned char>(len >> 8), static_cast<unsigned char>(len)};
+    return writeAll(fd, reinterpret_cast<const char*>(header), 4) && writeAll(fd, payload.data(), len);
+}
+
+inline bool readFrame(int fd, std::string& payload) {
+    unsigned char header[4];
+    if (!readAll(fd, reinterpret_cast<char*>(header), 4)) return false;
+    std::uint32_t len = (std::uint32_t(header[0]) << 24) | (std::uint32_t(header[1]) << 16) |
+                        (std::uint32_t(header[2]) << 8) | std::uint32_t(header[3]);
+    if (len > kMaxFrameSize) return false;
+    payload.resize(len);
+    return readAll(fd, payload.data(), len);
+}
+
+#endif
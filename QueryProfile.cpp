@@ -0,0 +1,168 @@
+#include "QueryProfile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+thread_local QueryProfile* currentProfile = nullptr;
+
+//EXPLAIN ANALYZE runs in progress; allocations are only counted while there is one
+std::atomic<int> countingRuns{0};
+thread_local std::uint64_t allocationCount = 0;
+
+std::uint64_t nanosBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+}
+
+std::string milliseconds(std::uint64_t nanos) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.3f ms", nanos / 1e6);
+    return text;
+}
+
+//cost of one clock read, taken off each sampled stage so that short stages are not inflated by it
+std::uint64_t clockCost() {
+    static const std::uint64_t cost = [] {
+        constexpr int kReads = 1000;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kReads - 1; ++i) std::chrono::steady_clock::now();
+        return nanosBetween(start, std::chrono::steady_clock::now()) / kReads;
+    }();
+    return cost;
+}
+
+} // namespace
+
+void noteAllocation() {
+    if (countingRuns.load(std::memory_order_relaxed)) ++allocationCount;
+}
+
+int QueryProfile::CountingBuffer::overflow(int c) {
+    if (c == traits_type::eof()) return traits_type::not_eof(c);
+    char ch = traits_type::to_char_type(c);
+    return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+}
+
+std::streamsize QueryProfile::CountingBuffer::xsputn(const char* text, std::streamsize count) {
+    if (!profile.executing) {
+        target.write(text, count);
+        return count;
+    }
+    bytes += count;
+    lines += std::count(text, text + count, '\n');
+    return count;
+}
+
+QueryProfile::QueryProfile(bool analyze, std::ostream& target)
+    : analyzeRun(analyze), planStart(std::chrono::steady_clock::now()), buffer(*this, target), sink(&buffer) {}
+
+QueryProfile::~QueryProfile() { end(); }
+
+PlanOperator* QueryProfile::add(int depth, std::string label, Phase phase) {
+    operators.push_back(std::make_unique<PlanOperator>());
+    PlanOperator& op = *operators.back();
+    op.label = std::move(label);
+    op.depth = depth;
+    op.phase = phase;
+    return &op;
+}
+
+void QueryProfile::begin() {
+    if (executing) return;
+    executing = true;
+    executionStart = std::chrono::steady_clock::now();
+    if (analyzeRun) countingRuns.fetch_add(1);
+}
+
+void QueryProfile::end() {
+    if (!executing || finished) return;
+    finished = true;
+    executionEnd = std::chrono::steady_clock::now();
+    if (analyzeRun) countingRuns.fetch_sub(1);
+}
+
+void QueryProfile::print(std::ostream& stream) const {
+    std::uint64_t phases[4] = {};
+    for (size_t i = 0; i < operators.size(); ++i) {
+        const PlanOperator& op = *operators[i];
+        std::string line(op.depth * 2, ' ');
+        if (op.depth > 0) line += "-> ";
+        line += op.label;
+        for (const auto& note : op.notes) line += "; " + note;
+
+        if (analyzeRun) {
+            //an operator's input is the output of the operators one level below it
+            std::uint64_t rowsIn = 0;
+            bool hasInputs = false;
+            for (size_t j = i + 1; j < operators.size() && operators[j]->depth > op.depth; ++j) {
+                if (operators[j]->depth != op.depth + 1) continue;
+                rowsIn += operators[j]->rowsOut;
+                hasInputs = true;
+            }
+            line += "  [time=" + milliseconds(op.nanos);
+            if (hasInputs) line += ", rows in=" + std::to_string(rowsIn);
+            line += ", rows out=" + std::to_string(op.rowsOut);
+            if (op.bytesRead) line += ", bytes read=" + std::to_string(op.bytesRead);
+            line += ", allocations=" + std::to_string(op.allocations) + "]";
+            phases[static_cast<int>(op.phase)] += op.nanos;
+        }
+        stream << line << "\n";
+    }
+    if (!analyzeRun) return;
+
+    stream << "Planning time: " << milliseconds(nanosBetween(planStart, executionStart)) << "\n"
+           << "Execution time: " << milliseconds(nanosBetween(executionStart, executionEnd)) << "\n"
+           << "Row parsing: " << milliseconds(phases[static_cast<int>(Phase::Parse)])
+           << ", predicate evaluation: " << milliseconds(phases[static_cast<int>(Phase::Predicate)])
+           << ", output formatting: " << milliseconds(phases[static_cast<int>(Phase::Output)]) << "\n"
+           << "Output: " << buffer.lines << " lines, " << buffer.bytes << " bytes (not printed)\n";
+}
+
+QueryProfile* activeProfile() { return currentProfile; }
+
+ProfileScope::ProfileScope(QueryProfile& profile) : previous(currentProfile) { currentProfile = &profile; }
+
+ProfileScope::~ProfileScope() { currentProfile = previous; }
+
+PlanOperator* addOperator(int depth, const std::string& label, Phase phase) {
+    return currentProfile ? currentProfile->add(depth, label, phase) : nullptr;
+}
+
+bool beginExecution() {
+    if (!currentProfile) return true;
+    currentProfile->begin();
+    return currentProfile->analyze();
+}
+
+bool analyzing() { return currentProfile && currentProfile->analyze(); }
+
+std::uint64_t threadAllocations() { return allocationCount; }
+
+SectionTimer::SectionTimer(PlanOperator* op) : op(op) {
+    if (!op) return;
+    start = std::chrono::steady_clock::now();
+    allocations = threadAllocations();
+}
+
+SectionTimer::~SectionTimer() {
+    if (!op) return;
+    op->nanos += nanosBetween(start, std::chrono::steady_clock::now());
+    op->allocations += threadAllocations() - allocations;
+}
+
+void RowProbe::flush() {
+    if (!active) return;
+    double scale = sampled ? static_cast<double>(rows) / sampled : 0;
+    for (const auto& slot : slots) {
+        if (!slot.op) continue;
+        std::uint64_t overhead = slot.samples * clockCost();
+        slot.op->rowsOut += slot.rows;
+        slot.op->bytesRead += slot.bytes;
+        slot.op->allocations += slot.allocations;
+        slot.op->nanos += static_cast<std::uint64_t>(std::llround((slot.nanos - std::min(slot.nanos, overhead)) * scale));
+    }
+    slots.clear();
+    rows = sampled = 0;
+}
@@ -0,0 +1,189 @@
+#ifndef QUERY_PROFILE_H
+#define QUERY_PROFILE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+//what an operator's time counts towards in the EXPLAIN ANALYZE summary
+enum class Phase { Parse, Predicate, Output, Other };
+
+//one operator of a query plan and, under EXPLAIN ANALYZE, what it did. the counters are atomic so
+//scan threads can add their totals as they finish a morsel
+struct PlanOperator {
+    std::string label;
+    int depth = 0; //operators are listed top down; an operator's inputs follow it one level deeper
+    Phase phase = Phase::Other;
+    std::atomic<std::uint64_t> rowsOut{0};
+    std::atomic<std::uint64_t> bytesRead{0};
+    std::atomic<std::uint64_t> allocations{0};
+    std::atomic<std::uint64_t> nanos{0}; //time spent in the operator itself, summed over threads
+    std::vector<std::string> notes;      //what the operator decided while running
+};
+
+//plan and counters of one query run under EXPLAIN. a query registers its operators while it plans,
+//then calls beginExecution(); under plain EXPLAIN it stops there.
+class QueryProfile {
+public:
+    //output the query prints before beginExecution() (errors) goes to target; after it, output is
+    //counted and dropped
+    QueryProfile(bool analyze, std::ostream& target);
+    ~QueryProfile();
+
+    bool analyze() const { return analyzeRun; }
+    bool started() const { return executing; }
+    std::ostream& stream() { return sink; }
+
+    PlanOperator* add(int depth, std::string label, Phase phase = Phase::Other);
+
+    void begin();
+    void end();
+
+    //the plan, with each operator's counters and a summary when analyzing
+    void print(std::ostream& stream) const;
+
+private:
+    class CountingBuffer : public std::streambuf {
+    public:
+        CountingBuffer(QueryProfile& profile, std::ostream& target) : profile(profile), target(target) {}
+
+        std::uint64_t bytes = 0;
+        std::uint64_t lines = 0;
+
+    protected:
+        int overflow(int c) override;
+        std::streamsize xsputn(const char* text, std::streamsize count) override;
+
+    private:
+        QueryProfile& profile;
+        std::ostream& target;
+    };
+
+    bool analyzeRun;
+    bool executing = false;
+    bool finished = false;
+    std::vector<std::unique_ptr<PlanOperator>> operators;
+    std::chrono::steady_clock::time_point planStart, executionStart, executionEnd;
+    CountingBuffer buffer;
+    std::ostream sink;
+};
+
+//profile of the query the calling thread runs, nullptr outside EXPLAIN
+QueryProfile* activeProfile();
+
+//makes a profile the calling thread's active one for as long as it is alive
+class ProfileScope {
+public:
+    explicit ProfileScope(QueryProfile& profile);
+    ~ProfileScope();
+
+private:
+    QueryProfile* previous;
+};
+
+//registers an operator with the active profile; nullptr (and no work) outside EXPLAIN
+PlanOperator* addOperator(int depth, const std::string& label, Phase phase = Phase::Other);
+
+//called once a query's plan is complete, before it prints or reads any rows. false under EXPLAIN
+//without ANALYZE, where the query must return without running
+bool beginExecution();
+
+//true while the calling thread runs a query under EXPLAIN ANALYZE
+bool analyzing();
+
+//heap allocations made by the calling thread while an EXPLAIN ANALYZE is running
+std::uint64_t threadAllocations();
+
+//counts one heap allocation of the calling thread, if an EXPLAIN ANALYZE is running. the library
+//leaves the global allocator to the program it is linked into; a program that wants allocations in
+//its profiles calls this from its own operator new, as sql_database does (AllocationCounter.cpp)
+void noteAllocation();
+
+//charges the time and allocations of a block of code to an operator; does nothing for nullptr
+class SectionTimer {
+public:
+    explicit SectionTimer(PlanOperator* op);
+    ~SectionTimer();
+
+private:
+    PlanOperator* op;
+    std::chrono::steady_clock::time_point start;
+    std::uint64_t allocations = 0;
+};
+
+//charges the stages of the rows one scan thread processes to their operators. the clock is read for
+//one row in kSampleEvery and the sampled times are scaled up to every row, so a profiled scan stays
+//close to its normal speed; rows and allocations are counted exactly. an inactive probe does nothing,
+//so unprofiled queries pay one predictable branch per call.
+class RowProbe {
+public:
+    static constexpr std::uint64_t kSampleEvery = 16;
+
+    explicit RowProbe(bool active) : active(active) {
+        if (active) slots.reserve(8);
+    }
+    RowProbe(const RowProbe&) = delete;
+    RowProbe& operator=(const RowProbe&) = delete;
+    ~RowProbe() { flush(); }
+
+    //starts the next row; its stages are charged from here
+    void startRow() {
+        if (!active) return;
+        timing = rows++ % kSampleEvery == 0;
+        sampled += timing;
+        mark = threadAllocations();
+        if (timing) clock = std::chrono::steady_clock::now();
+    }
+
+    //charges the row's time since the previous stage to op; the row passes through (or is dropped by) op
+    void stage(PlanOperator* op, bool passed = true) {
+        if (!active) return;
+        Slot& slot = slotFor(op);
+        slot.rows += passed;
+        std::uint64_t allocated = threadAllocations();
+        slot.allocations += allocated - mark;
+        mark = allocated;
+        if (timing) {
+            auto now = std::chrono::steady_clock::now();
+            slot.nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(now - clock).count();
+            ++slot.samples;
+            clock = now;
+        }
+    }
+
+    //counts bytes op read for the current row
+    void read(PlanOperator* op, std::uint64_t bytes) {
+        if (active) slotFor(op).bytes += bytes;
+    }
+
+    //adds the totals so far to the operators
+    void flush();
+
+private:
+    struct Slot {
+        PlanOperator* op = nullptr;
+        std::uint64_t rows = 0, bytes = 0, allocations = 0, nanos = 0, samples = 0;
+    };
+
+    Slot& slotFor(PlanOperator* op) {
+        for (auto& slot : slots) {
+            if (slot.op == op) return slot;
+        }
+        slots.push_back({op});
+        return slots.back();
+    }
+
+    bool active;
+    bool timing = false;
+    std::uint64_t rows = 0, sampled = 0;
+    std::uint64_t mark = 0;
+    std::chrono::steady_clock::time_point clock;
+    std::vector<Slot> slots;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include "ResultCache.h"
+
+#include <filesystem>
+
+#include "AppendLock.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+//rows are sent on in blocks of about this size
+const size_t kReplayBlock = 1u << 20;
+
+size_t entryBytes(const std::string& key, const ResultCache::Entry& entry) {
+    return key.size() + entry.header.size() + entry.rows.size();
+}
+
+} // namespace
+
+std::string ResultCache::key(const SelectStmt& stmt) {
+    std::string key = queryText(stmt);
+    for (const auto& table : queryTables(stmt)) {
+        //a text table is versioned by its committed length and tombstone count, which a write moves only
+        //once it is done, and by the generation VACUUM and CREATE TABLE move when they rewrite it
+        std::string path = "database/" + table + ".col";
+        bool columnar = fs::exists(path);
+        if (!columnar) path = "database/" + table + ".txt";
+        std::error_code ec;
+        auto modified = fs::last_write_time(path, ec);
+        if (ec) return "";
+        std::string version;
+        if (columnar) {
+            version = std::to_string(fs::file_size(path, ec));
+        } else {
+            TableSnapshot snapshot = readSnapshot(table);
+            version = std::to_string(snapshot.length) + "," + std::to_string(snapshot.deleted) + "," +
+                      std::to_string(snapshot.generation);
+        }
+        if (ec) return "";
+        key += "\n" + table + "," + version + "," + std::to_string(modified.time_since_epoch().count());
+    }
+    return key;
+}
+
+std::shared_ptr<const ResultCache::Entry> ResultCache::find(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end()) return nullptr;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->second;
+}
+
+void ResultCache::insert(const std::string& key, std::shared_ptr<const Entry> entry, size_t capacity) {
+    size_t size = entryBytes(key, *entry);
+    if (size > capacity) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it != index.end()) {
+        bytes -= entryBytes(key, *it->second->second);
+        entries.erase(it->second);
+        index.erase(it);
+    }
+    entries.emplace_front(key, std::move(entry));
+    index[key] = entries.begin();
+    bytes += size;
+
+    while (bytes > capacity) {
+        const Item& oldest = entries.back();
+        bytes -= entryBytes(oldest.first, *oldest.second);
+        index.erase(oldest.first);
+        entries.pop_back();
+    }
+}
+
+void ResultRecorder::header(std::string_view line) {
+    target.header(line);
+    if (entry) complete = false; //a second result
+    else entry = std::make_shared<ResultCache::Entry>();
+    if (complete) entry->header.assign(line);
+}
+
+void ResultRecorder::rows(std::string_view lines) {
+    target.rows(lines);
+    if (!complete || !entry) return;
+    if (entry->header.size() + entry->rows.size() + lines.size() > limit) {
+        complete = false;
+        entry->rows.clear();
+        entry->rows.shrink_to_fit();
+        return;
+    }
+    entry->rows.append(lines);
+}
+
+void ResultRecorder::message(std::string_view text) {
+    target.message(text);
+    complete = false;
+}
+
+std::shared_ptr<const ResultCache::Entry> ResultRecorder::take() {
+    if (!complete || !entry) return nullptr;
+    return std::move(entry);
+}
+
+void replayResult(const ResultCache::Entry& entry, ResultSink& sink) {
+    sink.header(entry.header);
+    std::string_view rows = entry.rows;
+    while (!rows.empty()) {
+        //cut after the last whole line of the block
+        size_t end = rows.size();
+        if (end > kReplayBlock) {
+            size_t newline = rows.rfind('\n', kReplayBlock - 1);
+            if (newline == std::string_view::npos) newline = rows.find('\n');
+            end = newline == std::string_view::npos ? rows.size() : newline + 1;
+        }
+        sink.rows(rows.substr(0, end));
+        rows.remove_prefix(end);
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "IDimDatabase.h"
+#include "SqlParser.h"
+
+//results of recent queries, replayed when the same query runs again on unchanged tables. an entry
+//is keyed by the query's text and the size and modification time of every table it reads, so a
+//write to any of them leaves the entry unreachable; the least recently used entries are evicted
+//once the cached results take more than the capacity
+class ResultCache {
+public:
+    struct Entry {
+        std::string header;
+        std::string rows;
+    };
+
+    //key of a query, empty if one of its tables does not exist
+    static std::string key(const SelectStmt& stmt);
+
+    std::shared_ptr<const Entry> find(const std::string& key);
+    void insert(const std::string& key, std::shared_ptr<const Entry> entry, size_t capacity);
+
+private:
+    using Item = std::pair<std::string, std::shared_ptr<const Entry>>;
+
+    std::mutex mutex;
+    std::list<Item> entries; //most recently used first
+    std::unordered_map<std::string, std::list<Item>::iterator> index;
+    size_t bytes = 0;
+};
+
+//passes a query's result on to another sink, keeping a copy for the cache while it stays within
+//a limit
+class ResultRecorder : public ResultSink {
+public:
+    ResultRecorder(ResultSink& target, size_t limit) : target(target), limit(limit) {}
+
+    void header(std::string_view line) override;
+    void rows(std::string_view lines) override;
+    void message(std::string_view text) override;
+
+    //the recorded result, nullptr if there was none or it could not be kept
+    std::shared_ptr<const ResultCache::Entry> take();
+
+private:
+    ResultSink& target;
+    size_t limit;
+    std::shared_ptr<ResultCache::Entry> entry;
+    bool complete = true; //false once the result outgrew the limit or something else was printed
+};
+
+//sends a cached result to a sink
+void replayResult(const ResultCache::Entry& entry, ResultSink& sink);
+
+#endif
@@ -0,0 +1,168 @@
+#include "ResultWriter.h"
+
+#include <array>
+#include <cerrno>
+
+#include <unistd.h>
+
+#include "CsvScanner.h"
+
+BufferedWriter::BufferedWriter(int fd) : fd(fd) {
+    buffer.reserve(kBufferSize);
+}
+
+BufferedWriter::~BufferedWriter() {
+    flush();
+}
+
+void BufferedWriter::writeOut(std::string_view text) {
+    while (!text.empty() && !failed) {
+        ssize_t n = ::write(fd, text.data(), text.size());
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) failed = true;
+        else text.remove_prefix(n);
+    }
+}
+
+bool BufferedWriter::flush() {
+    writeOut(buffer);
+    buffer.clear();
+    return !failed;
+}
+
+int BufferedWriter::overflow(int c) {
+    if (c != traits_type::eof()) put(traits_type::to_char_type(c));
+    return traits_type::not_eof(c);
+}
+
+std::streamsize BufferedWriter::xsputn(const char* text, std::streamsize count) {
+    write(std::string_view(text, count));
+    return count;
+}
+
+int BufferedWriter::sync() {
+    return flush() ? 0 : -1;
+}
+
+bool parseOutputFormat(const std::string& name, OutputFormat& format) {
+    if (name == "text") format = OutputFormat::Text;
+    else if (name == "csv") format = OutputFormat::Csv;
+    else if (name == "tsv") format = OutputFormat::Tsv;
+    else if (name == "binary") format = OutputFormat::Binary;
+    else return false;
+    return true;
+}
+
+std::string_view decodeValue(std::string_view value, std::string& scratch) {
+    if (value.size() < 2 || value.front() != '\'' || value.back() != '\'') return value;
+    value = value.substr(1, value.size() - 2);
+    if (value.find('\'') == std::string_view::npos) return value;
+    scratch.clear();
+    for (size_t i = 0; i < value.size(); ++i) {
+        scratch += value[i];
+        if (value[i] == '\'' && i + 1 < value.size() && value[i + 1] == '\'') ++i;
+    }
+    return scratch;
+}
+
+//helper function to check whether a value has characters that CSV has to quote, or TSV to escape
+bool needsEscaping(std::string_view value, OutputFormat format) {
+    static const auto special = [] {
+        std::array<std::uint8_t, 256> table{};
+        for (unsigned char c : {',', '"', '\r', '\n'}) table[c] |= 1;
+        for (unsigned char c : {'\t', '\r', '\n', '\\'}) table[c] |= 2;
+        return table;
+    }();
+    std::uint8_t mask = format == OutputFormat::Csv ? 1 : 2;
+    for (unsigned char c : value) {
+        if (special[c] & mask) return true;
+    }
+    return false;
+}
+
+void FormatSink::header(std::string_view line) {
+    writeLine(line, 'H');
+}
+
+void FormatSink::rows(std::string_view lines) {
+    if (format == OutputFormat::Text) {
+        writer.write(lines);
+        return;
+    }
+    while (!lines.empty()) {
+        size_t newline = lines.find('\n');
+        writeLine(lines.substr(0, newline), 'R');
+        lines.remove_prefix(newline == std::string_view::npos ? lines.size() : newline + 1);
+    }
+}
+
+void FormatSink::message(std::string_view text) {
+    if (format != OutputFormat::Binary) {
+        writer.write(text);
+        return;
+    }
+    while (!text.empty()) {
+        size_t newline = text.find('\n');
+        std::string_view line = text.substr(0, newline);
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+        writer.put('M');
+        writeLength(line.size());
+        writer.write(line);
+    }
+}
+
+void FormatSink::writeLength(std::uint32_t length) {
+    char bytes[4] = {static_cast<char>(length >> 24), static_cast<char>(length >> 16),
+                     static_cast<char>(length >> 8), static_cast<char>(length)};
+    writer.write(std::string_view(bytes, 4));
+}
+
+//writes one header or data line in the sink's format
+void FormatSink::writeLine(std::string_view line, char tag) {
+    if (format == OutputFormat::Text) {
+        writer.write(line);
+        writer.put('\n');
+        return;
+    }
+
+    //a row drops its trailing empty values when split; they are put back to fill the header
+    splitRow(line, values);
+    if (tag == 'H') columns = values.size();
+    else if (values.size() < columns) values.resize(columns);
+    if (format == OutputFormat::Binary) {
+        writer.put(tag);
+        writeLength(values.size());
+    }
+    for (size_t i = 0; i < values.size(); ++i) {
+        std::string_view value = decodeValue(values[i], scratch);
+        if (format == OutputFormat::Binary) {
+            writeLength(value.size());
+            writer.write(value);
+            continue;
+        }
+        if (i > 0) writer.put(format == OutputFormat::Csv ? ',' : '\t');
+        if (!needsEscaping(value, format)) {
+            writer.write(value);
+            continue;
+        }
+        if (format == OutputFormat::Csv) {
+            writer.put('"');
+            for (char c : value) {
+                if (c == '"') writer.put('"');
+                writer.put(c);
+            }
+            writer.put('"');
+            continue;
+        }
+        for (char c : value) {
+            switch (c) {
+            case '\t': writer.write("\\t"); break;
+            case '\n': writer.write("\\n"); break;
+            case '\r': writer.write("\\r"); break;
+            case '\\': writer.write("\\\\"); break;
+            default: writer.put(c);
+            }
+        }
+    }
+    if (format != OutputFormat::Binary) writer.put('\n');
+}
@@ -0,0 +1,91 @@
+#ifndef RESULT_WRITER_H
+#define RESULT_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "IDimDatabase.h"
+
+//buffered writer over a file descriptor. output collects in a large buffer that goes out in big
+//writes, so printing a result costs a memcpy per line instead of a stream call per value. it is a
+//streambuf, so an std::ostream can write through it too.
+class BufferedWriter : public std::streambuf {
+public:
+    static constexpr size_t kBufferSize = 1u << 20;
+
+    explicit BufferedWriter(int fd);
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+    ~BufferedWriter() override;
+
+    void write(std::string_view text) {
+        if (buffer.size() + text.size() > kBufferSize) flush();
+        if (text.size() >= kBufferSize) writeOut(text);
+        else buffer.append(text);
+    }
+
+    void put(char c) {
+        if (buffer.size() == kBufferSize) flush();
+        buffer.push_back(c);
+    }
+
+    //writes out everything buffered, false once a write has failed (the reader went away)
+    bool flush();
+
+protected:
+    int overflow(int c) override;
+    std::streamsize xsputn(const char* text, std::streamsize count) override;
+    int sync() override;
+
+private:
+    void writeOut(std::string_view text);
+
+    int fd;
+    std::string buffer;
+    bool failed = false;
+};
+
+//how results are written
+enum class OutputFormat {
+    Text,  //as stored: the header and rows as comma separated lines, quoted values keep their quotes
+    Csv,   //RFC 4180: values are unquoted, then quoted with "" where they need it
+    Tsv,   //values are unquoted, separated by tabs, with \t \n \r and \\ escaped
+    Binary //length-prefixed frames, see FormatSink
+};
+
+//parses "text", "csv", "tsv" or "binary"
+bool parseOutputFormat(const std::string& name, OutputFormat& format);
+
+//value as it was written in a command: a value stored with quotes ('Sofia, BG') loses them, and a
+//'' inside stands for one quote. returns a view of value itself, or of scratch
+std::string_view decodeValue(std::string_view value, std::string& scratch);
+
+//writes query results and messages to a BufferedWriter in one format. the binary format is a
+//sequence of frames, one tag byte followed by 4-byte big-endian lengths as in the server protocol:
+//  'H' count, then count times (length, bytes)   column names of a result
+//  'R' count, then count times (length, bytes)   one row
+//  'M' length, bytes                             one line of other output, without its newline
+class FormatSink : public ResultSink {
+public:
+    FormatSink(OutputFormat format, BufferedWriter& writer) : format(format), writer(writer) {}
+
+    void header(std::string_view line) override;
+    void rows(std::string_view lines) override;
+    void message(std::string_view text) override;
+
+private:
+    void writeLine(std::string_view line, char tag);
+    void writeLength(std::uint32_t length);
+
+    OutputFormat format;
+    BufferedWriter& writer;
+    size_t columns = 0; //of the current result
+    std::vector<std::string_view> values;
+    std::string scratch;
+};
+
+#endif
@@ -0,0 +1,18 @@
+#include "RowBatch.h"
+
+void RowBuffer::clear() {
+    records.clear();
+    if (batches.size() > 1) batches.erase(batches.begin(), batches.end() - 1);
+    if (!batches.empty()) batches[0]->reset();
+    arenaBytes = batches.empty() ? 0 : batches[0]->capacity();
+}
+
+char* RowBuffer::allocate(size_t bytes) {
+    if (!batches.empty()) {
+        if (char* record = batches.back()->allocate(bytes)) return record;
+    }
+    size_t capacity = batches.empty() ? kFirstBatchSize : std::min(kBatchSize, 2 * batches.back()->capacity());
+    batches.push_back(std::make_unique<RowBatch>(std::max(capacity, (bytes + 3) & ~size_t(3))));
+    arenaBytes += batches.back()->capacity();
+    return batches.back()->allocate(bytes);
+}
@@ -0,0 +1,112 @@
+#ifndef ROW_BATCH_H
+#define ROW_BATCH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+//a row held in a RowBuffer. the row is one record in its batch's arena: the cell count, the end
+//offset of each cell, then the bytes of every cell back to back. indexable like a Row, and valid
+//until the buffer is cleared
+class BufferedRow {
+public:
+    BufferedRow() = default;
+    explicit BufferedRow(const char* record) : record(record) {}
+
+    size_t size() const { return word(0); }
+    bool empty() const { return size() == 0; }
+
+    std::string_view operator[](size_t i) const {
+        std::uint32_t begin = i == 0 ? 0 : word(i);
+        return std::string_view(record + 4 * (size() + 1) + begin, word(i + 1) - begin);
+    }
+
+private:
+    std::uint32_t word(size_t i) const {
+        std::uint32_t value;
+        std::memcpy(&value, record + 4 * i, 4);
+        return value;
+    }
+
+    const char* record = nullptr;
+};
+
+//one contiguous arena of row records, filled front to back and never moved
+class RowBatch {
+public:
+    explicit RowBatch(size_t capacity) : arena(new char[capacity]), capacityBytes(capacity) {}
+
+    //space for a record of bytes bytes, nullptr once the batch is full
+    char* allocate(size_t bytes) {
+        bytes = (bytes + 3) & ~size_t(3);
+        if (bytes > capacityBytes - used) return nullptr;
+        char* record = arena.get() + used;
+        used += bytes;
+        return record;
+    }
+
+    void reset() { used = 0; }
+    size_t capacity() const { return capacityBytes; }
+
+private:
+    std::unique_ptr<char[]> arena;
+    size_t capacityBytes;
+    size_t used = 0;
+};
+
+//rows buffered by an operator (a join's build side, a sort run, a cached table). each row is
+//copied into the current batch's arena, so buffering it allocates nothing of its own, and the
+//whole buffer is released at once when it is destroyed
+class RowBuffer {
+public:
+    static constexpr size_t kFirstBatchSize = 4u << 10; //batches double up to kBatchSize
+    static constexpr size_t kBatchSize = 1u << 20;      //a larger row gets a batch of its own size
+
+    //copies a row (anything indexable whose items convert to string_view) and returns its index
+    template <typename Values>
+    size_t add(const Values& row) {
+        size_t count = row.size(), textBytes = 0;
+        for (size_t i = 0; i < count; ++i) textBytes += std::string_view(row[i]).size();
+        char* record = allocate(4 * (count + 1) + textBytes);
+        char* text = record + 4 * (count + 1);
+        std::uint32_t words[2] = {static_cast<std::uint32_t>(count), 0};
+        std::memcpy(record, &words[0], 4);
+        for (size_t i = 0; i < count; ++i) {
+            std::string_view cell = row[i];
+            std::memcpy(text + words[1], cell.data(), cell.size());
+            words[1] += cell.size();
+            std::memcpy(record + 4 * (i + 1), &words[1], 4);
+        }
+        records.push_back(record);
+        peak = std::max(peak, bytes());
+        return records.size() - 1;
+    }
+
+    BufferedRow operator[](size_t i) const { return BufferedRow(records[i]); }
+    BufferedRow back() const { return BufferedRow(records.back()); }
+    size_t size() const { return records.size(); }
+    bool empty() const { return records.empty(); }
+
+    //drops every row, keeping the last (largest) batch for the rows added next
+    void clear();
+
+    //memory held: the batches plus the row index
+    size_t bytes() const { return arenaBytes + records.capacity() * sizeof(const char*); }
+
+    //largest bytes() since the buffer was created
+    size_t peakBytes() const { return peak; }
+
+private:
+    char* allocate(size_t bytes);
+
+    std::vector<std::unique_ptr<RowBatch>> batches;
+    std::vector<const char*> records;
+    size_t arenaBytes = 0;
+    size_t peak = 0;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include "Schema.h"
+
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string schemaPath(const std::string& tableName) {
+    return "database/" + tableName + ".schema";
+}
+
+bool typeFromName(std::string word, ValueType& type) {
+    for (auto& c : word) c = std::toupper(static_cast<unsigned char>(c));
+    if (word == "INT" || word == "INTEGER" || word == "BIGINT") type = ValueType::Int;
+    else if (word == "DOUBLE" || word == "FLOAT" || word == "REAL") type = ValueType::Double;
+    else if (word == "TEXT" || word == "VARCHAR" || word == "STRING") type = ValueType::Text;
+    else return false;
+    return true;
+}
+
+//quoted numbers are accepted for numeric columns
+std::string_view stripQuotes(std::string_view value) {
+    if (value.size() >= 2 && value.front() == '\'' && value.back() == '\'') return value.substr(1, value.size() - 2);
+    return value;
+}
+
+} // namespace
+
+const char* typeName(ValueType type) {
+    switch (type) {
+        case ValueType::Int: return "INT";
+        case ValueType::Double: return "DOUBLE";
+        case ValueType::Text: return "TEXT";
+        default: return "ANY";
+    }
+}
+
+void parseColumnDef(const std::string& item, std::string& name, ValueType& type) {
+    name = item;
+    type = ValueType::Any;
+    size_t space = item.find_last_of(" \t");
+    if (space == std::string::npos) return;
+
+    ValueType declared;
+    if (!typeFromName(item.substr(space + 1), declared)) return;
+    size_t end = item.find_last_not_of(" \t", space);
+    if (end == std::string::npos) return;
+    name = item.substr(0, end + 1);
+    type = declared;
+}
+
+std::vector<ValueType> loadSchema(const std::string& tableName, size_t columnCount) {
+    std::vector<ValueType> types(columnCount, ValueType::Any);
+    std::ifstream schema(schemaPath(tableName));
+    std::string line;
+    for (size_t col = 0; col < columnCount && std::getline(schema, line); ++col) {
+        auto comma = line.rfind(',');
+        if (comma != std::string::npos) typeFromName(line.substr(comma + 1), types[col]);
+    }
+    return types;
+}
+
+void saveSchema(const std::string& tableName, const std::vector<std::string>& names,
+                const std::vector<ValueType>& types) {
+    dropSchema(tableName);
+    bool typed = false;
+    for (auto type : types) typed = typed || type != ValueType::Any;
+    if (!typed) return;
+
+    std::ofstream schema(schemaPath(tableName));
+    for (size_t i = 0; i < names.size(); ++i) schema << names[i] << "," << typeName(types[i]) << "\n";
+    schema.close();
+    fs::permissions(schemaPath(tableName),
+                    fs::perms::owner_all | fs::perms::group_all | fs::perms::others_all,
+                    fs::perm_options::replace);
+}
+
+void dropSchema(const std::string& tableName) {
+    std::error_code ec;
+    fs::remove(schemaPath(tableName), ec);
+}
+
+bool normalizeValue(ValueType type, std::string_view value, std::string& out) {
+    if (type == ValueType::Any || type == ValueType::Text) {
+        out.assign(value);
+        return true;
+    }
+
+    std::string_view digits = stripQuotes(value);
+    if (!digits.empty() && digits.front() == '+') digits.remove_prefix(1);
+    const char* end = digits.data() + digits.size();
+    char buffer[32];
+
+    if (type == ValueType::Int) {
+        std::int64_t number;
+        auto parsed = std::from_chars(digits.data(), end, number);
+        if (digits.empty() || parsed.ec != std::errc() || parsed.ptr != end) return false;
+        out.assign(buffer, std::to_chars(buffer, buffer + sizeof(buffer), number).ptr);
+        return true;
+    }
+
+    double number;
+    auto parsed = std::from_chars(digits.data(), end, number);
+    if (digits.empty() || parsed.ec != std::errc() || parsed.ptr != end || number != number) return false;
+    if (number == 0) number = 0; //store -0 as 0
+    out.assign(buffer, std::to_chars(buffer, buffer + sizeof(buffer), number).ptr);
+    return true;
+}
@@ -0,0 +1,31 @@
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+//declared type of a table column; columns created without a type are Any and keep the
+//original behavior of comparing as text or, for range operators, as parsed numbers
+enum class ValueType { Any, Int, Double, Text };
+
+const char* typeName(ValueType type);
+
+//splits a CREATE TABLE column item such as "gpa DOUBLE" into its name and type. an item whose
+//last word is not a known type is an untyped column named by the whole item.
+void parseColumnDef(const std::string& item, std::string& name, ValueType& type);
+
+//column types of a table (database/<table>.schema), Any for every column without one
+std::vector<ValueType> loadSchema(const std::string& tableName, size_t columnCount);
+
+//records the column types of a table; a table with only untyped columns has no schema file
+void saveSchema(const std::string& tableName, const std::vector<std::string>& names,
+                const std::vector<ValueType>& types);
+
+void dropSchema(const std::string& tableName);
+
+//checks a value against a column type and writes its stored form to out: integers and doubles
+//are stored in canonical shortest form, other values as written. false if the value does not fit.
+bool normalizeValue(ValueType type, std::string_view value, std::string& out);
+
+#endif
@@ -0,0 +1,185 @@
+#include "Server.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "IDimDatabase.h"
+#include "Protocol.h"
+
+namespace {
+
+int wakePipe[2] = {-1, -1};
+std::atomic<bool> stopping{false};
+
+void handleStopSignal(int) {
+    stopping = true;
+    char byte = 0;
+    [[maybe_unused]] ssize_t n = ::write(wakePipe[1], &byte, 1);
+}
+
+//connections with a request ready are handed to the workers; once the reply is written the
+//connection goes back to the poller, so an idle client never holds a worker
+class RequestQueue {
+public:
+    void push(int fd) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.push_back(fd);
+        }
+        cv.notify_one();
+    }
+
+    //blocks until a connection is ready, returns -1 on shutdown
+    int pop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&] { return closed || !ready.empty(); });
+        if (ready.empty()) return -1;
+        int fd = ready.front();
+        ready.pop_front();
+        return fd;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        cv.notify_all();
+    }
+
+    //connections whose reply has been sent and that wait for their next request
+    void giveBack(int fd) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            idle.push_back(fd);
+        }
+        char byte = 0;
+        [[maybe_unused]] ssize_t n = ::write(wakePipe[1], &byte, 1);
+    }
+
+    std::vector<int> takeIdle() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<int> fds(idle.begin(), idle.end());
+        idle.clear();
+        return fds;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<int> ready;
+    std::deque<int> idle;
+    bool closed = false;
+};
+
+//runs one command, capturing exactly what one-shot mode would print
+std::string runCommand(const std::string& sql_cmd) {
+    std::ostringstream reply;
+    OutputCapture capture(reply);
+    try {
+        executeSqlCommand(sql_cmd);
+    } catch (const std::exception& e) {
+        reply << "Error: " << e.what() << "\n";
+    }
+    return reply.str();
+}
+
+void workerLoop(RequestQueue& queue) {
+    std::string request;
+    for (int fd = queue.pop(); fd >= 0; fd = queue.pop()) {
+        if (!readFrame(fd, request) || !writeFrame(fd, runCommand(request))) {
+            ::close(fd);
+            continue;
+        }
+        queue.giveBack(fd);
+    }
+}
+
+} // namespace
+
+int runServer(const std::string& socketPath, std::size_t workers) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cout << "Error: Socket path '" << socketPath << "' is too long.\n";
+        return 1;
+    }
+    std::strcpy(addr.sun_path, socketPath.c_str());
+
+    int listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ::unlink(socketPath.c_str());
+    if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listenFd, SOMAXCONN) != 0) {
+        std::cout << "Error: Could not listen on '" << socketPath << "': " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    if (::pipe(wakePipe) != 0) {
+        std::cout << "Error: Could not create wake-up pipe.\n";
+        return 1;
+    }
+    ::fcntl(wakePipe[0], F_SETFL, O_NONBLOCK);
+    std::signal(SIGPIPE, SIG_IGN);
+    std::signal(SIGINT, handleStopSignal);
+    std::signal(SIGTERM, handleStopSignal);
+
+    RequestQueue queue;
+    std::vector<std::thread> pool;
+    for (std::size_t i = 0; i < workers; ++i) {
+        pool.emplace_back(workerLoop, std::ref(queue));
+    }
+    std::cout << "Listening on '" << socketPath << "' with " << workers << " workers.\n" << std::flush;
+
+    //poll the listening socket, the wake-up pipe and every idle connection
+    std::vector<int> idle;
+    while (!stopping) {
+        std::vector<pollfd> fds = {{listenFd, POLLIN, 0}, {wakePipe[0], POLLIN, 0}};
+        for (int fd : idle) fds.push_back({fd, POLLIN, 0});
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            char buffer[64];
+            while (::read(wakePipe[0], buffer, sizeof(buffer)) > 0) {
+            }
+        }
+
+        std::vector<int> stillIdle;
+        for (std::size_t i = 2; i < fds.size(); ++i) {
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) queue.push(fds[i].fd);
+            else stillIdle.push_back(fds[i].fd);
+        }
+        idle = std::move(stillIdle);
+        for (int fd : queue.takeIdle()) idle.push_back(fd);
+
+        if (fds[0].revents & POLLIN) {
+            int client = ::accept(listenFd, nullptr, nullptr);
+            if (client >= 0) idle.push_back(client);
+        }
+    }
+
+    queue.close();
+    for (auto& thread : pool) thread.join();
+    for (int fd : idle) ::close(fd);
+    for (int fd : queue.takeIdle()) ::close(fd);
+    ::close(listenFd);
+    ::unlink(socketPath.c_str());
+    std::cout << "Server stopped.\n";
+    return 0;
+}
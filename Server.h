@@ -0,0 +1,11 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <cstddef>
+#include <string>
+
+//serves SQL commands to sql_client over a Unix domain socket until SIGINT or SIGTERM.
+//each request runs on one of `workers` threads.
+int runServer(const std::string& socketPath, std::size_t workers);
+
+#endif
@@ -0,0 +1,788 @@
+#include "SqlParser.h"
+
+#include <cctype>
+#include <charconv>
+
+namespace {
+
+bool isWordChar(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool isSpace(char c) {
+    return std::isspace(static_cast<unsigned char>(c));
+}
+
+std::string toLower(std::string_view text) {
+    std::string lower(text);
+    for (auto& c : lower) c = std::tolower(static_cast<unsigned char>(c));
+    return lower;
+}
+
+//case-insensitive comparison against an uppercase keyword
+bool isKeyword(const Token& token, std::string_view keyword) {
+    if (token.type != TokenType::Word || token.text.size() != keyword.size()) return false;
+    for (size_t i = 0; i < keyword.size(); ++i) {
+        if (std::toupper(static_cast<unsigned char>(token.text[i])) != keyword[i]) return false;
+    }
+    return true;
+}
+
+bool isSymbol(const Token& token, std::string_view symbol) {
+    return token.type == TokenType::Symbol && token.text == symbol;
+}
+
+//strips the quotes of a 'literal' and folds '' into '
+std::string unquote(std::string_view quoted) {
+    std::string text;
+    size_t end = quoted.size() > 1 && quoted.back() == '\'' ? quoted.size() - 1 : quoted.size();
+    for (size_t i = 1; i < end; ++i) {
+        text.push_back(quoted[i]);
+        if (quoted[i] == '\'' && i + 1 < end && quoted[i + 1] == '\'') ++i;
+    }
+    return text;
+}
+
+//scans past a quoted literal starting at pos, returns the position after its closing quote
+size_t skipQuoted(std::string_view src, size_t pos) {
+    ++pos;
+    while (pos < src.size()) {
+        if (src[pos] == '\'') {
+            if (pos + 1 < src.size() && src[pos + 1] == '\'') {
+                pos += 2;
+                continue;
+            }
+            return pos + 1;
+        }
+        ++pos;
+    }
+    return pos;
+}
+
+enum class Kind { Unknown, CreateTable, CreateIndex, Insert, Copy, Select, Join, SelectWhere, GroupBy, OrderBy, Limit, Explain, Desc, Convert, Prepare, Execute, Analyze, CreateView, Delete, Update, Vacuum };
+
+std::string syntaxError(Kind kind) {
+    switch (kind) {
+        case Kind::CreateTable: return "Error: Invalid CREATE TABLE syntax.";
+        case Kind::CreateIndex: return "Error: Invalid CREATE INDEX syntax. Use: CREATE INDEX name ON table(column)";
+        case Kind::Insert: return "Error: Invalid INSERT INTO syntax.";
+        case Kind::Copy: return "Error: Invalid COPY syntax. Use: COPY tablename FROM 'file.csv' [HEADER]";
+        case Kind::Select: return "Error: Invalid SELECT syntax.";
+        case Kind::Join: return "Error: Invalid JOIN syntax.";
+        case Kind::SelectWhere: return "Error: Invalid SELECT WITH WHERE syntax.";
+        case Kind::GroupBy: return "Error: Invalid GROUP BY syntax.";
+        case Kind::OrderBy: return "Error: Invalid ORDER BY syntax.";
+        case Kind::Limit: return "Error: Invalid LIMIT syntax. Use: LIMIT count";
+        case Kind::Explain: return "Error: Invalid EXPLAIN syntax. Use: EXPLAIN [ANALYZE] SELECT ...";
+        case Kind::Desc: return "Error: Invalid DESC syntax. Use: DESC tablename";
+        case Kind::Convert: return "Error: Invalid CONVERT syntax. Use: CONVERT TABLE tablename TO COLUMNAR [COMPRESSED]|TEXT";
+        case Kind::Prepare: return "Error: Invalid PREPARE syntax. Use: PREPARE name AS statement";
+        case Kind::Execute: return "Error: Invalid EXECUTE syntax. Use: EXECUTE name(value, ...)";
+        case Kind::Analyze: return "Error: Invalid ANALYZE syntax. Use: ANALYZE tablename";
+        case Kind::CreateView: return "Error: Invalid CREATE MATERIALIZED VIEW syntax. Use: CREATE MATERIALIZED VIEW name AS SELECT ...";
+        case Kind::Delete: return "Error: Invalid DELETE syntax. Use: DELETE FROM tablename [WHERE condition]";
+        case Kind::Update: return "Error: Invalid UPDATE syntax. Use: UPDATE tablename SET column = value, ... [WHERE condition]";
+        case Kind::Vacuum: return "Error: Invalid VACUUM syntax. Use: VACUUM tablename";
+        default: return "Error: Unrecognized SQL command.";
+    }
+}
+
+//recursive-descent parser; each parse function returns false on a syntax error and leaves
+//`kind` describing the command it was in, which selects the error message
+class Parser {
+public:
+    explicit Parser(const std::string& sql) : lex(sql) {}
+
+    bool parseScript(std::vector<Statement>& statements, std::string& error) {
+        while (true) {
+            Token token = lex.peek();
+            if (token.type == TokenType::End) break;
+            if (isSymbol(token, ";")) {
+                lex.next();
+                continue;
+            }
+
+            Statement statement;
+            kind = Kind::Unknown;
+            if (!parseStatement(statement) || !endOfStatement()) {
+                error = paramError.empty() ? syntaxError(kind) : paramError;
+                return false;
+            }
+            statements.push_back(std::move(statement));
+        }
+        if (statements.empty()) {
+            error = syntaxError(Kind::Unknown);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    bool endOfStatement() {
+        Token token = lex.next();
+        return token.type == TokenType::End || isSymbol(token, ";");
+    }
+
+    bool keyword(std::string_view word) {
+        if (!isKeyword(lex.peek(), word)) return false;
+        lex.next();
+        return true;
+    }
+
+    bool symbol(std::string_view sym) {
+        if (!isSymbol(lex.peek(), sym)) return false;
+        lex.next();
+        return true;
+    }
+
+    bool identifier(std::string& out) {
+        Token token = lex.next();
+        if (token.type != TokenType::Word) return false;
+        out = std::string(token.text);
+        return true;
+    }
+
+    bool columnRef(ColumnRef& ref) {
+        std::string first;
+        return identifier(first) && qualifiedColumn(first, ref);
+    }
+
+    //the rest of a column reference whose first identifier has been read
+    bool qualifiedColumn(const std::string& first, ColumnRef& ref) {
+        if (!symbol(".")) {
+            ref.column = first;
+            return true;
+        }
+        ref.table = toLower(first);
+        return identifier(ref.column);
+    }
+
+    bool literal(const Token& token, Literal& out) {
+        if (token.type == TokenType::End) return false;
+        out.raw = std::string(token.text);
+        if (isSymbol(token, "?")) {
+            if (!allowParams) {
+                paramError = "Error: Parameters (?) are only allowed in PREPARE statements.";
+                return false;
+            }
+            out.param = paramCount++;
+        }
+        out.text = token.type == TokenType::String ? unquote(token.text) : out.raw;
+        return true;
+    }
+
+    //'(' item, item, ... ')' with each item kept as written. with emptyItems a missing item, as in
+    //(3,) or (,4), is an empty value; an empty list is still an error
+    bool rawList(std::vector<Literal>& items, bool emptyItems = false) {
+        if (!symbol("(")) return false;
+        do {
+            Literal item;
+            Token token = lex.rawListItem();
+            if ((token.text.empty() && !emptyItems) || !literal(token, item)) return false;
+            items.push_back(std::move(item));
+        } while (symbol(","));
+        if (items.size() == 1 && items[0].raw.empty()) return false;
+        return symbol(")");
+    }
+
+    bool parseStatement(Statement& statement) {
+        if (keyword("CREATE")) {
+            if (keyword("TABLE")) return parseCreateTable(statement);
+            if (keyword("INDEX")) return parseCreateIndex(statement);
+            if (keyword("MATERIALIZED")) return parseCreateView(statement);
+            return false;
+        }
+        if (keyword("INSERT")) return parseInsert(statement);
+        if (keyword("COPY")) return parseCopy(statement);
+        if (keyword("SELECT")) return parseSelect(statement);
+        if (keyword("EXPLAIN")) return parseExplain(statement);
+        if (keyword("DESC")) return parseDesc(statement);
+        if (keyword("CONVERT")) return parseConvert(statement);
+        if (keyword("PREPARE")) return parsePrepare(statement);
+        if (keyword("EXECUTE")) return parseExecute(statement);
+        if (keyword("ANALYZE")) return parseAnalyze(statement);
+        if (keyword("DELETE")) return parseDelete(statement);
+        if (keyword("UPDATE")) return parseUpdate(statement);
+        if (keyword("VACUUM")) return parseVacuum(statement);
+        return false;
+    }
+
+    bool parseCreateTable(Statement& statement) {
+        kind = Kind::CreateTable;
+        CreateTableStmt stmt;
+        std::vector<Literal> columns;
+        if (!identifier(stmt.table) || !rawList(columns)) return false;
+        stmt.table = toLower(stmt.table);
+        for (auto& column : columns) stmt.columns.push_back(std::move(column.raw));
+        statement.node = std::move(stmt);
+        return true;
+    }
+
+    bool parseCreateIndex(Statement& statement) {
+        kind = Kind::CreateIndex;
+        CreateIndexStmt stmt;
+        if (!identifier(stmt.index) || !keyword("ON") || !identifier(stmt.table) || !symbol("(") ||
+            !identifier(stmt.column) || !symbol(")")) {
+            return false;
+        }
+        stmt.index = toLower(stmt.index);
+        stmt.table = toLower(stmt.table);
+        stmt.column = toLower(stmt.column);
+        statement.node = std::move(stmt);
+        return true;
+    }
+
+    bool parseCreateView(Statement& statement) {
+        kind = Kind::CreateView;
+        CreateViewStmt stmt;
+        if (!keyword("VIEW") || !identifier(stmt.view) || !keyword("AS") || !keyword("SELECT")) return false;
+        stmt.view = toLower(stmt.view);
+
+        //the query is stored and rerun as the view is maintained, so it cannot have placeholders
+        bool params = allowParams;
+        allowParams = false;
+        Statement query;
+        bool ok = parseSelect(query);
+        allowParams = params;
+        if (!ok) return false;
+        stmt.query = std::get<SelectStmt>(std::move(query.node));
+        statement.node = std::move(stmt);
+        return true;
+    }
+
+    bool parseInsert(Statement& statement) {
+        kind = Kind::Insert;
+        InsertStmt stmt;
+        if (!keyword("INTO") || !identifier(stmt.table) || !keyword("VALUES")) return false;
+        do {
+            stmt.rows.emplace_back();
+            if (!rawList(stmt.rows.back(), true)) return false;
+        } while (symbol(","));
+        stmt.table = toLower(stmt.table);
+        statement.node = std::move(stmt);
+        return true;
+    }
+
+    bool parseCopy(Statement& statement) {
+        kind = Kind::Copy;
+        CopyStmt stmt;
+        if (!identifier(stmt.table) || !keyword("FROM")) return false;
+        Token path = lex.next();
+        if (path.type != TokenType::String) return false;
+        stmt.table = toLower(stmt.table);
+        stmt.path = unquote(path.text);
+        stmt.header = keyword("HEADER");
+        statement.node = std::move(stmt);
+        return true;
+    }
+
+    bool parseSelect(Statement& statement) {
+        kind = Kind::Select;
+        SelectStmt stmt;
+        if (!symbol("*")) {
+            do {
+                ColumnRef ref;
+                if (!selectItem(ref)) return false;
+                stmt.columns.push_back(std::move(ref));
+            } while (symbol(","));
+        }
+        if (!keyword("FROM") || !identifier(stmt.table)) return false;
+        stmt.table = toLower(stmt.table);
+
+        while (keyword("JOIN")) {
+            kind = Kind::Join;
+            JoinClause join;
+            if (!identifier(join.table) || !keyword("ON") || !columnRef(join.left) || !symbol("=") ||
+                !columnRef(join.right) || join.left.table.empty() || join.right.table.empty()) {
+                return false;
+            }
+            join.table = toLower(join.table);
+            join.left.column = toLower(join.left.column);
+            join.right.column = toLower(join.right.column);
+            stmt.joins.push_back(std::move(join));
+        }
+
+        if (keyword("WHERE")) {
+            if (kind == Kind::Select) kind = Kind::SelectWhere;
+            if (!whereClause(!stmt.joins.empty(), stmt.where)) return false;
+        }
+
+        if (keyword("GROUP")) {
+            kind = Kind::GroupBy;
+            if (!keyword("BY")) return false;
+            do {
+                ColumnRef ref;
+                if (!columnRef(ref)) return false;
+                ref.column = toLower(ref.column);
+                stmt.groupBy.push_back(std::move(ref));
+            } while (symbol(","));
+        }
+
+        if (keyword("ORDER")) {
+            kind = Kind::OrderBy;
+            if (!keyword("BY")) return false;
+            do {
+                OrderKey key;
+                if (!selectItem(key.column)) return false;
+                key.column.column = toLower(key.column.column);
+                if (keyword("DESC")) key.descending = true;
+                else keyword("ASC");
+                stmt.orderBy.push_back(std::move(key));
+            } while (symbol(","));
+        }
+
+        if (keyword("LIMIT")) {
+            kind = Kind::Limit;
+            Token count = lex.next();
+            std::uint64_t limit;
+            const char* end = count.text.data() + count.text.size();
+            auto parsed = std::from_chars(count.text.data(), end, limit);
+            if (count.type != TokenType::Word || parsed.ec != std::errc() || parsed.ptr != end) return false;
+            stmt.limit = limit;
+        }
+
+        statement.node = std::move(stmt);
+        return true;
+    }
+
+    //the expression after WHERE; qualified: every column must name its table
+    bool whereClause(bool qualified, std::optional<Condition>& where) {
+        Condition condition;
+        qualifiedOnly = qualified;
+        parenDepth = 0;
+        if (!orExpression(condition)) return false;
+        where = std::move(condition);
+        return true;
+    }
+
+    //WHERE expressions: OR binds loosest, then AND, then NOT
+    bool orExpression(Condition& out) {
+        return combined(out, Condition::Type::Or, "OR", &Parser::andExpression);
+    }
+
+    bool andExpression(Condition& out) {
+        return combined(out, Condition::Type::And, "AND", &Parser::notExpression);
+    }
+
+    //operand (word operand)*, folded into one node when there is more than one operand
+    bool combined(Condition& out, Condition::Type type, std::string_view word, bool (Parser::*operand)(Condition&)) {
+        Condition first;
+        if (!(this->*operand)(first)) return false;
+        if (!isKeyword(lex.peek(), word)) {
+            out = std::move(first);
+            return true;
+        }
+        out = Condition();
+        out.type = type;
+        out.children.push_back(std::move(first));
+        while (keyword(word)) {
+            out.children.emplace_back();
+            if (!(this->*operand)(out.children.back())) return false;
+        }
+        return true;
+    }
+
+    bool notExpression(Condition& out) {
+        if (keyword("NOT")) {
+            Condition operand;
+            if (!notExpression(operand)) return false;
+            negate(out, std::move(operand));
+            return true;
+        }
+        if (symbol("(")) {
+            ++parenDepth;
+            if (!orExpression(out) || !symbol(")")) return false;
+            --parenDepth;
+            return true;
+        }
+        return columnTest(out);
+    }
+
+    static void negate(Condition& out, Condition operand) {
+        out = Condition();
+        out.type = Condition::Type::Not;
+        out.children.push_back(std::move(operand));
+    }
+
+    //column OP value, column [NOT] IN (...), column [NOT] BETWEEN low AND high, column [NOT] LIKE pattern
+    bool columnTest(Condition& out) {
+        Condition test;
+        if (!columnRef(test.column)) return false;
+        if (qualifiedOnly && test.column.table.empty()) return false;
+        test.column.column = toLower(test.column.column);
+
+        bool negated = keyword("NOT");
+        if (keyword("IN")) {
+            test.type = Condition::Type::In;
+            if (!rawList(test.values)) return false;
+        } else if (keyword("BETWEEN")) {
+            test.type = Condition::Type::Between;
+            test.values.resize(2);
+            if (!constant(test.values[0]) || !keyword("AND") || !constant(test.values[1])) return false;
+        } else if (keyword("LIKE")) {
+            test.type = Condition::Type::Like;
+            if (!constant(test.value)) return false;
+        } else {
+            Token op = lex.next();
+            if (negated || op.type != TokenType::Symbol ||
+                !(op.text == "=" || op.text == "!=" || op.text == "<" || op.text == "<=" || op.text == ">" ||
+                  op.text == ">=")) {
+                return false;
+            }
+            test.op = std::string(op.text);
+            if (!constant(test.value)) return false;
+        }
+
+        if (negated) negate(out, std::move(test));
+        else out = std::move(test);
+        return true;
+    }
+
+    bool constant(Literal& out) {
+        return literal(lex.rawValue(parenDepth > 0), out);
+    }
+
+    //a column, or an aggregate function applied to one
+    bool selectItem(ColumnRef& ref) {
+        std::string first;
+        if (!identifier(first)) return false;
+        if (!symbol("(")) return qualifiedColumn(first, ref);
+
+        ref.function = first;
+        for (auto& c : ref.function) c = std::toupper(static_cast<unsigned char>(c));
+        if (ref.function != "COUNT" && ref.function != "SUM" && ref.function != "AVG" && ref.function != "MIN" &&
+            ref.function != "MAX") {
+            return false;
+        }
+        if (ref.function == "COUNT" && symbol("*")) {
+            ref.column = "*";
+        } else {
+            std::string name;
+            if (!identifier(name) || !qualifiedColumn(name, ref)) return false;
+        }
+        return symbol(")");
+    }
+
+    bool parseDesc(Statement& statement) {
+        kind = Kind::Desc;
+        DescStmt stmt;
+        if (!identifier(stmt.table)) return false;
+        stmt.table = toLower(stmt.table);
+        statement.node = std::move(stmt);
+        return true;
+    }
+
+    bool parseAnalyze(Statement& statement) {
+        kind = Kind::Analyze;
+        AnalyzeStmt stmt;
+        if (!identifier(stmt.table)) return false;
+        stmt.table = toLower(stmt.table);
+        statement.node = std::move(stmt);
+        return true;
+    }
+
+    bool parseDelete(Statement& statement) {
+        kind = Kind::Delete;
+        DeleteStmt stmt;
+        if (!keyword("FROM") || !identifier(stmt.table)) return false;
+        stmt.table = toLower(stmt.table);
+        if (keyword("WHERE") && !whereClause(false, stmt.where)) return false;
+        statement.node = std::move(stmt);
+        return true;
+    }
+
+    bool parseUpdate(Statement& statement) {
+        kind = Kind::Update;
+        UpdateStmt stmt;
+        if (!identifier(stmt.table) || !keyword("SET")) return false;
+        stmt.table = toLower(stmt.table);
+        do {
+            Assignment assignment;
+            if (!identifier(assignment.column) || !symbol("=")) return false;
+            Token value = lex.rawValue(false, true);
+            if (value.text.empty() || !literal(value, assignment.value)) return false;
+            assignment.column = toLower(assignment.column);
+            stmt.assignments.push_back(std::move(assignment));
+        } while (symbol(","));
+        if (keyword("WHERE") && !whereClause(false, stmt.where)) return false;
+        statement.node = std::move(stmt);
+        return true;
+    }
+
+    bool parseVacuum(Statement& statement) {
+        kind = Kind::Vacuum;
+        VacuumStmt stmt;
+        if (!identifier(stmt.table)) return false;
+        stmt.table = toLower(stmt.table);
+        statement.node = std::move(stmt);
+        return true;
+    }
+
+    bool parseConvert(Statement& statement) {
+        kind = Kind::Convert;
+        ConvertStmt stmt;
+        if (!keyword("TABLE") || !identifier(stmt.table) || !keyword("TO")) return false;
+        stmt.table = toLower(stmt.table);
+        if (keyword("COLUMNAR")) {
+            stmt.toColumnar = true;
+            stmt.compressed = keyword("COMPRESSED");
+        } else if (!keyword("TEXT")) return false;
+        statement.node = std::move(stmt);
+        return true;
+    }
+
+    bool parseExplain(Statement& statement) {
+        kind = Kind::Explain;
+        ExplainStmt stmt;
+        stmt.analyze = keyword("ANALYZE");
+        Statement query;
+        if (!keyword("SELECT") || !parseSelect(query)) return false;
+        stmt.query = std::get<SelectStmt>(std::move(query.node));
+        statement.node = std::move(stmt);
+        return true;
+    }
+
+    bool parsePrepare(Statement& statement) {
+        kind = Kind::Prepare;
+        PrepareStmt stmt;
+        if (!identifier(stmt.name) || !keyword("AS")) return false;
+        stmt.name = toLower(stmt.name);
+
+        //the body may use ? placeholders; nested PREPARE/EXECUTE are not allowed
+        auto body = std::make_shared<Statement>();
+        if (isKeyword(lex.peek(), "PREPARE") || isKeyword(lex.peek(), "EXECUTE")) return false;
+        allowParams = true;
+        paramCount = 0;
+        bool ok = parseStatement(*body);
+        allowParams = false;
+        if (!ok) return false;
+
+        stmt.paramCount = paramCount;
+        stmt.body = std::move(body);
+        statement.node = std::move(stmt);
+        return true;
+    }
+
+    bool parseExecute(Statement& statement) {
+        kind = Kind::Execute;
+        ExecuteStmt stmt;
+        if (!identifier(stmt.name)) return false;
+        stmt.name = toLower(stmt.name);
+        if (isSymbol(lex.peek(), "(") && !rawList(stmt.args, true)) return false;
+        statement.node = std::move(stmt);
+        return true;
+    }
+
+    Lexer lex;
+    Kind kind = Kind::Unknown;
+    bool allowParams = false;
+    bool qualifiedOnly = false; //WHERE columns must name their table (joins)
+    int parenDepth = 0;
+    int paramCount = 0;
+    std::string paramError;
+};
+
+void bindLiteral(Literal& literal, const std::vector<Literal>& args) {
+    if (literal.param >= 0 && literal.param < static_cast<int>(args.size())) {
+        literal = args[literal.param];
+        literal.param = -1;
+    }
+}
+
+void bindCondition(Condition& condition, const std::vector<Literal>& args) {
+    bindLiteral(condition.value, args);
+    for (auto& value : condition.values) bindLiteral(value, args);
+    for (auto& child : condition.children) bindCondition(child, args);
+}
+
+void appendColumn(std::string& text, const ColumnRef& ref) {
+    if (!ref.function.empty()) text += ref.function + "(";
+    if (!ref.table.empty()) text += ref.table + ".";
+    text += ref.column;
+    if (!ref.function.empty()) text += ")";
+}
+
+//a WHERE expression, parenthesized where it would otherwise bind differently: an OR inside an AND,
+//an AND or OR inside a NOT
+void appendCondition(std::string& text, const Condition& condition, bool nested) {
+    bool group = condition.type == Condition::Type::Or || condition.type == Condition::Type::And;
+    if (nested && group) text += "(";
+    switch (condition.type) {
+        case Condition::Type::Compare:
+            appendColumn(text, condition.column);
+            text += " " + condition.op + " " + condition.value.raw;
+            break;
+        case Condition::Type::In:
+            appendColumn(text, condition.column);
+            text += " IN (";
+            for (size_t i = 0; i < condition.values.size(); ++i) {
+                if (i > 0) text += ", ";
+                text += condition.values[i].raw;
+            }
+            text += ")";
+            break;
+        case Condition::Type::Between:
+            appendColumn(text, condition.column);
+            text += " BETWEEN " + condition.values[0].raw + " AND " + condition.values[1].raw;
+            break;
+        case Condition::Type::Like:
+            appendColumn(text, condition.column);
+            text += " LIKE " + condition.value.raw;
+            break;
+        case Condition::Type::And:
+        case Condition::Type::Or:
+            for (size_t i = 0; i < condition.children.size(); ++i) {
+                if (i > 0) text += condition.type == Condition::Type::And ? " AND " : " OR ";
+                appendCondition(text, condition.children[i], condition.type == Condition::Type::And);
+            }
+            break;
+        case Condition::Type::Not:
+            text += "NOT ";
+            appendCondition(text, condition.children[0], true);
+            break;
+    }
+    if (nested && group) text += ")";
+}
+
+} // namespace
+
+void Lexer::skipSpace() {
+    while (pos < src.size() && isSpace(src[pos])) ++pos;
+}
+
+Token Lexer::peek() {
+    size_t saved = pos;
+    Token token = next();
+    pos = saved;
+    return token;
+}
+
+Token Lexer::next() {
+    skipSpace();
+    Token token;
+    token.pos = pos;
+    if (pos >= src.size()) return token;
+
+    size_t start = pos;
+    char c = src[pos];
+    if (isWordChar(c)) {
+        while (pos < src.size() && isWordChar(src[pos])) ++pos;
+        token.type = TokenType::Word;
+    } else if (c == '\'') {
+        pos = skipQuoted(src, pos);
+        token.type = TokenType::String;
+    } else if ((c == '!' || c == '<' || c == '>') && pos + 1 < src.size() && src[pos + 1] == '=') {
+        pos += 2;
+        token.type = TokenType::Symbol;
+    } else if (std::string_view("(),.*;?=<>").find(c) != std::string_view::npos) {
+        ++pos;
+        token.type = TokenType::Symbol;
+    } else {
+        ++pos;
+        token.type = TokenType::Other;
+    }
+    token.text = src.substr(start, pos - start);
+    return token;
+}
+
+Token Lexer::rawValue(bool inParens, bool inList) {
+    skipSpace();
+    Token token;
+    token.pos = pos;
+    if (pos >= src.size()) return token;
+
+    size_t start = pos;
+    if (src[pos] == '\'') {
+        pos = skipQuoted(src, pos);
+        token.type = TokenType::String;
+    } else {
+        while (pos < src.size() && !isSpace(src[pos]) && src[pos] != ';' && !(inParens && src[pos] == ')') &&
+               !(inList && src[pos] == ',')) {
+            ++pos;
+        }
+        token.type = (pos - start == 1 && src[start] == '?') ? TokenType::Symbol : TokenType::Word;
+    }
+    token.text = src.substr(start, pos - start);
+    return token;
+}
+
+Token Lexer::rawListItem() {
+    skipSpace();
+    Token token;
+    token.pos = pos;
+    size_t start = pos;
+    while (pos < src.size() && src[pos] != ',' && src[pos] != ')') {
+        if (src[pos] == '\'') pos = skipQuoted(src, pos);
+        else ++pos;
+    }
+    size_t end = pos;
+    while (end > start && isSpace(src[end - 1])) --end;
+    token.text = src.substr(start, end - start);
+
+    if (token.text == "?") token.type = TokenType::Symbol;
+    else if (!token.text.empty() && token.text.front() == '\'' && skipQuoted(token.text, 0) == token.text.size())
+        token.type = TokenType::String;
+    else token.type = TokenType::Word;
+    return token;
+}
+
+bool parseSql(const std::string& sql, std::vector<Statement>& statements, std::string& error) {
+    Parser parser(sql);
+    return parser.parseScript(statements, error);
+}
+
+Statement bindParameters(const PrepareStmt& prepared, const std::vector<Literal>& args) {
+    Statement bound = *prepared.body;
+    if (auto* insert = std::get_if<InsertStmt>(&bound.node)) {
+        for (auto& row : insert->rows) {
+            for (auto& value : row) bindLiteral(value, args);
+        }
+    } else if (auto* select = std::get_if<SelectStmt>(&bound.node)) {
+        if (select->where) bindCondition(*select->where, args);
+    } else if (auto* explain = std::get_if<ExplainStmt>(&bound.node)) {
+        if (explain->query.where) bindCondition(*explain->query.where, args);
+    } else if (auto* remove = std::get_if<DeleteStmt>(&bound.node)) {
+        if (remove->where) bindCondition(*remove->where, args);
+    } else if (auto* update = std::get_if<UpdateStmt>(&bound.node)) {
+        for (auto& assignment : update->assignments) bindLiteral(assignment.value, args);
+        if (update->where) bindCondition(*update->where, args);
+    }
+    return bound;
+}
+
+std::string queryText(const SelectStmt& stmt) {
+    std::string text = "SELECT ";
+    if (stmt.columns.empty()) text += "*";
+    for (size_t i = 0; i < stmt.columns.size(); ++i) {
+        if (i > 0) text += ", ";
+        appendColumn(text, stmt.columns[i]);
+    }
+    text += " FROM " + stmt.table;
+    for (const auto& join : stmt.joins) {
+        text += " JOIN " + join.table + " ON ";
+        appendColumn(text, join.left);
+        text += " = ";
+        appendColumn(text, join.right);
+    }
+    if (stmt.where) {
+        text += " WHERE ";
+        appendCondition(text, *stmt.where, false);
+    }
+    for (size_t i = 0; i < stmt.groupBy.size(); ++i) {
+        text += i == 0 ? " GROUP BY " : ", ";
+        appendColumn(text, stmt.groupBy[i]);
+    }
+    for (size_t i = 0; i < stmt.orderBy.size(); ++i) {
+        text += i == 0 ? " ORDER BY " : ", ";
+        appendColumn(text, stmt.orderBy[i].column);
+        if (stmt.orderBy[i].descending) text += " DESC";
+    }
+    if (stmt.limit) text += " LIMIT " + std::to_string(*stmt.limit);
+    return text;
+}
+
+std::vector<std::string> queryTables(const SelectStmt& stmt) {
+    std::vector<std::string> tables{stmt.table};
+    for (const auto& join : stmt.joins) tables.push_back(join.table);
+    return tables;
+}
@@ -0,0 +1,210 @@
+#ifndef SQL_PARSER_H
+#define SQL_PARSER_H
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+//kinds of tokens the lexer produces
+enum class TokenType {
+    Word,   //identifier or keyword: letters, digits and underscores
+    String, //'quoted literal', '' inside stands for one quote
+    Symbol, //( ) , . * ; ? = != < <= > >=
+    Other,  //any other character
+    End
+};
+
+struct Token {
+    TokenType type = TokenType::End;
+    std::string_view text;
+    size_t pos = 0;
+};
+
+//on-demand tokenizer over one command string. besides ordinary tokens it can cut raw
+//values (WHERE constants, VALUES items) whose spelling must be kept as written.
+class Lexer {
+public:
+    explicit Lexer(std::string_view source) : src(source) {}
+
+    Token next();
+    Token peek();
+
+    //constant after a comparison operator: a quoted literal, a ? placeholder, or a run of
+    //characters up to whitespace or ';' (or ')' inside parentheses, or ',' in a list)
+    Token rawValue(bool inParens = false, bool inList = false);
+
+    //item of a parenthesized list, up to the next ',' or ')' outside quotes, trimmed
+    Token rawListItem();
+
+    size_t position() const { return pos; }
+
+private:
+    void skipSpace();
+
+    std::string_view src;
+    size_t pos = 0;
+};
+
+//a constant as written in a command
+struct Literal {
+    std::string raw;  //source text, quotes included
+    std::string text; //value with the surrounding quotes removed
+    int param = -1;   //index of the ? placeholder this stands for, -1 for constants
+};
+
+//column reference, optionally qualified with its table
+struct ColumnRef {
+    std::string table; //lowercase, empty if unqualified
+    std::string column;
+    std::string function; //aggregate over the column in a select list (COUNT, SUM, AVG, MIN, MAX), else
+                          //empty; the column is "*" for COUNT(*)
+};
+
+//WHERE expression. a leaf tests one column: `column op value`, `column IN (values)`,
+//`column BETWEEN values[0] AND values[1]` or `column LIKE value`; the other nodes combine their
+//children. NOT IN, NOT BETWEEN and NOT LIKE are a NOT over the leaf.
+struct Condition {
+    enum class Type { Compare, In, Between, Like, And, Or, Not };
+
+    Type type = Type::Compare;
+    ColumnRef column;                //leaves, lowercase
+    std::string op;                  //Compare
+    Literal value;                   //Compare and LIKE
+    std::vector<Literal> values;     //IN list, BETWEEN bounds
+    std::vector<Condition> children; //two or more for AND and OR, one for NOT
+};
+
+//ORDER BY item
+struct OrderKey {
+    ColumnRef column; //lowercase, may be an aggregate
+    bool descending = false;
+};
+
+struct CreateTableStmt {
+    std::string table;
+    std::vector<std::string> columns;
+};
+
+struct CreateIndexStmt {
+    std::string index;
+    std::string table;
+    std::string column;
+};
+
+struct InsertStmt {
+    std::string table;
+    std::vector<std::vector<Literal>> rows; //one list of values per (...) group
+};
+
+//COPY table FROM 'file' [HEADER]
+struct CopyStmt {
+    std::string table;
+    std::string path;
+    bool header = false; //skip the first line of the file
+};
+
+//JOIN table ON left = right
+struct JoinClause {
+    std::string table;
+    ColumnRef left, right; //lowercase, both qualified
+};
+
+struct SelectStmt {
+    std::vector<ColumnRef> columns; //empty for *, names keep the spelling of the query
+    std::string table;
+    std::vector<JoinClause> joins;  //in FROM order, empty without JOIN
+    std::optional<Condition> where;
+    std::vector<ColumnRef> groupBy; //lowercase
+    std::vector<OrderKey> orderBy;
+    std::optional<std::uint64_t> limit;
+};
+
+//EXPLAIN [ANALYZE] SELECT ...
+struct ExplainStmt {
+    bool analyze = false; //run the query and report what each operator did
+    SelectStmt query;
+};
+
+//CREATE MATERIALIZED VIEW name AS SELECT ...
+struct CreateViewStmt {
+    std::string view;
+    SelectStmt query;
+};
+
+//DELETE FROM table [WHERE ...]
+struct DeleteStmt {
+    std::string table;
+    std::optional<Condition> where;
+};
+
+//column = value in the SET list of an UPDATE
+struct Assignment {
+    std::string column; //lowercase
+    Literal value;
+};
+
+//UPDATE table SET column = value, ... [WHERE ...]
+struct UpdateStmt {
+    std::string table;
+    std::vector<Assignment> assignments;
+    std::optional<Condition> where;
+};
+
+//VACUUM table: rewrite a table without its deleted rows
+struct VacuumStmt {
+    std::string table;
+};
+
+struct DescStmt {
+    std::string table;
+};
+
+//ANALYZE table: collect the statistics the join planner uses
+struct AnalyzeStmt {
+    std::string table;
+};
+
+struct ConvertStmt {
+    std::string table;
+    bool toColumnar = false;
+    bool compressed = false; //TO COLUMNAR COMPRESSED
+};
+
+struct Statement;
+
+struct PrepareStmt {
+    std::string name;
+    std::shared_ptr<const Statement> body;
+    int paramCount = 0;
+};
+
+struct ExecuteStmt {
+    std::string name;
+    std::vector<Literal> args;
+};
+
+struct Statement {
+    std::variant<CreateTableStmt, CreateIndexStmt, InsertStmt, CopyStmt, SelectStmt, ExplainStmt, DescStmt,
+                 ConvertStmt, PrepareStmt, ExecuteStmt, AnalyzeStmt, CreateViewStmt, DeleteStmt, UpdateStmt,
+                 VacuumStmt> node;
+};
+
+//parses one or more ';'-separated commands. statements parsed before an error are kept in
+//`statements`; error is then set to the message for the command that failed.
+bool parseSql(const std::string& sql, std::vector<Statement>& statements, std::string& error);
+
+//copy of a prepared statement with its ? placeholders replaced by args
+Statement bindParameters(const PrepareStmt& prepared, const std::vector<Literal>& args);
+
+//text of a SELECT with keywords in uppercase and single spaces, the same for queries that differ
+//only in spacing and keyword case. it parses back to the same statement
+std::string queryText(const SelectStmt& stmt);
+
+//tables a SELECT reads, the FROM table first
+std::vector<std::string> queryTables(const SelectStmt& stmt);
+
+#endif
@@ -0,0 +1,158 @@
+#include "TableIndex.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::size_t kMaxKeyText = 256; //longer cells are truncated; fetched rows are re-checked
+const char kNumberTag = 0x01;
+const char kTextTag = 0x02;
+
+//same acceptance rules as std::stod, without throwing; NaN counts as non-numeric
+bool parseNumber(const std::string& str, double& out) {
+    char* end = nullptr;
+    errno = 0;
+    out = std::strtod(str.c_str(), &end);
+    if (end == str.c_str() || errno == ERANGE || std::isnan(out)) return false;
+    if (out == 0) out = 0; //fold -0 into +0
+    return true;
+}
+
+void appendBigEndian(std::string& out, std::uint64_t value) {
+    for (int shift = 56; shift >= 0; shift -= 8) out.push_back(static_cast<char>(value >> shift));
+}
+
+std::uint64_t readBigEndian(const std::string& str, std::size_t pos) {
+    std::uint64_t value = 0;
+    for (std::size_t i = 0; i < 8; ++i) value = (value << 8) | static_cast<unsigned char>(str[pos + i]);
+    return value;
+}
+
+//maps a double to an integer with the same ordering
+std::uint64_t orderedBits(double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & (1ULL << 63)) ? ~bits : bits | (1ULL << 63);
+}
+
+double numberFromKey(const std::string& key) {
+    std::uint64_t bits = readBigEndian(key, 1);
+    bits = (bits & (1ULL << 63)) ? bits & ~(1ULL << 63) : ~bits;
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+std::string encodeIndexKey(const std::string& value) {
+    std::string key;
+    double number = 0;
+    if (parseNumber(value, number)) {
+        key.push_back(kNumberTag);
+        appendBigEndian(key, orderedBits(number));
+    } else {
+        key.push_back(kTextTag);
+    }
+
+    //escape zero bytes so the 0x00 0x00 terminator sorts shorter strings first
+    std::size_t len = std::min(value.size(), kMaxKeyText);
+    for (std::size_t i = 0; i < len; ++i) {
+        key.push_back(value[i]);
+        if (value[i] == '\0') key.push_back('\xff');
+    }
+    key.push_back('\0');
+    key.push_back('\0');
+    return key;
+}
+
+std::string indexEntryKey(const std::string& value, std::uint64_t rowOffset) {
+    std::string key = encodeIndexKey(value);
+    appendBigEndian(key, rowOffset);
+    return key;
+}
+
+std::string indexPath(const std::string& tableName, const std::string& indexName) {
+    return "database/" + tableName + "." + indexName + ".bpt";
+}
+
+std::vector<IndexInfo> loadIndexes(const std::string& tableName) {
+    std::vector<IndexInfo> indexes;
+    std::ifstream catalog("database/" + tableName + ".indexes");
+    std::string line;
+    while (std::getline(catalog, line)) {
+        auto comma = line.find(',');
+        if (comma == std::string::npos) continue;
+        indexes.push_back({line.substr(0, comma), line.substr(comma + 1)});
+    }
+    return indexes;
+}
+
+void registerIndex(const std::string& tableName, const IndexInfo& index) {
+    std::ofstream catalog("database/" + tableName + ".indexes", std::ios::app);
+    catalog << index.name << "," << index.column << "\n";
+}
+
+void dropIndexes(const std::string& tableName) {
+    std::error_code ec;
+    for (const auto& index : loadIndexes(tableName)) fs::remove(indexPath(tableName, index.name), ec);
+    fs::remove("database/" + tableName + ".indexes", ec);
+}
+
+std::vector<std::uint64_t> lookupIndex(BPlusTree& tree, const std::string& op, const std::string& value) {
+    std::vector<std::uint64_t> offsets;
+
+    if (op == "=") {
+        std::string prefix = encodeIndexKey(value);
+        for (auto cursor = tree.lowerBound(prefix); cursor.valid(); cursor.next()) {
+            if (cursor.key().compare(0, prefix.size(), prefix) != 0) break;
+            offsets.push_back(cursor.value());
+        }
+    } else {
+        //range comparisons are numeric; a non-numeric constant matches nothing
+        double bound = 0;
+        if (!parseNumber(value, bound)) return offsets;
+
+        bool lower = (op == ">" || op == ">=");
+        std::string start(1, kNumberTag);
+        if (lower) appendBigEndian(start, orderedBits(bound));
+
+        for (auto cursor = tree.lowerBound(start); cursor.valid(); cursor.next()) {
+            const std::string& key = cursor.key();
+            if (key[0] != kNumberTag) break;
+            double number = numberFromKey(key);
+            if (op == ">" && number <= bound) continue;
+            if (op == "<" && number >= bound) break;
+            if (op == "<=" && number > bound) break;
+            offsets.push_back(cursor.value());
+        }
+    }
+
+    std::sort(offsets.begin(), offsets.end());
+    return offsets;
+}
+
+std::vector<std::uint64_t> lookupIndexBetween(BPlusTree& tree, const std::string& low, const std::string& high) {
+    std::vector<std::uint64_t> offsets;
+    double lowBound = 0, highBound = 0;
+    if (!parseNumber(low, lowBound) || !parseNumber(high, highBound) || lowBound > highBound) return offsets;
+
+    std::string start(1, kNumberTag);
+    appendBigEndian(start, orderedBits(lowBound));
+    for (auto cursor = tree.lowerBound(start); cursor.valid(); cursor.next()) {
+        const std::string& key = cursor.key();
+        if (key[0] != kNumberTag || numberFromKey(key) > highBound) break;
+        offsets.push_back(cursor.value());
+    }
+
+    std::sort(offsets.begin(), offsets.end());
+    return offsets;
+}
@@ -0,0 +1,43 @@
+#ifndef TABLE_INDEX_H
+#define TABLE_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BPlusTree.h"
+
+//a secondary index on one column of a table
+struct IndexInfo {
+    std::string name;
+    std::string column; //lowercase column name
+};
+
+//key for a cell whose byte order matches how WHERE compares values: cells that parse as
+//numbers sort by numeric value ahead of all other cells, which sort bytewise
+std::string encodeIndexKey(const std::string& value);
+
+//index entry key: the cell key followed by the row offset, so duplicate values stay unique
+std::string indexEntryKey(const std::string& value, std::uint64_t rowOffset);
+
+//path of the B+tree file that backs an index
+std::string indexPath(const std::string& tableName, const std::string& indexName);
+
+//indexes registered on a table (database/<table>.indexes), empty if there are none
+std::vector<IndexInfo> loadIndexes(const std::string& tableName);
+
+//adds an index to the table's catalog
+void registerIndex(const std::string& tableName, const IndexInfo& index);
+
+//removes every index of a table, used when the table file is recreated
+void dropIndexes(const std::string& tableName);
+
+//byte offsets of the rows whose indexed cell can satisfy `cell op value`, ascending.
+//supports =, <, <=, > and >=; callers still re-check the predicate on each fetched row.
+std::vector<std::uint64_t> lookupIndex(BPlusTree& tree, const std::string& op, const std::string& value);
+
+//byte offsets of the rows whose indexed cell can lie between low and high, both included, ascending.
+//like the ranges of lookupIndex it is numeric: the seek starts at low and stops after high
+std::vector<std::uint64_t> lookupIndexBetween(BPlusTree& tree, const std::string& low, const std::string& high);
+
+#endif
@@ -0,0 +1,163 @@
+#include "TableStats.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+#include "Predicate.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+//guesses for the terms statistics say nothing about
+const double kRangeSelectivity = 1.0 / 3;
+const double kLikeSelectivity = 0.1;
+
+std::string statsPath(const std::string& tableName) {
+    return "database/" + tableName + ".stats";
+}
+
+//fraction of a column's numbers expected in [low, high]
+double rangeFraction(const ColumnStats& column, double low, double high) {
+    if (column.maxNumber <= column.minNumber) return low <= column.minNumber && column.minNumber <= high ? 1 : 0;
+    low = std::max(low, column.minNumber);
+    high = std::min(high, column.maxNumber);
+    if (high < low) return 0;
+    return (high - low) / (column.maxNumber - column.minNumber);
+}
+
+double leafSelectivity(const Condition& leaf, const TableEstimate& table, int column) {
+    double distinct = table.distinct(column);
+    const ColumnStats* stats = column < static_cast<int>(table.stats.columns.size()) ? &table.stats.columns[column] : nullptr;
+    double numeric = stats && table.stats.rows ? static_cast<double>(stats->numbers) / table.stats.rows : 0;
+
+    switch (leaf.type) {
+        case Condition::Type::Compare: {
+            if (leaf.op == "=") return 1 / distinct;
+            if (leaf.op == "!=") return 1 - 1 / distinct;
+            double value;
+            if (!stats || !stats->numbers || !parseLikeStod(leaf.value.text, value)) return kRangeSelectivity;
+            double lowest = -std::numeric_limits<double>::infinity(), highest = std::numeric_limits<double>::infinity();
+            bool below = leaf.op == "<" || leaf.op == "<=";
+            return numeric * rangeFraction(*stats, below ? lowest : value, below ? value : highest);
+        }
+        case Condition::Type::In:
+            return std::min(1.0, leaf.values.size() / distinct);
+        case Condition::Type::Between: {
+            double low, high;
+            if (!stats || !stats->numbers || leaf.values.size() != 2 || !parseLikeStod(leaf.values[0].text, low) ||
+                !parseLikeStod(leaf.values[1].text, high)) {
+                return kRangeSelectivity;
+            }
+            return numeric * rangeFraction(*stats, low, high);
+        }
+        case Condition::Type::Like:
+            return leaf.value.text.find_first_of("%_") == std::string::npos ? 1 / distinct : kLikeSelectivity;
+        default:
+            return 1;
+    }
+}
+
+} // namespace
+
+bool loadStats(const std::string& tableName, TableStats& stats) {
+    std::ifstream file(statsPath(tableName));
+    std::string line;
+    stats = TableStats();
+    try {
+        if (!std::getline(file, line) || line.rfind("rows,", 0) != 0) return false;
+        stats.rows = std::stoull(line.substr(5));
+        if (!std::getline(file, line) || line.rfind("bytes,", 0) != 0) return false;
+        stats.bytes = std::stoull(line.substr(6));
+
+        //one line per column: distinct,empty,numbers,min,max,name
+        while (std::getline(file, line)) {
+            std::vector<std::string> fields;
+            size_t start = 0;
+            for (int i = 0; i < 5; ++i) {
+                size_t comma = line.find(',', start);
+                if (comma == std::string::npos) return false;
+                fields.push_back(line.substr(start, comma - start));
+                start = comma + 1;
+            }
+            ColumnStats column;
+            column.distinct = std::stod(fields[0]);
+            column.empty = std::stoull(fields[1]);
+            column.numbers = std::stoull(fields[2]);
+            column.minNumber = std::stod(fields[3]);
+            column.maxNumber = std::stod(fields[4]);
+            column.name = line.substr(start);
+            stats.columns.push_back(std::move(column));
+        }
+    } catch (const std::exception&) {
+        //a damaged file is as good as none
+        stats = TableStats();
+        return false;
+    }
+    return true;
+}
+
+void saveStats(const std::string& tableName, const TableStats& stats) {
+    std::ofstream file(statsPath(tableName));
+    file << std::setprecision(17);
+    file << "rows," << stats.rows << "\n";
+    file << "bytes," << stats.bytes << "\n";
+    for (const auto& column : stats.columns) {
+        file << column.distinct << "," << column.empty << "," << column.numbers << "," << column.minNumber << ","
+             << column.maxNumber << "," << column.name << "\n";
+    }
+    file.close();
+    fs::permissions(statsPath(tableName),
+                    fs::perms::owner_all | fs::perms::group_all | fs::perms::others_all,
+                    fs::perm_options::replace);
+}
+
+void dropStats(const std::string& tableName) {
+    fs::remove(statsPath(tableName));
+}
+
+double TableEstimate::distinct(int column) const {
+    double count = rows;
+    if (analyzed && column >= 0 && column < static_cast<int>(stats.columns.size())) {
+        count = std::min(count, stats.columns[column].distinct);
+    }
+    return std::max(count, 1.0);
+}
+
+TableEstimate estimateTable(const std::string& tableName, std::uint64_t sizeBytes) {
+    TableEstimate estimate;
+    estimate.analyzed = loadStats(tableName, estimate.stats) && estimate.stats.rows > 0 && estimate.stats.bytes > 0;
+    if (estimate.analyzed) {
+        estimate.rowBytes = static_cast<double>(estimate.stats.bytes) / estimate.stats.rows;
+    }
+    estimate.rows = std::max(1.0, sizeBytes / estimate.rowBytes);
+    return estimate;
+}
+
+double estimateSelectivity(const Condition& where, const TableEstimate& table,
+                           const std::function<int(const ColumnRef&)>& resolve) {
+    if (!table.analyzed) return 1;
+    switch (where.type) {
+        case Condition::Type::And: {
+            double selectivity = 1;
+            for (const auto& child : where.children) selectivity *= estimateSelectivity(child, table, resolve);
+            return selectivity;
+        }
+        case Condition::Type::Or: {
+            double miss = 1;
+            for (const auto& child : where.children) miss *= 1 - estimateSelectivity(child, table, resolve);
+            return 1 - miss;
+        }
+        case Condition::Type::Not:
+            return 1 - estimateSelectivity(where.children[0], table, resolve);
+        default: {
+            //a term on a missing column matches no rows
+            int column = resolve(where.column);
+            if (column < 0) return 0;
+            return std::clamp(leafSelectivity(where, table, column), 0.0, 1.0);
+        }
+    }
+}
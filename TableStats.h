@@ -0,0 +1,58 @@
+#ifndef TABLE_STATS_H
+#define TABLE_STATS_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "SqlParser.h"
+
+//what ANALYZE recorded about one column
+struct ColumnStats {
+    std::string name;
+    double distinct = 0;       //distinct cells, exact up to kExactDistinct and estimated past it
+    std::uint64_t empty = 0;   //empty cells
+    std::uint64_t numbers = 0; //cells that read as numbers
+    double minNumber = 0, maxNumber = 0;
+};
+
+//statistics of a table (database/<table>.stats), collected by ANALYZE for the join planner
+struct TableStats {
+    static constexpr size_t kExactDistinct = 1u << 16; //distinct cells counted exactly per column
+
+    std::uint64_t rows = 0;
+    std::uint64_t bytes = 0; //size of the table file when the rows were counted
+    std::vector<ColumnStats> columns;
+};
+
+//false if the table was never analyzed
+bool loadStats(const std::string& tableName, TableStats& stats);
+
+void saveStats(const std::string& tableName, const TableStats& stats);
+
+void dropStats(const std::string& tableName);
+
+//what the planner expects of a table. an analyzed table has the rows ANALYZE counted, scaled by
+//how much its file grew since; any other table is taken to have rows of kDefaultRowBytes bytes,
+//every column unique, and WHERE terms that keep every row
+struct TableEstimate {
+    static constexpr double kDefaultRowBytes = 64;
+
+    bool analyzed = false;
+    double rows = 0;
+    double rowBytes = kDefaultRowBytes; //average bytes of a row in the table file
+    TableStats stats;
+
+    //distinct cells expected in a column, at least 1
+    double distinct(int column) const;
+};
+
+TableEstimate estimateTable(const std::string& tableName, std::uint64_t sizeBytes);
+
+//fraction of the rows of a table expected to pass where; resolve maps a column reference to its
+//position in the table's rows, or -1
+double estimateSelectivity(const Condition& where, const TableEstimate& table,
+                           const std::function<int(const ColumnRef&)>& resolve);
+
+#endif
@@ -0,0 +1,60 @@
+#include "TableWriter.h"
+
+#include <cerrno>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CsvScanner.h"
+
+TableAppender::~TableAppender() {
+    if (fd >= 0) {
+        flush();
+        ::close(fd);
+    }
+}
+
+bool TableAppender::open(const std::string& path) {
+    fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || ::fstat(fd, &st) != 0) return false;
+    fileSize = st.st_size;
+    buffer.reserve(kBufferSize);
+    return true;
+}
+
+std::uint64_t TableAppender::append(std::string_view row) {
+    if (buffer.size() + row.size() + 1 > kBufferSize) flush();
+    std::uint64_t offset = size();
+    buffer.append(row);
+    buffer.push_back('\n');
+    return offset;
+}
+
+bool TableAppender::flush() {
+    size_t written = 0;
+    while (written < buffer.size() && !failed) {
+        ssize_t n = ::write(fd, buffer.data() + written, buffer.size() - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) failed = true;
+        else written += n;
+    }
+    fileSize += written;
+    buffer.clear();
+    return !failed;
+}
+
+bool TableAppender::commit(bool sync) {
+    if (fd < 0 || !flush()) return false;
+    if (sync && ::fdatasync(fd) != 0) failed = true;
+    return !failed;
+}
+
+size_t countFields(std::string_view row) {
+    thread_local std::vector<std::string_view> fields;
+    size_t count = splitRow(row, fields);
+    bool emptyLast = count > 0 && fields.back().data() + fields.back().size() + 1 == row.data() + row.size();
+    return emptyLast ? count + 1 : count;
+}
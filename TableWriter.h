@@ -0,0 +1,44 @@
+#ifndef TABLE_WRITER_H
+#define TABLE_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+//buffered appender for a text table file. rows collect in a large buffer that goes out in
+//big sequential writes; commit() flushes it and, if asked, makes it durable with one fdatasync.
+class TableAppender {
+public:
+    static constexpr size_t kBufferSize = 8u << 20;
+
+    TableAppender() = default;
+    TableAppender(const TableAppender&) = delete;
+    TableAppender& operator=(const TableAppender&) = delete;
+    ~TableAppender();
+
+    bool open(const std::string& path);
+
+    //queues one row (without its newline), returns the byte offset the row will start at
+    std::uint64_t append(std::string_view row);
+
+    //writes out everything queued so far, false if any write failed
+    bool commit(bool sync);
+
+    //file size including rows still in the buffer
+    std::uint64_t size() const { return fileSize + buffer.size(); }
+
+private:
+    bool flush();
+
+    int fd = -1;
+    std::string buffer;
+    std::uint64_t fileSize = 0;
+    bool failed = false;
+};
+
+//number of values in a row as the table reader splits it, counting an empty last value (a row that
+//ends in a separator), which the reader reads as missing
+size_t countFields(std::string_view row);
+
+#endif
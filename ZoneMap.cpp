@@ -0,0 +1,326 @@
+#include "ZoneMap.h"
+
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <unistd.h>
+
+#include "CsvScanner.h"
+#include "Predicate.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char kMagic[8] = {'I', 'D', 'I', 'M', 'Z', 'O', 'N', '1'};
+
+//file layout: magic, u32 column count, u32 reserved, u64 offset of the first row, u64 block
+//count, u64 size and i64 modification time of the table file, then one fixed-size record per
+//block: u64 offset, u64 bytes, u64 rows, and per column u64 values, u64 empty, u64 numbers,
+//f64 min, f64 max, u8 flags, u8 min length, u8 max length, the min and max text padded to
+//kTextSize bytes, and the sketch registers. the last block is rewritten in place as rows are added.
+const size_t kHeaderSize = sizeof(kMagic) + 4 + 4 + 8 + 8 + 8 + 8;
+const size_t kColumnSize = 5 * 8 + 3 + 2 * ColumnZone::kTextSize + ColumnZone::kSketchRegisters;
+const std::uint8_t kMinCut = 1, kMaxCut = 2;
+
+std::string zonePath(const std::string& tableName) {
+    return "database/" + tableName + ".zones";
+}
+
+template <typename T>
+void put(std::string& out, T value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T get(const char*& p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+}
+
+//a cell as a number the way WHERE reads it (parseLikeStod), with a fast path for the common cells
+bool readNumber(std::string_view cell, double& value) {
+    if (cell.empty()) return false;
+
+    //plain decimals of up to 15 digits: the digits and the power of ten are exact doubles, so one
+    //division rounds the same way strtod does
+    static const double kPowers[] = {1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+    size_t i = cell[0] == '-';
+    std::int64_t digits = 0;
+    int count = 0, fraction = -1;
+    for (; i < cell.size() && count <= 15; ++i) {
+        char c = cell[i];
+        if (c >= '0' && c <= '9') {
+            digits = digits * 10 + (c - '0');
+            ++count;
+            if (fraction >= 0) ++fraction;
+        } else if (c == '.' && fraction < 0) {
+            fraction = 0;
+        } else {
+            break;
+        }
+    }
+    if (i == cell.size() && count > 0 && count <= 15) {
+        value = static_cast<double>(digits) / kPowers[std::max(fraction, 0)];
+        if (cell[0] == '-') value = -value;
+        return true;
+    }
+
+    //whatever else strtod reads starts with a space, a sign, a digit, a point, inf or nan
+    unsigned char first = cell[0];
+    if (!std::isdigit(first) && !std::isspace(first) && !std::strchr("+-.iInN", first)) return false;
+    return parseLikeStod(cell, value);
+}
+
+//64-bit hash of a cell for the sketch (FNV-1a with a final mix for the top bits)
+std::uint64_t hashCell(std::string_view cell) {
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : cell) hash = (hash ^ c) * 0x100000001b3ULL;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    return hash ^ (hash >> 33);
+}
+
+//when the table file was last written, to tell whether a zone map still describes it
+bool tableStamp(const std::string& tableName, std::uint64_t& size, std::int64_t& time) {
+    std::error_code ec;
+    std::string path = "database/" + tableName + ".txt";
+    size = fs::file_size(path, ec);
+    if (ec) return false;
+    time = fs::last_write_time(path, ec).time_since_epoch().count();
+    return !ec;
+}
+
+void encodeBlock(std::string& out, const ZoneBlock& block) {
+    put(out, block.offset);
+    put(out, block.bytes);
+    put(out, block.rows);
+    for (const auto& zone : block.columns) {
+        put(out, zone.values);
+        put(out, zone.empty);
+        put(out, zone.numbers);
+        put(out, zone.minNumber);
+        put(out, zone.maxNumber);
+        put<std::uint8_t>(out, (zone.minCut ? kMinCut : 0) | (zone.maxCut ? kMaxCut : 0));
+        put<std::uint8_t>(out, zone.minText.size());
+        put<std::uint8_t>(out, zone.maxText.size());
+        for (const std::string* text : {&zone.minText, &zone.maxText}) {
+            out += *text;
+            out.append(ColumnZone::kTextSize - text->size(), '\0');
+        }
+        out.append(reinterpret_cast<const char*>(zone.sketch.data()), zone.sketch.size());
+    }
+}
+
+void decodeBlock(const char*& p, size_t columns, ZoneBlock& block) {
+    block.offset = get<std::uint64_t>(p);
+    block.bytes = get<std::uint64_t>(p);
+    block.rows = get<std::uint64_t>(p);
+    block.columns.resize(columns);
+    for (auto& zone : block.columns) {
+        zone.values = get<std::uint64_t>(p);
+        zone.empty = get<std::uint64_t>(p);
+        zone.numbers = get<std::uint64_t>(p);
+        zone.minNumber = get<double>(p);
+        zone.maxNumber = get<double>(p);
+        std::uint8_t flags = get<std::uint8_t>(p);
+        zone.minCut = flags & kMinCut;
+        zone.maxCut = flags & kMaxCut;
+        size_t minLength = std::min<size_t>(get<std::uint8_t>(p), ColumnZone::kTextSize);
+        size_t maxLength = std::min<size_t>(get<std::uint8_t>(p), ColumnZone::kTextSize);
+        zone.minText.assign(p, minLength);
+        p += ColumnZone::kTextSize;
+        zone.maxText.assign(p, maxLength);
+        p += ColumnZone::kTextSize;
+        std::memcpy(zone.sketch.data(), p, zone.sketch.size());
+        p += zone.sketch.size();
+    }
+}
+
+} // namespace
+
+void ColumnZone::add(std::string_view cell) {
+    bool first = values++ == 0;
+    if (cell.empty()) ++empty;
+
+    //minText stays at or below every cell; maxText at or above every cell, or, when cut, at or
+    //above the first kTextSize bytes of every cell
+    std::string_view head = cell.substr(0, kTextSize);
+    if (first || cell < std::string_view(minText)) {
+        minText.assign(head);
+        minCut = head.size() < cell.size();
+    }
+    if (first || (maxCut ? head > std::string_view(maxText) : cell > std::string_view(maxText))) {
+        maxText.assign(head);
+        maxCut = head.size() < cell.size();
+    }
+
+    //NaN passes no comparison, so it is left out of the range
+    double number;
+    if (readNumber(cell, number) && !std::isnan(number)) {
+        if (numbers++ == 0) minNumber = maxNumber = number;
+        minNumber = std::min(minNumber, number);
+        maxNumber = std::max(maxNumber, number);
+    }
+
+    //HyperLogLog: the top bits pick a register, which keeps the longest run of leading zeros seen
+    std::uint64_t hash = hashCell(cell);
+    std::uint64_t rest = hash << 6;
+    std::uint8_t rank = rest == 0 ? 59 : __builtin_clzll(rest) + 1;
+    std::uint8_t& reg = sketch[hash >> 58];
+    reg = std::max(reg, rank);
+}
+
+double ColumnZone::distinct() const {
+    double sum = 0;
+    size_t zeros = 0;
+    for (auto reg : sketch) {
+        sum += std::ldexp(1.0, -reg);
+        zeros += reg == 0;
+    }
+    double m = kSketchRegisters;
+    double estimate = 0.709 * m * m / sum;
+    //small counts are estimated from the registers still empty
+    if (estimate <= 2.5 * m && zeros > 0) estimate = m * std::log(m / zeros);
+    return estimate;
+}
+
+bool ZoneMap::load(const std::string& tableName) {
+    std::ifstream file(zonePath(tableName), std::ios::binary);
+    char header[kHeaderSize];
+    if (!file.read(header, kHeaderSize) || std::memcmp(header, kMagic, sizeof(kMagic)) != 0) return false;
+    const char* p = header + sizeof(kMagic);
+    columnCount = get<std::uint32_t>(p);
+    get<std::uint32_t>(p);
+    dataStart = get<std::uint64_t>(p);
+    std::uint64_t blockCount = get<std::uint64_t>(p);
+    std::uint64_t savedSize = get<std::uint64_t>(p);
+    std::int64_t savedTime = get<std::int64_t>(p);
+
+    std::uint64_t size;
+    std::int64_t time;
+    if (!tableStamp(tableName, size, time) || size != savedSize || time != savedTime) return false;
+
+    size_t recordSize = 24 + columnCount * kColumnSize;
+    std::string records(blockCount * recordSize, '\0');
+    if (!file.read(&records[0], records.size())) return false;
+    blockList.assign(blockCount, ZoneBlock());
+    p = records.data();
+    for (auto& block : blockList) decodeBlock(p, columnCount, block);
+    if (end() != size) return false;
+
+    firstChanged = blockList.empty() ? 0 : blockList.size() - 1;
+    rewrite = false;
+    return true;
+}
+
+void ZoneMap::reset(size_t columns, std::uint64_t start) {
+    columnCount = columns;
+    dataStart = start;
+    blockList.clear();
+    firstChanged = 0;
+    rewrite = true;
+}
+
+bool ZoneMap::build(const std::string& tableName) {
+    std::string path = "database/" + tableName + ".txt";
+    std::error_code ec;
+    std::uint64_t size = fs::file_size(path, ec);
+    CsvReader reader;
+    std::string_view line;
+    if (ec || !reader.open(path) || !reader.nextLine(line)) return false;
+    std::vector<std::string_view> values;
+    splitRow(line, values);
+    std::uint64_t offset = line.size() + 1;
+    reset(values.size(), offset);
+    while (reader.nextLine(line)) {
+        //the last line may have no newline
+        std::uint64_t bytes = std::min<std::uint64_t>(line.size() + 1, size - offset);
+        splitRow(line, values);
+        add(offset, bytes, values);
+        offset += bytes;
+    }
+    return true;
+}
+
+void ZoneMap::add(std::uint64_t offset, std::uint64_t bytes, const std::vector<std::string_view>& values) {
+    if (blockList.empty() || blockList.back().bytes >= kBlockSize) {
+        ZoneBlock block;
+        block.offset = offset;
+        block.columns.resize(columnCount);
+        blockList.push_back(std::move(block));
+    }
+    ZoneBlock& block = blockList.back();
+    block.bytes = offset + bytes - block.offset;
+    ++block.rows;
+    for (size_t col = 0; col < values.size() && col < columnCount; ++col) block.columns[col].add(values[col]);
+}
+
+bool ZoneMap::save(const std::string& tableName) {
+    std::string path = zonePath(tableName);
+    std::fstream file;
+    if (!rewrite) file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+
+    //a new file is written under a name of its own and renamed over the old one, so a scan that
+    //builds the map while a writer saves it cannot leave a mix of the two
+    static std::atomic<std::uint64_t> saves{0};
+    std::string target = path;
+    if (!file.is_open()) {
+        target = path + "." + std::to_string(::getpid()) + "." + std::to_string(++saves) + ".tmp";
+        file.open(target, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+        rewrite = true;
+        firstChanged = 0;
+    }
+
+    //the blocks go first and the header last, so a save cut short leaves a map that does not match
+    //the table file and is rebuilt
+    std::string records;
+    for (size_t i = firstChanged; i < blockList.size(); ++i) encodeBlock(records, blockList[i]);
+    file.seekp(kHeaderSize + firstChanged * (24 + columnCount * kColumnSize));
+    file.write(records.data(), records.size());
+
+    std::uint64_t size;
+    std::int64_t time;
+    std::error_code ec;
+    if (!tableStamp(tableName, size, time)) {
+        if (rewrite) fs::remove(target, ec);
+        return false;
+    }
+    std::string header(kMagic, sizeof(kMagic));
+    put<std::uint32_t>(header, columnCount);
+    put<std::uint32_t>(header, 0);
+    put<std::uint64_t>(header, dataStart);
+    put<std::uint64_t>(header, blockList.size());
+    put<std::uint64_t>(header, size);
+    put<std::int64_t>(header, time);
+    file.seekp(0);
+    file.write(header.data(), header.size());
+    file.close();
+    if (rewrite) {
+        if (file) {
+            fs::permissions(target, fs::perms::owner_all | fs::perms::group_all | fs::perms::others_all,
+                            fs::perm_options::replace, ec);
+            fs::rename(target, path, ec);
+        }
+        if (!file || ec) {
+            fs::remove(target, ec);
+            return false;
+        }
+    }
+    if (!file) return false;
+    firstChanged = blockList.empty() ? 0 : blockList.size() - 1;
+    rewrite = false;
+    return true;
+}
+
+void dropZoneMap(const std::string& tableName) {
+    std::error_code ec;
+    fs::remove(zonePath(tableName), ec);
+}
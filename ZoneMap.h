@@ -0,0 +1,78 @@
+#ifndef ZONE_MAP_H
+#define ZONE_MAP_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//statistics of one column over one block of rows, enough to tell that no cell of the block can
+//pass a comparison without reading it
+struct ColumnZone {
+    static constexpr size_t kTextSize = 24;        //bytes of the smallest and largest cell kept
+    static constexpr size_t kSketchRegisters = 64; //HyperLogLog registers for the distinct estimate
+
+    std::uint64_t values = 0;  //cells present (a short row has none for its missing columns)
+    std::uint64_t empty = 0;   //cells that are empty
+    std::uint64_t numbers = 0; //cells that read as numbers the way WHERE parses them
+    double minNumber = 0, maxNumber = 0;
+    std::string minText, maxText; //bytewise bounds, cut to kTextSize bytes
+    bool minCut = false, maxCut = false; //minText or maxText is only a prefix of the cell
+    std::array<std::uint8_t, kSketchRegisters> sketch{};
+
+    void add(std::string_view cell);
+
+    //estimated number of distinct cells
+    double distinct() const;
+};
+
+//one block of rows: the bytes [offset, offset + bytes) of the table file
+struct ZoneBlock {
+    std::uint64_t offset = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t rows = 0;
+    std::vector<ColumnZone> columns;
+};
+
+//block-level statistics of a text table (database/<table>.zones). the rows of the table file are
+//grouped into blocks of about kBlockSize bytes in file order, and each block keeps a ColumnZone per
+//column. the file records the size and modification time of the table it describes, so a table
+//written by anything that does not keep its zone map up to date is not described by a stale one.
+class ZoneMap {
+public:
+    static constexpr std::uint64_t kBlockSize = 256u << 10;
+
+    //loads the zone map of a table, false if it has none or the table file changed since it was saved
+    bool load(const std::string& tableName);
+
+    //starts an empty map for a table of columns columns whose rows start at dataStart
+    void reset(size_t columns, std::uint64_t dataStart);
+
+    //builds the map from the rows of the table file, false if it cannot be read
+    bool build(const std::string& tableName);
+
+    //adds a row of the table file; rows must be added in file order
+    void add(std::uint64_t offset, std::uint64_t bytes, const std::vector<std::string_view>& values);
+
+    //writes the blocks changed since the map was loaded, then the size and time of the table file
+    bool save(const std::string& tableName);
+
+    const std::vector<ZoneBlock>& blocks() const { return blockList; }
+
+    //end of the last block, the size of the table file the map describes
+    std::uint64_t end() const { return blockList.empty() ? dataStart : blockList.back().offset + blockList.back().bytes; }
+
+private:
+    size_t columnCount = 0;
+    std::uint64_t dataStart = 0;
+    std::vector<ZoneBlock> blockList;
+    size_t firstChanged = 0; //blocks from here on are written by save()
+    bool rewrite = true;     //save() writes a new file
+};
+
+//removes the zone map of a table, used when the table file is recreated or converted
+void dropZoneMap(const std::string& tableName);
+
+#endif
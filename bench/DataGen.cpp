@@ -0,0 +1,174 @@
+#include "DataGen.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* const firstNames[] = {"Layla", "Mike", "Anna", "James", "Lisa", "Omar", "Elena", "Ivan", "Maria", "Peter",
+                                  "Sofia", "Georgi", "Nina", "David", "Yana", "Alex", "Mila", "Victor", "Rosa", "Teo"};
+const char* const lastNames[] = {"Smith", "Lorenzo", "Jones", "Ivanova", "Petrov", "Brown", "Garcia", "Dimitrov",
+                                 "Miller", "Nikolova", "Wilson", "Georgiev", "Moore", "Todorova", "Taylor", "Stoyanov"};
+const char* const departments[] = {"Physics", "Mathematics", "Computer Science", "Chemistry", "Biology",
+                                   "Literature", "History", "Economics", "Psychology", "Arts"};
+const char* const coursePrefixes[] = {"PHYS", "MATH", "CS", "CHEM", "BIO", "LIT", "HIST", "ECON", "PSY", "ART"};
+const char* const topics[] = {"Intro to Programming", "Linear Algebra", "Mechanics", "Organic Chemistry",
+                              "Genetics", "Poetry", "World History", "Microeconomics", "Cognition", "Drawing",
+                              "Data Structures", "Calculus", "Optics", "Ecology", "Statistics", "Databases"};
+const char* const statuses[] = {"enrolled", "enrolled", "enrolled", "enrolled", "enrolled",
+                                "enrolled", "enrolled", "completed", "completed", "dropped"};
+
+template <typename T, size_t N>
+constexpr size_t countOf(T (&)[N]) { return N; }
+
+//keys 1..n drawn from a Zipf-like distribution: key 1 is the hottest, and with skew 0 every key is
+//equally likely. inverts the CDF of the continuous density x^-skew, so a draw costs one pow().
+class KeySampler {
+public:
+    KeySampler(std::uint64_t n, double skew) : n(std::max<std::uint64_t>(n, 1)), skew(skew) {
+        if (skew != 1) span = std::pow(static_cast<double>(this->n) + 1, 1 - skew) - 1;
+    }
+
+    std::uint64_t operator()(std::mt19937_64& rng) const {
+        double u = (rng() >> 11) * 0x1.0p-53;
+        double x = skew == 1 ? std::pow(static_cast<double>(n) + 1, u) : std::pow(span * u + 1, 1 / (1 - skew));
+        return std::clamp<std::uint64_t>(static_cast<std::uint64_t>(x), 1, n);
+    }
+
+private:
+    std::uint64_t n;
+    double skew;
+    double span = 0;
+};
+
+//buffered writer for one generated table
+class TableFile {
+public:
+    explicit TableFile(const std::string& path) : file(std::fopen(path.c_str(), "wb")) { buffer.reserve(kChunk + 4096); }
+    ~TableFile() { close(); }
+
+    bool ok() const { return file != nullptr; }
+
+    void text(const char* value) { buffer.append(value); }
+    void text(const std::string& value) { buffer.append(value); }
+    void number(std::uint64_t value) {
+        char digits[24];
+        buffer.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+    }
+    void comma() { buffer.push_back(','); }
+
+    void endRow() {
+        buffer.push_back('\n');
+        if (buffer.size() >= kChunk) flush();
+    }
+
+    std::uint64_t close() {
+        if (!file) return written;
+        flush();
+        std::fclose(file);
+        file = nullptr;
+        return written;
+    }
+
+private:
+    static constexpr size_t kChunk = 4u << 20;
+
+    void flush() {
+        std::fwrite(buffer.data(), 1, buffer.size(), file);
+        written += buffer.size();
+        buffer.clear();
+    }
+
+    std::FILE* file;
+    std::string buffer;
+    std::uint64_t written = 0;
+};
+
+std::string courseId(std::uint64_t course) {
+    std::uint64_t index = course - 1;
+    return std::string(coursePrefixes[index % countOf(coursePrefixes)]) +
+           std::to_string(101 + index / countOf(coursePrefixes));
+}
+
+} // namespace
+
+std::uint64_t studentRows(const DataSpec& spec) { return std::max<std::uint64_t>(spec.rows / 4, 1); }
+std::uint64_t courseRows(const DataSpec& spec) { return std::max<std::uint64_t>(spec.rows / 1000, 10); }
+std::uint64_t professorRows(const DataSpec& spec) { return std::max<std::uint64_t>(courseRows(spec) / 4, 5); }
+
+bool generateTables(const DataSpec& spec, const std::string& dir, std::vector<GeneratedTable>& tables) {
+    std::error_code ec;
+    fs::create_directories(dir + "/database", ec);
+    tables.clear();
+
+    //each table draws from its own stream, so changing one table's shape leaves the others as they were
+    auto write = [&](const char* name, std::uint64_t rows, std::uint64_t stream, const char* header, auto&& row) {
+        tables.push_back({name, dir + "/database/" + name + ".txt", rows, 0});
+        TableFile file(tables.back().path);
+        if (!file.ok()) return false;
+        std::mt19937_64 rng(spec.seed * 0x9E3779B97F4A7C15ull + stream);
+        file.text(header);
+        for (std::uint64_t i = 1; i <= rows; ++i) {
+            row(file, rng, i);
+            file.endRow();
+        }
+        tables.back().bytes = file.close();
+        return true;
+    };
+
+    std::uint64_t professors = professorRows(spec), courses = courseRows(spec), students = studentRows(spec);
+    KeySampler professorKey(professors, spec.skew), studentKey(students, spec.skew), courseKey(courses, spec.skew);
+    std::vector<std::string> courseIds;
+    for (std::uint64_t course = 1; course <= courses; ++course) courseIds.push_back(courseId(course));
+
+    bool ok = write("professors", professors, 1, "prof_id,fname,lname,department,sex\n",
+                    [&](TableFile& file, std::mt19937_64& rng, std::uint64_t id) {
+        file.number(id), file.comma();
+        file.text(firstNames[rng() % countOf(firstNames)]), file.comma();
+        file.text(lastNames[rng() % countOf(lastNames)]), file.comma();
+        file.text(departments[rng() % countOf(departments)]), file.comma();
+        file.text(rng() % 2 ? "M" : "F");
+    });
+    ok = ok && write("courses", courses, 2, "course_id,title,prof_id\n",
+                     [&](TableFile& file, std::mt19937_64& rng, std::uint64_t course) {
+        file.text(courseIds[course - 1]), file.comma();
+        file.text(topics[rng() % countOf(topics)]), file.comma();
+        file.number(professorKey(rng));
+    });
+    ok = ok && write("students", students, 3, "student_id,fname,lname,prof_id,sex\n",
+                     [&](TableFile& file, std::mt19937_64& rng, std::uint64_t id) {
+        file.number(id), file.comma();
+        file.text(firstNames[rng() % countOf(firstNames)]), file.comma();
+        file.text(lastNames[rng() % countOf(lastNames)]), file.comma();
+        file.number(professorKey(rng)), file.comma();
+        file.text(rng() % 2 ? "M" : "F");
+    });
+    //grades are uniform over 0..99, so "grade < n" selects n percent of the enrollments
+    ok = ok && write("enrollments", spec.rows, 4, "student_id,major_id,course_id,grade,status\n",
+                     [&](TableFile& file, std::mt19937_64& rng, std::uint64_t) {
+        file.number(studentKey(rng)), file.comma();
+        file.number(101 + rng() % 10), file.comma();
+        file.text(courseIds[courseKey(rng) - 1]), file.comma();
+        file.number(rng() % 100), file.comma();
+        file.text(statuses[rng() % countOf(statuses)]);
+    });
+    return ok;
+}
+
+bool parseCount(const std::string& text, std::uint64_t& count) {
+    const char* end = text.data() + text.size();
+    auto parsed = std::from_chars(text.data(), end, count);
+    if (parsed.ec != std::errc() || parsed.ptr == text.data()) return false;
+    std::string suffix(parsed.ptr, end);
+    if (suffix == "K" || suffix == "k") count *= 1000;
+    else if (suffix == "M" || suffix == "m") count *= 1000000;
+    else if (suffix == "G" || suffix == "g") count *= 1000000000;
+    else if (!suffix.empty()) return false;
+    return true;
+}
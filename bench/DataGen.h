@@ -0,0 +1,35 @@
+#ifndef BENCH_DATAGEN_H
+#define BENCH_DATAGEN_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//shape of a generated data set. every table is derived from the number of enrollment rows,
+//so the same options always produce byte-identical files.
+struct DataSpec {
+    std::uint64_t rows = 100000; //enrollment rows; the other tables scale with it
+    double skew = 0;             //Zipf exponent of the foreign keys, 0 for uniform (1 is a typical hot set)
+    std::uint64_t seed = 42;
+};
+
+struct GeneratedTable {
+    std::string name;
+    std::string path;
+    std::uint64_t rows = 0;
+    std::uint64_t bytes = 0; //file size, header included
+};
+
+//row counts of each table for a spec, without writing anything
+std::uint64_t studentRows(const DataSpec& spec);
+std::uint64_t courseRows(const DataSpec& spec);
+std::uint64_t professorRows(const DataSpec& spec);
+
+//writes professors, courses, students and enrollments to dir/database/<table>.txt, with the
+//columns of the sample tables of the same name. returns false if a file cannot be written.
+bool generateTables(const DataSpec& spec, const std::string& dir, std::vector<GeneratedTable>& tables);
+
+//parses a row count such as 5000, 10K or 100M
+bool parseCount(const std::string& text, std::uint64_t& count);
+
+#endif
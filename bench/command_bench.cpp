@@ -0,0 +1,366 @@
+//end-to-end latency, throughput and peak memory of each command path, measured by running the engine
+//binary on generated tables (see datagen.cpp) and reading its output through a pipe.
+//build: g++ -std=c++17 -O2 -o command_bench bench/command_bench.cpp bench/DataGen.cpp
+//usage: ./command_bench [--engine=./sql_database] [--dir=bench_data] [--rows=N] [--skew=S] [--seed=N] [--reuse]
+//                       [--runs=N] [--warmup=N] [--only=NAME] [--format=json|csv]
+//                       [--baseline=FILE] [--threshold=PCT] [-- engine options]
+//       prints one record per benchmark. with --baseline (the JSON output of an earlier run), a comparison
+//       goes to stderr and the exit status is 1 if a median got slower by more than PCT percent (default 10)
+//       or a query's output changed.
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "DataGen.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Scenario {
+    std::string name;
+    std::string sql;
+    std::uint64_t rows = 0;  //rows the command reads or writes, for rows/s
+    std::uint64_t bytes = 0; //bytes of table data it reads or writes, for bytes/s
+    std::string setup;       //untimed command run before every timed one
+};
+
+struct RunResult {
+    bool ok = false;
+    double seconds = 0;
+    double cpuSeconds = 0;
+    long peakRssKb = 0;
+    std::uint64_t outRows = 0;
+    std::uint64_t outHash = 0;
+};
+
+struct Options {
+    std::string engine = "./sql_database";
+    std::string dir = "bench_data";
+    DataSpec spec;
+    bool reuse = false;
+    int runs = 5;
+    int warmup = 1;
+    std::string only;
+    bool csv = false;
+    std::string baseline;
+    double threshold = 10;
+    std::vector<std::string> engineOptions;
+};
+
+//runs one command in a child process with the data directory as its working directory
+RunResult runCommand(const Options& options, const std::string& sql) {
+    RunResult result;
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) return result;
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(pipeFds[1], STDOUT_FILENO);
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+        if (chdir(options.dir.c_str()) != 0) _exit(127);
+        std::vector<char*> args;
+        args.push_back(const_cast<char*>(options.engine.c_str()));
+        for (const auto& option : options.engineOptions) args.push_back(const_cast<char*>(option.c_str()));
+        args.push_back(const_cast<char*>(sql.c_str()));
+        args.push_back(nullptr);
+        execv(options.engine.c_str(), args.data());
+        _exit(127);
+    }
+    close(pipeFds[1]);
+    if (pid < 0) {
+        close(pipeFds[0]);
+        return result;
+    }
+
+    //the output is counted and hashed (FNV-1a) so a run against a baseline also checks the result
+    std::vector<char> buffer(1u << 16);
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    ssize_t count;
+    while ((count = read(pipeFds[0], buffer.data(), buffer.size())) > 0) {
+        for (ssize_t i = 0; i < count; ++i) {
+            hash = (hash ^ static_cast<unsigned char>(buffer[i])) * 0x100000001b3ull;
+            result.outRows += buffer[i] == '\n';
+        }
+    }
+    close(pipeFds[0]);
+
+    int status = 0;
+    struct rusage usage {};
+    wait4(pid, &status, 0, &usage);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    result.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    result.seconds = elapsed.count();
+    result.cpuSeconds = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+                        (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    result.peakRssKb = usage.ru_maxrss;
+    result.outHash = hash;
+    return result;
+}
+
+//nearest-rank percentile of sorted samples
+double percentile(const std::vector<double>& sorted, double p) {
+    size_t rank = static_cast<size_t>(std::ceil(p / 100 * sorted.size()));
+    return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+std::vector<Scenario> scenarios(const std::vector<GeneratedTable>& tables) {
+    std::map<std::string, GeneratedTable> byName;
+    for (const auto& table : tables) byName[table.name] = table;
+    const GeneratedTable& enrollments = byName["enrollments"];
+    const GeneratedTable& students = byName["students"];
+    const GeneratedTable& courses = byName["courses"];
+    std::uint64_t rows = enrollments.rows, bytes = enrollments.bytes;
+
+    std::string create = "CREATE TABLE bench_load (student_id, major_id, course_id, grade, status)";
+    std::string insert = "INSERT INTO bench_load VALUES ";
+    std::uint64_t insertRows = std::min<std::uint64_t>(rows, 1000), insertBytes = 0;
+    for (std::uint64_t i = 1; i <= insertRows; ++i) {
+        std::string row = std::to_string(i) + ", " + std::to_string(101 + i % 10) + ", CS" +
+                          std::to_string(101 + i % 50) + ", " + std::to_string(i % 100) + ", enrolled";
+        insert += (i > 1 ? ", (" : "(") + row + ")";
+        insertBytes += row.size() - 3; //stored without the spaces, plus a newline
+    }
+
+    std::string join = "SELECT enrollments.grade, students.lname FROM enrollments JOIN students "
+                       "ON enrollments.student_id = students.student_id";
+    std::string smallJoin = "SELECT courses.title, enrollments.grade FROM courses JOIN enrollments "
+                            "ON courses.course_id = enrollments.course_id";
+    return {
+        {"create", create, 0, 0, ""},
+        {"insert", insert, insertRows, insertBytes, create},
+        {"copy", "COPY bench_load FROM 'database/enrollments.txt' HEADER", rows, bytes, create},
+        {"scan_full", "SELECT * FROM enrollments", rows, bytes, ""},
+        {"filter_1pct", "SELECT * FROM enrollments WHERE grade < 1", rows, bytes, ""},
+        {"filter_10pct", "SELECT * FROM enrollments WHERE grade < 10", rows, bytes, ""},
+        {"filter_50pct", "SELECT * FROM enrollments WHERE grade < 50", rows, bytes, ""},
+        {"filter_hot_key", "SELECT * FROM enrollments WHERE student_id = 1", rows, bytes, ""},
+        {"projection", "SELECT student_id, grade FROM enrollments", rows, bytes, ""},
+        {"desc", "DESC enrollments", 0, 0, ""},
+        {"join", join, rows + students.rows, bytes + students.bytes, ""},
+        {"join_small_build", smallJoin, rows + courses.rows, bytes + courses.bytes, ""},
+        {"group_by", "SELECT course_id, COUNT(*), AVG(grade) FROM enrollments GROUP BY course_id", rows, bytes, ""},
+        {"order_by_limit", "SELECT * FROM enrollments ORDER BY grade DESC LIMIT 10", rows, bytes, ""},
+        {"order_by", "SELECT student_id, grade FROM enrollments ORDER BY grade", rows, bytes, ""},
+    };
+}
+
+std::string hex(std::uint64_t value) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+    return text;
+}
+
+//value of "field" in one line of JSON output, as text
+std::string jsonField(const std::string& line, const std::string& field) {
+    std::string marker = "\"" + field + "\":";
+    size_t pos = line.find(marker);
+    if (pos == std::string::npos) return "";
+    pos += marker.size();
+    if (line[pos] == '"') {
+        size_t end = line.find('"', pos + 1);
+        return line.substr(pos + 1, end - pos - 1);
+    }
+    size_t end = line.find_first_of(",}", pos);
+    return line.substr(pos, end - pos);
+}
+
+struct Record {
+    std::string name;
+    std::uint64_t scale = 0;
+    double p50 = 0;
+    std::string outHash;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    int i = 1;
+    for (; i < argc; ++i) {
+        std::string option = argv[i];
+        auto value = [&](const char* prefix) {
+            return option.rfind(prefix, 0) == 0 ? option.substr(std::char_traits<char>::length(prefix)) : "";
+        };
+        try {
+            if (option == "--") {
+                ++i;
+                break;
+            } else if (option.rfind("--engine=", 0) == 0) options.engine = value("--engine=");
+            else if (option.rfind("--dir=", 0) == 0) options.dir = value("--dir=");
+            else if (option.rfind("--rows=", 0) == 0) {
+                if (!parseCount(value("--rows="), options.spec.rows) || options.spec.rows == 0) return false;
+            } else if (option.rfind("--skew=", 0) == 0) options.spec.skew = std::stod(value("--skew="));
+            else if (option.rfind("--seed=", 0) == 0) {
+                if (!parseCount(value("--seed="), options.spec.seed)) return false;
+            } else if (option == "--reuse") options.reuse = true;
+            else if (option.rfind("--runs=", 0) == 0) options.runs = std::stoi(value("--runs="));
+            else if (option.rfind("--warmup=", 0) == 0) options.warmup = std::stoi(value("--warmup="));
+            else if (option.rfind("--only=", 0) == 0) options.only = value("--only=");
+            else if (option == "--format=csv") options.csv = true;
+            else if (option == "--format=json") options.csv = false;
+            else if (option.rfind("--baseline=", 0) == 0) options.baseline = value("--baseline=");
+            else if (option.rfind("--threshold=", 0) == 0) options.threshold = std::stod(value("--threshold="));
+            else return false;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    for (; i < argc; ++i) options.engineOptions.push_back(argv[i]);
+    return options.runs > 0 && options.warmup >= 0 && options.spec.skew >= 0;
+}
+
+//prints the comparison with a baseline to stderr; false if anything regressed
+bool compareBaseline(const Options& options, const std::vector<Record>& records) {
+    std::ifstream in(options.baseline);
+    if (!in) {
+        std::cerr << "Error: Unable to read baseline " << options.baseline << "\n";
+        return false;
+    }
+    std::map<std::string, Record> baseline;
+    std::string line;
+    while (std::getline(in, line)) {
+        Record record;
+        record.name = jsonField(line, "bench");
+        if (record.name.empty()) continue;
+        try {
+            record.scale = std::stoull(jsonField(line, "scale"));
+            record.p50 = std::stod(jsonField(line, "p50_ms"));
+        } catch (const std::exception&) {
+            continue;
+        }
+        record.outHash = jsonField(line, "out_hash");
+        baseline[record.name] = record;
+    }
+
+    bool ok = true;
+    std::fprintf(stderr, "%-18s %12s %12s %9s\n", "bench", "base p50 ms", "p50 ms", "change");
+    for (const auto& record : records) {
+        auto it = baseline.find(record.name);
+        if (it == baseline.end()) continue;
+        const Record& base = it->second;
+        double change = base.p50 > 0 ? (record.p50 - base.p50) / base.p50 * 100 : 0;
+        std::string note;
+        if (change > options.threshold) note = "  REGRESSION";
+        //outputs are only comparable between runs over the same tables
+        if (base.scale == record.scale && base.outHash != record.outHash) note += "  OUTPUT CHANGED";
+        ok = ok && note.empty();
+        std::fprintf(stderr, "%-18s %12.3f %12.3f %+8.1f%%%s\n", record.name.c_str(), base.p50, record.p50, change,
+                     note.c_str());
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " [--engine=PATH] [--dir=PATH] [--rows=N] [--skew=S] [--seed=N] [--reuse]"
+                  << " [--runs=N] [--warmup=N] [--only=NAME] [--format=json|csv] [--baseline=FILE] [--threshold=PCT]"
+                  << " [-- engine options]\n";
+        return 1;
+    }
+    options.engine = fs::absolute(options.engine).string();
+    if (access(options.engine.c_str(), X_OK) != 0) {
+        std::cerr << "Error: Engine binary " << options.engine << " not found. Build it or pass --engine=PATH.\n";
+        return 1;
+    }
+
+    std::vector<GeneratedTable> tables;
+    bool generate = !options.reuse || !fs::exists(options.dir + "/database/enrollments.txt");
+    if (generate) {
+        std::cerr << "generating " << options.spec.rows << " enrollments in " << options.dir << "/database\n";
+        if (!generateTables(options.spec, options.dir, tables)) {
+            std::cerr << "Error: Unable to write " << tables.back().path << "\n";
+            return 1;
+        }
+    } else {
+        //tables from an earlier run: sizes from the files, row counts from the spec that wrote them
+        std::vector<std::pair<std::string, std::uint64_t>> shapes = {{"professors", professorRows(options.spec)},
+                                                                     {"courses", courseRows(options.spec)},
+                                                                     {"students", studentRows(options.spec)},
+                                                                     {"enrollments", options.spec.rows}};
+        for (const auto& [name, rows] : shapes) {
+            std::string path = options.dir + "/database/" + name + ".txt";
+            std::error_code ec;
+            tables.push_back({name, path, rows, static_cast<std::uint64_t>(fs::file_size(path, ec))});
+        }
+    }
+
+    if (options.csv) {
+        std::cout << "bench,scale,skew,runs,rows,bytes,p50_ms,p99_ms,mean_ms,min_ms,rows_per_s,bytes_per_s,"
+                     "peak_rss_kb,cpu_ms,out_rows,out_hash\n";
+    }
+    std::vector<Record> records;
+    bool failed = false;
+    for (const auto& scenario : scenarios(tables)) {
+        if (!options.only.empty() && scenario.name.find(options.only) == std::string::npos) continue;
+
+        std::vector<double> latencies;
+        double cpu = 0;
+        long peakRss = 0;
+        RunResult last;
+        for (int run = 0; run < options.warmup + options.runs; ++run) {
+            if (!scenario.setup.empty()) runCommand(options, scenario.setup);
+            last = runCommand(options, scenario.sql);
+            if (!last.ok) break;
+            if (run < options.warmup) continue;
+            latencies.push_back(last.seconds * 1000);
+            cpu += last.cpuSeconds * 1000;
+            peakRss = std::max(peakRss, last.peakRssKb);
+        }
+        if (!last.ok) {
+            std::cerr << "Error: " << scenario.name << " failed: " << scenario.sql.substr(0, 200) << "\n";
+            failed = true;
+            continue;
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        double p50 = percentile(latencies, 50), p99 = percentile(latencies, 99);
+        double mean = 0;
+        for (double latency : latencies) mean += latency;
+        mean /= latencies.size();
+        double rowsPerSecond = scenario.rows / (p50 / 1000), bytesPerSecond = scenario.bytes / (p50 / 1000);
+        records.push_back({scenario.name, options.spec.rows, p50, hex(last.outHash)});
+
+        std::ostringstream line;
+        line.setf(std::ios::fixed);
+        line.precision(3);
+        if (options.csv) {
+            line << scenario.name << "," << options.spec.rows << "," << options.spec.skew << "," << latencies.size()
+                 << "," << scenario.rows << "," << scenario.bytes << "," << p50 << "," << p99 << "," << mean << ","
+                 << latencies.front() << "," << std::llround(rowsPerSecond) << "," << std::llround(bytesPerSecond)
+                 << "," << peakRss << "," << cpu / latencies.size() << "," << last.outRows << ","
+                 << hex(last.outHash);
+        } else {
+            line << "{\"bench\":\"" << scenario.name << "\",\"scale\":" << options.spec.rows
+                 << ",\"skew\":" << options.spec.skew << ",\"runs\":" << latencies.size()
+                 << ",\"rows\":" << scenario.rows << ",\"bytes\":" << scenario.bytes << ",\"p50_ms\":" << p50
+                 << ",\"p99_ms\":" << p99 << ",\"mean_ms\":" << mean << ",\"min_ms\":" << latencies.front()
+                 << ",\"rows_per_s\":" << std::llround(rowsPerSecond)
+                 << ",\"bytes_per_s\":" << std::llround(bytesPerSecond) << ",\"peak_rss_kb\":" << peakRss
+                 << ",\"cpu_ms\":" << cpu / latencies.size() << ",\"out_rows\":" << last.outRows
+                 << ",\"out_hash\":\"" << hex(last.outHash) << "\"}";
+        }
+        std::cout << line.str() << std::endl;
+    }
+
+    std::error_code ec;
+    fs::remove(options.dir + "/database/bench_load.txt", ec);
+
+    if (!options.baseline.empty() && !compareBaseline(options, records)) failed = true;
+    return failed ? 1 : 0;
+}
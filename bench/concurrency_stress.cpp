@@ -0,0 +1,297 @@
+//stress test of concurrent engine processes sharing one database directory: writer processes append
+//batches of numbered rows to one table with INSERT and COPY while reader processes scan it, look rows
+//up through its index and count it. every output is checked against what committed batches allow:
+//whole rows only, every batch either complete or absent, each writer's batches a prefix of the ones
+//it wrote, and row counts that never go down. at the end the table, and a materialized view over it
+//that every write refreshes, must hold every row exactly once.
+//build: g++ -std=c++17 -O2 -o concurrency_stress bench/concurrency_stress.cpp
+//usage: ./concurrency_stress [--engine=./sql_database] [--dir=stress_data] [--writers=N] [--readers=N]
+//                            [--batches=N] [--rows=N] [--reads=N] [-- engine options]
+//       prints one summary line; the exit status is 1 if any check failed.
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Options {
+    std::string engine = "./sql_database";
+    std::string dir = "stress_data";
+    int writers = 4;
+    int readers = 4;
+    int batches = 40; //per writer
+    int rows = 200;   //per batch
+    int reads = 60;   //per reader
+    std::vector<std::string> engineOptions;
+};
+
+//runs one command in a child process with the data directory as its working directory, false if it
+//could not be run or exited with an error
+bool runEngine(const Options& options, const std::string& sql, std::string& output) {
+    output.clear();
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) return false;
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(pipeFds[1], STDOUT_FILENO);
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+        if (chdir(options.dir.c_str()) != 0) _exit(127);
+        std::vector<char*> args;
+        args.push_back(const_cast<char*>(options.engine.c_str()));
+        for (const auto& option : options.engineOptions) args.push_back(const_cast<char*>(option.c_str()));
+        args.push_back(const_cast<char*>(sql.c_str()));
+        args.push_back(nullptr);
+        execv(options.engine.c_str(), args.data());
+        _exit(127);
+    }
+    close(pipeFds[1]);
+    if (pid < 0) {
+        close(pipeFds[0]);
+        return false;
+    }
+    char buffer[1 << 16];
+    ssize_t count;
+    while ((count = read(pipeFds[0], buffer, sizeof(buffer))) > 0) output.append(buffer, count);
+    close(pipeFds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+//payload of a row, its length varying so rows straddle block and buffer boundaries differently
+std::string payload(int writer, int batch, int seq) {
+    return "p" + std::string((writer * 7 + batch * 3 + seq) % 61, static_cast<char>('a' + writer % 26));
+}
+
+std::string rowText(int writer, int batch, int seq) {
+    return std::to_string(writer) + "," + std::to_string(batch) + "," + std::to_string(seq) + "," +
+           payload(writer, batch, seq);
+}
+
+//checks the rows of one result: prints what is wrong and returns false. rows counts the rows seen
+bool checkRows(const Options& options, const std::string& output, int onlyWriter, const std::string& context,
+               std::uint64_t& rows) {
+    std::map<std::pair<int, int>, int> batchRows;
+    size_t pos = output.find('\n');
+    if (pos == std::string::npos || output.compare(0, pos, "writer,batch,seq,payload") != 0) {
+        std::cerr << context << ": bad header: " << output.substr(0, 80) << "\n";
+        return false;
+    }
+    rows = 0;
+    for (++pos; pos < output.size();) {
+        size_t end = output.find('\n', pos);
+        if (end == std::string::npos) end = output.size();
+        std::string line = output.substr(pos, end - pos);
+        pos = end + 1;
+
+        int writer, batch, seq, used = 0;
+        if (std::sscanf(line.c_str(), "%d,%d,%d,%n", &writer, &batch, &seq, &used) != 3 || writer < 0 ||
+            writer >= options.writers || batch < 0 || batch >= options.batches || seq < 0 || seq >= options.rows ||
+            line.substr(used) != payload(writer, batch, seq) || (onlyWriter >= 0 && writer != onlyWriter)) {
+            std::cerr << context << ": torn or foreign row '" << line << "'\n";
+            return false;
+        }
+        ++batchRows[{writer, batch}];
+        ++rows;
+    }
+
+    //each batch is all there or not at all, and a writer's batches are the first ones it wrote
+    std::map<int, int> lastBatch;
+    for (const auto& [key, count] : batchRows) {
+        if (count != options.rows) {
+            std::cerr << context << ": batch " << key.second << " of writer " << key.first << " has " << count
+                      << " of " << options.rows << " rows\n";
+            return false;
+        }
+        int expected = lastBatch.count(key.first) ? lastBatch[key.first] + 1 : 0;
+        if (key.second != expected) {
+            std::cerr << context << ": writer " << key.first << " has batch " << key.second << " without batch "
+                      << expected << "\n";
+            return false;
+        }
+        lastBatch[key.first] = key.second;
+    }
+    return true;
+}
+
+int runWriter(const Options& options, int writer) {
+    std::string csv = fs::absolute(options.dir + "/writer" + std::to_string(writer) + ".csv").string();
+    std::string output;
+    for (int batch = 0; batch < options.batches; ++batch) {
+        std::string sql;
+        if (batch % 2 == 0) {
+            sql = "INSERT INTO stress VALUES ";
+            for (int seq = 0; seq < options.rows; ++seq) {
+                sql += (seq > 0 ? ", (" : "(") + rowText(writer, batch, seq) + ")";
+            }
+        } else {
+            std::ofstream file(csv, std::ios::trunc);
+            for (int seq = 0; seq < options.rows; ++seq) file << rowText(writer, batch, seq) << "\n";
+            file.close();
+            sql = "COPY stress FROM '" + csv + "'";
+        }
+        if (!runEngine(options, sql, output) || output.find("successfully") == std::string::npos) {
+            std::cerr << "writer " << writer << ", batch " << batch << ": " << output;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int runReader(const Options& options, int reader) {
+    std::uint64_t lastRows = 0, lastCount = 0;
+    std::string output;
+    for (int i = 0; i < options.reads; ++i) {
+        std::string context = "reader " + std::to_string(reader) + ", read " + std::to_string(i);
+        std::uint64_t rows;
+        switch (i % 3) {
+            case 0:
+                //a scan may only grow from one snapshot to the next
+                if (!runEngine(options, "SELECT * FROM stress", output) || !checkRows(options, output, -1, context, rows)) {
+                    return 1;
+                }
+                if (rows < lastRows) {
+                    std::cerr << context << ": " << rows << " rows after " << lastRows << "\n";
+                    return 1;
+                }
+                lastRows = rows;
+                break;
+            case 1: {
+                int writer = (reader + i) % options.writers;
+                std::string sql = "SELECT * FROM stress WHERE writer = " + std::to_string(writer);
+                if (!runEngine(options, sql, output) || !checkRows(options, output, writer, context, rows)) return 1;
+                break;
+            }
+            default: {
+                std::uint64_t count = 0;
+                if (!runEngine(options, "SELECT COUNT(*) FROM stress", output) ||
+                    std::sscanf(output.c_str(), "COUNT(*)\n%llu", reinterpret_cast<unsigned long long*>(&count)) != 1 ||
+                    count % options.rows != 0 || count < lastCount) {
+                    std::cerr << context << ": bad count after " << lastCount << ": " << output;
+                    return 1;
+                }
+                lastCount = count;
+            }
+        }
+    }
+    return 0;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    int i = 1;
+    for (; i < argc; ++i) {
+        std::string option = argv[i];
+        auto value = [&](const char* prefix) {
+            return option.rfind(prefix, 0) == 0 ? option.substr(std::char_traits<char>::length(prefix)) : "";
+        };
+        try {
+            if (option == "--") {
+                ++i;
+                break;
+            } else if (!value("--engine=").empty()) {
+                options.engine = value("--engine=");
+            } else if (!value("--dir=").empty()) {
+                options.dir = value("--dir=");
+            } else if (!value("--writers=").empty()) {
+                options.writers = std::stoi(value("--writers="));
+            } else if (!value("--readers=").empty()) {
+                options.readers = std::stoi(value("--readers="));
+            } else if (!value("--batches=").empty()) {
+                options.batches = std::stoi(value("--batches="));
+            } else if (!value("--rows=").empty()) {
+                options.rows = std::stoi(value("--rows="));
+            } else if (!value("--reads=").empty()) {
+                options.reads = std::stoi(value("--reads="));
+            } else {
+                return false;
+            }
+        } catch (...) {
+            return false;
+        }
+    }
+    for (; i < argc; ++i) options.engineOptions.push_back(argv[i]);
+    return options.writers > 0 && options.readers >= 0 && options.batches > 0 && options.rows > 0 &&
+           options.reads >= 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " [--engine=PATH] [--dir=PATH] [--writers=N] [--readers=N]"
+                  << " [--batches=N] [--rows=N] [--reads=N] [-- engine options]\n";
+        return 1;
+    }
+    options.engine = fs::absolute(options.engine).string();
+    if (access(options.engine.c_str(), X_OK) != 0) {
+        std::cerr << "Error: Engine binary " << options.engine << " not found. Build it or pass --engine=PATH.\n";
+        return 1;
+    }
+
+    //a fresh table with an index and a view, so writers also keep the index, zone map and view in step
+    fs::remove_all(options.dir);
+    fs::create_directories(options.dir);
+    std::string output;
+    if (!runEngine(options, "CREATE TABLE stress (writer INT, batch INT, seq INT, payload)", output) ||
+        !runEngine(options, "CREATE INDEX stress_writer ON stress(writer)", output) ||
+        !runEngine(options, "CREATE MATERIALIZED VIEW stress_view AS SELECT * FROM stress", output)) {
+        std::cerr << "Error: Could not create the table: " << output;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<pid_t> children;
+    for (int w = 0; w < options.writers; ++w) {
+        pid_t pid = fork();
+        if (pid == 0) _exit(runWriter(options, w));
+        children.push_back(pid);
+    }
+    for (int r = 0; r < options.readers; ++r) {
+        pid_t pid = fork();
+        if (pid == 0) _exit(runReader(options, r));
+        children.push_back(pid);
+    }
+    int failures = 0;
+    for (pid_t pid : children) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) ++failures;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    //every row of every batch exactly once, through a scan, through the index and in the view
+    std::uint64_t rows = 0, viewRows = 0;
+    std::uint64_t expected = static_cast<std::uint64_t>(options.writers) * options.batches * options.rows;
+    bool complete = runEngine(options, "SELECT * FROM stress", output) &&
+                    checkRows(options, output, -1, "final scan", rows) && rows == expected;
+    for (int w = 0; complete && w < options.writers; ++w) {
+        std::uint64_t writerRows = 0;
+        complete = runEngine(options, "SELECT * FROM stress WHERE writer = " + std::to_string(w), output) &&
+                   checkRows(options, output, w, "final lookup", writerRows) &&
+                   writerRows == static_cast<std::uint64_t>(options.batches) * options.rows;
+    }
+    if (!complete) std::cerr << "final table has " << rows << " of " << expected << " rows or lost rows of a writer\n";
+    bool viewComplete = runEngine(options, "SELECT * FROM stress_view", output) &&
+                        checkRows(options, output, -1, "final view", viewRows) && viewRows == expected;
+    if (!viewComplete) std::cerr << "final view has " << viewRows << " of " << expected << " rows\n";
+    complete = complete && viewComplete;
+
+    std::printf("writers %d, readers %d, %d batches of %d rows each: %llu rows in %.2f s, %d failed processes, %s\n",
+                options.writers, options.readers, options.batches, options.rows,
+                static_cast<unsigned long long>(rows), elapsed.count(), failures,
+                failures == 0 && complete ? "consistent" : "INCONSISTENT");
+    return failures == 0 && complete ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+//scan throughput of the block reader and row splitter against getline plus the old tokenize().
+//build: g++ -std=c++17 -O2 -o csv_bench bench/csv_bench.cpp CsvScanner.cpp
+//usage: ./csv_bench [table.txt]   (without a file, a 200 MB sample table is generated)
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../CsvScanner.h"
+
+namespace {
+
+//the splitter the engine used before, kept here as the baseline
+std::vector<std::string> tokenize(const std::string& str, char delimiter) {
+    std::vector<std::string> tokens;
+    std::stringstream ss(str);
+    std::string token;
+    while (std::getline(ss, token, delimiter)) {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+void writeSample(const std::string& path, size_t bytes) {
+    std::ofstream outFile(path);
+    std::mt19937 rng(42);
+    outFile << "id,name,city,age,grade,notes\n";
+    size_t written = 0;
+    for (size_t id = 0; written < bytes; ++id) {
+        std::string row = std::to_string(id) + ",'student " + std::to_string(rng() % 100000) + "'," +
+                          (rng() % 4 == 0 ? "'Veliko Tarnovo, BG'" : "Sofia") + "," + std::to_string(18 + rng() % 40) +
+                          "," + std::to_string(rng() % 600 / 100.0) + ",enrolled in the autumn term\n";
+        outFile << row;
+        written += row.size();
+    }
+}
+
+template <typename F>
+void report(const char* name, size_t bytes, F&& scan) {
+    auto start = std::chrono::steady_clock::now();
+    size_t fields = scan();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << bytes / elapsed.count() / 1e9 << " GB/s (" << fields << " values)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "csv_bench_sample.txt";
+    if (argc <= 1) writeSample(path, 200u << 20);
+
+    std::ifstream probe(path, std::ios::binary | std::ios::ate);
+    size_t bytes = probe.tellg();
+    std::cout << "scanning " << bytes / 1e6 << " MB, best level: " << scanLevelName(scanLevel()) << "\n";
+
+    report("getline + tokenize", bytes, [&] {
+        std::ifstream inFile(path);
+        std::string line;
+        size_t fields = 0;
+        while (std::getline(inFile, line)) fields += tokenize(line, ',').size();
+        return fields;
+    });
+
+    ScanLevel best = scanLevel();
+    for (ScanLevel level : {ScanLevel::Scalar, ScanLevel::SSE2, ScanLevel::AVX2}) {
+        if (!setScanLevel(level)) continue;
+        std::string name = std::string("CsvReader + splitRow (") + scanLevelName(level) + ")";
+        report(name.c_str(), bytes, [&] {
+            CsvReader reader;
+            reader.open(path);
+            std::string_view line;
+            std::vector<std::string_view> values;
+            size_t fields = 0;
+            while (reader.nextLine(line)) fields += splitRow(line, values);
+            return fields;
+        });
+    }
+    setScanLevel(best);
+
+    if (argc <= 1) std::remove(path.c_str());
+    return 0;
+}
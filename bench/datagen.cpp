@@ -0,0 +1,44 @@
+//writes deterministic professors, courses, students and enrollments tables for the benchmarks.
+//build: g++ -std=c++17 -O2 -o datagen bench/datagen.cpp bench/DataGen.cpp
+//usage: ./datagen [--rows=N] [--skew=S] [--seed=N] [--dir=PATH]
+//       --rows is the number of enrollments (1K to 100M; K, M and G suffixes); there are a quarter as many
+//       students, one course per 1000 enrollments and one professor per 4 courses. --skew is the Zipf
+//       exponent of the foreign keys (0 is uniform). tables go to PATH/database, PATH defaulting to "."
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DataGen.h"
+
+int main(int argc, char* argv[]) {
+    DataSpec spec;
+    std::string dir = ".";
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        bool ok = true;
+        try {
+            if (option.rfind("--rows=", 0) == 0) ok = parseCount(option.substr(7), spec.rows) && spec.rows > 0;
+            else if (option.rfind("--skew=", 0) == 0) spec.skew = std::stod(option.substr(7));
+            else if (option.rfind("--seed=", 0) == 0) ok = parseCount(option.substr(7), spec.seed);
+            else if (option.rfind("--dir=", 0) == 0) dir = option.substr(6);
+            else ok = false;
+        } catch (const std::exception&) {
+            ok = false;
+        }
+        if (!ok || spec.skew < 0) {
+            std::cerr << "Usage: " << argv[0] << " [--rows=N] [--skew=S] [--seed=N] [--dir=PATH]\n";
+            return 1;
+        }
+    }
+
+    std::vector<GeneratedTable> tables;
+    if (!generateTables(spec, dir, tables)) {
+        std::cerr << "Error: Unable to write " << tables.back().path << "\n";
+        return 1;
+    }
+    for (const auto& table : tables) {
+        std::cout << "{\"table\":\"" << table.name << "\",\"path\":\"" << table.path << "\",\"rows\":" << table.rows
+                  << ",\"bytes\":" << table.bytes << "}\n";
+    }
+    return 0;
+}
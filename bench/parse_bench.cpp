@@ -0,0 +1,107 @@
+//parse throughput of the hand-written parser against the regex matching it replaced.
+//build: g++ -std=c++17 -O2 -o parse_bench bench/parse_bench.cpp SqlParser.cpp
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "../SqlParser.h"
+
+namespace {
+
+const std::vector<std::string> commands = {
+    "CREATE TABLE students (id, name, age, major)",
+    "INSERT INTO students VALUES (42, 'Ada Lovelace', 36, 'Math')",
+    "SELECT * FROM students",
+    "SELECT name, age FROM students WHERE age >= 21",
+    "SELECT students.name, majors.title FROM students JOIN majors ON students.major = majors.id WHERE majors.id = 3",
+    "DESC students",
+};
+
+const char* createPattern = "CREATE\\s+TABLE\\s+(\\w+)\\s*\\(\\s*(.+?)\\s*\\)";
+const char* insertPattern = "INSERT\\s+INTO\\s+(\\w+)\\s+VALUES\\s*\\(\\s*(.+?)\\s*\\)";
+const char* wherePattern = R"(SELECT\s+(.+?)\s+FROM\s+(\w+)\s+WHERE\s+(\w+)\s*(=|!=|>=|<=|<|>)\s*'?(.*?)'?(?:\s|$))";
+const char* selectPattern = "SELECT\\s+(.+?)\\s+FROM\\s+(\\w+)";
+const char* joinPattern =
+    R"(SELECT\s+(.+?)\s+FROM\s+(\w+)\s+JOIN\s+(\w+)\s+ON\s+(\w+)\.(\w+)\s*=\s*(\w+)\.(\w+)(?:\s+WHERE\s+(\w+)\.(\w+)\s*(=|!=|<=|>=|<|>)\s*'?(.*?)'?)?\s*$)";
+const char* descPattern = R"(DESC\s+(\w+))";
+
+std::string toLower(std::string str) {
+    for (auto& c : str) c = std::tolower(static_cast<unsigned char>(c));
+    return str;
+}
+
+//the pattern the old executeSqlCommand routed a command to
+const char* patternFor(const std::string& lowerCmd) {
+    if (lowerCmd.find("create table") == 0) return createPattern;
+    if (lowerCmd.find("insert into") == 0) return insertPattern;
+    if (lowerCmd.find("desc") == 0) return descPattern;
+    if (lowerCmd.find("join") != std::string::npos) return joinPattern;
+    if (lowerCmd.find("where") != std::string::npos) return wherePattern;
+    return selectPattern;
+}
+
+//routes and matches a command the way the regex parser did; `cached` reuses compiled patterns
+size_t regexParse(const std::string& sql, bool cached) {
+    static std::vector<std::pair<const char*, std::regex>> compiled;
+    std::string lowerCmd = toLower(sql);
+    const char* pattern = patternFor(lowerCmd);
+    std::smatch match;
+    if (!cached) {
+        std::regex re(pattern, std::regex::icase);
+        std::regex_search(sql, match, re);
+        return match.size();
+    }
+    for (auto& entry : compiled) {
+        if (entry.first == pattern) {
+            std::regex_search(sql, match, entry.second);
+            return match.size();
+        }
+    }
+    compiled.emplace_back(pattern, std::regex(pattern, std::regex::icase));
+    std::regex_search(sql, match, compiled.back().second);
+    return match.size();
+}
+
+size_t astParse(const std::string& sql) {
+    std::vector<Statement> statements;
+    std::string error;
+    parseSql(sql, statements, error);
+    return statements.size();
+}
+
+template <typename F>
+void report(const char* name, size_t iterations, F&& parseOne) {
+    static volatile size_t sink = 0; //keeps the results observable to the optimizer
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        for (const auto& sql : commands) sink = sink + parseOne(sql);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double perCommand = elapsed.count() * 1e9 / (iterations * commands.size());
+    std::cout << name << ": " << perCommand << " ns/command, " << static_cast<size_t>(1e9 / perCommand)
+              << " commands/s\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t iterations = argc > 1 ? std::stoul(argv[1]) : 20000;
+
+    report("regex, compiled per call", iterations / 10, [](const std::string& sql) { return regexParse(sql, false); });
+    report("regex, compiled once    ", iterations, [](const std::string& sql) { return regexParse(sql, true); });
+    report("recursive descent       ", iterations, astParse);
+
+    //EXECUTE of a prepared statement only binds its parameters
+    std::vector<Statement> prepared;
+    std::string error;
+    parseSql("PREPARE q AS SELECT name, age FROM students WHERE age >= ?", prepared, error);
+    const auto& prepare = std::get<PrepareStmt>(prepared.front().node);
+    std::vector<Literal> args = {{"21", "21", -1}};
+    report("bind prepared statement ", iterations, [&](const std::string&) {
+        return std::get<SelectStmt>(bindParameters(prepare, args).node).columns.size();
+    });
+    return 0;
+}
@@ -0,0 +1,242 @@
+//checks that a query prints the same rows whichever way the engine runs it: each check runs the engine
+//binary on generated tables (see datagen.cpp) under two settings, or before and after a change that
+//must not alter the result, and compares the outputs byte for byte, row order included.
+//build: g++ -std=c++17 -O2 -o query_checks bench/query_checks.cpp bench/DataGen.cpp
+//usage: ./query_checks [--engine=./sql_database] [--dir=check_data] [--rows=N] [--only=NAME]
+//       prints one line per check; the exit status is 1 if any check failed.
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DataGen.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Options {
+    std::string engine = "./sql_database";
+    std::string dir = "check_data";
+    DataSpec spec;
+    std::string only;
+};
+
+//runs one command in a child process with the data directory as its working directory, false if it
+//could not be run or exited with an error
+bool runEngine(const Options& options, const std::vector<std::string>& engineOptions, const std::string& sql,
+               std::string& output) {
+    output.clear();
+    int pipeFds[2];
+    if (pipe(pipeFds) != 0) return false;
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(pipeFds[1], STDOUT_FILENO);
+        close(pipeFds[0]);
+        close(pipeFds[1]);
+        if (chdir(options.dir.c_str()) != 0) _exit(127);
+        std::vector<char*> args;
+        args.push_back(const_cast<char*>(options.engine.c_str()));
+        for (const auto& option : engineOptions) args.push_back(const_cast<char*>(option.c_str()));
+        args.push_back(const_cast<char*>(sql.c_str()));
+        args.push_back(nullptr);
+        execv(options.engine.c_str(), args.data());
+        _exit(127);
+    }
+    close(pipeFds[1]);
+    if (pid < 0) {
+        close(pipeFds[0]);
+        return false;
+    }
+    char buffer[1 << 16];
+    ssize_t count;
+    while ((count = read(pipeFds[0], buffer, sizeof(buffer))) > 0) output.append(buffer, count);
+    close(pipeFds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+std::size_t countLines(const std::string& text) {
+    std::size_t lines = 0;
+    for (char c : text) lines += c == '\n';
+    return lines;
+}
+
+//temp files a query left behind in the database directory
+std::size_t leftoverFiles(const Options& options) {
+    std::size_t files = 0;
+    for (const auto& entry : fs::directory_iterator(options.dir + "/database")) {
+        if (entry.path().filename().string().rfind(".", 0) == 0) ++files;
+    }
+    return files;
+}
+
+//a three-table join under a join memory far below its intermediate rows must spill them and still
+//print the rows of the unbudgeted run, in the same order
+bool checkJoinBudget(const Options& options, std::string& detail) {
+    const std::string sql = "SELECT * FROM enrollments JOIN students ON enrollments.student_id = students.student_id "
+                            "JOIN courses ON enrollments.course_id = courses.course_id";
+    const std::vector<std::string> budget{"--join-memory=64K"};
+    std::string expected, actual, plan;
+    if (!runEngine(options, {}, sql, expected) || !runEngine(options, budget, sql, actual) ||
+        !runEngine(options, budget, "EXPLAIN ANALYZE " + sql, plan)) {
+        detail = "engine failed: " + expected.substr(0, 200) + actual.substr(0, 200);
+        return false;
+    }
+    if (countLines(expected) != options.spec.rows + 1) {
+        detail = "unbudgeted join printed " + std::to_string(countLines(expected)) + " lines";
+        return false;
+    }
+    if (actual != expected) {
+        detail = "budgeted join printed " + std::to_string(countLines(actual)) + " lines that differ";
+        return false;
+    }
+    if (plan.find("joined rows spilled") == std::string::npos) {
+        detail = "joined rows were not spilled";
+        return false;
+    }
+    if (std::size_t files = leftoverFiles(options)) {
+        detail = std::to_string(files) + " temp files left behind";
+        return false;
+    }
+    detail = std::to_string(options.spec.rows) + " rows, same order";
+    return true;
+}
+
+//a range query on a table that has no zone map, as generated tables have none, must build one and
+//skip blocks with it from then on, printing the same rows as before
+bool checkZoneMaps(const Options& options, std::string& detail) {
+    const std::string sql = "SELECT * FROM students WHERE student_id < 100";
+    std::string zones = options.dir + "/database/students.zones";
+    if (fs::exists(zones)) {
+        detail = "generated table already has a zone map";
+        return false;
+    }
+    std::string first, plan, again;
+    if (!runEngine(options, {}, sql, first)) {
+        detail = "engine failed: " + first.substr(0, 200);
+        return false;
+    }
+    if (!fs::exists(zones)) {
+        detail = "the scan saved no zone map";
+        return false;
+    }
+    if (!runEngine(options, {}, "EXPLAIN ANALYZE " + sql, plan) || !runEngine(options, {}, sql, again)) {
+        detail = "engine failed: " + plan.substr(0, 200);
+        return false;
+    }
+    unsigned long long skipped = 0, blocks = 0;
+    std::size_t pos = plan.find("zone maps skip ");
+    if (pos == std::string::npos ||
+        std::sscanf(plan.c_str() + pos, "zone maps skip %llu of %llu blocks", &skipped, &blocks) != 2 || skipped == 0) {
+        detail = "no blocks skipped: " + plan.substr(0, 200);
+        return false;
+    }
+    if (countLines(first) != 100 || again != first) {
+        detail = "printed " + std::to_string(countLines(first)) + " lines, then " + std::to_string(countLines(again));
+        return false;
+    }
+    detail = "skips " + std::to_string(skipped) + " of " + std::to_string(blocks) + " blocks";
+    return true;
+}
+
+//BETWEEN on an indexed column must seek the index and print the rows of the equivalent pair of
+//range terms, in the same order
+bool checkIndexBetween(const Options& options, std::string& detail) {
+    const std::string between = "SELECT * FROM enrollments WHERE grade BETWEEN 10 AND 12";
+    const std::string terms = "SELECT * FROM enrollments WHERE grade >= 10 AND grade <= 12";
+    std::string created, expected, actual, plan, reversed;
+    if (!runEngine(options, {}, "CREATE INDEX e_grade ON enrollments(grade)", created) ||
+        !runEngine(options, {}, terms, expected) || !runEngine(options, {}, between, actual) ||
+        !runEngine(options, {}, "EXPLAIN " + between, plan) ||
+        !runEngine(options, {}, "SELECT * FROM enrollments WHERE grade BETWEEN 12 AND 10", reversed)) {
+        detail = "engine failed: " + created.substr(0, 200);
+        return false;
+    }
+    if (plan.find("Index Scan on enrollments using e_grade") == std::string::npos) {
+        detail = "BETWEEN did not use the index: " + plan.substr(0, 200);
+        return false;
+    }
+    if (countLines(expected) < 2 || actual != expected) {
+        detail = "BETWEEN printed " + std::to_string(countLines(actual)) + " lines, the range terms " +
+                 std::to_string(countLines(expected));
+        return false;
+    }
+    if (countLines(reversed) != 1) {
+        detail = "reversed bounds printed " + std::to_string(countLines(reversed)) + " lines";
+        return false;
+    }
+    detail = std::to_string(countLines(actual) - 1) + " rows through the index, same order";
+    return true;
+}
+
+struct Check {
+    std::string name;
+    std::function<bool(const Options&, std::string&)> run;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string option = argv[i];
+        auto value = [&](const char* prefix) {
+            return option.rfind(prefix, 0) == 0 ? option.substr(std::char_traits<char>::length(prefix)) : "";
+        };
+        if (!value("--engine=").empty()) {
+            options.engine = value("--engine=");
+        } else if (!value("--dir=").empty()) {
+            options.dir = value("--dir=");
+        } else if (!value("--rows=").empty()) {
+            if (!parseCount(value("--rows="), options.spec.rows)) return false;
+        } else if (!value("--only=").empty()) {
+            options.only = value("--only=");
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    options.spec.rows = 50000;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " [--engine=PATH] [--dir=PATH] [--rows=N] [--only=NAME]\n";
+        return 1;
+    }
+    options.engine = fs::absolute(options.engine).string();
+    if (access(options.engine.c_str(), X_OK) != 0) {
+        std::cerr << "Error: Engine binary " << options.engine << " not found. Build it or pass --engine=PATH.\n";
+        return 1;
+    }
+
+    const std::vector<Check> checks{
+        {"join_budget", checkJoinBudget},
+        {"zone_maps", checkZoneMaps},
+        {"index_between", checkIndexBetween},
+    };
+    int failures = 0;
+    for (const auto& check : checks) {
+        if (!options.only.empty() && check.name != options.only) continue;
+        //every check starts from freshly generated tables, so one check's files cannot affect another
+        std::vector<GeneratedTable> tables;
+        fs::remove_all(options.dir);
+        if (!generateTables(options.spec, options.dir, tables)) {
+            std::cerr << "Error: Could not write the tables to " << options.dir << ".\n";
+            return 1;
+        }
+        std::string detail;
+        bool passed = check.run(options, detail);
+        if (!passed) ++failures;
+        std::printf("%-16s %s  %s\n", check.name.c_str(), passed ? "ok  " : "FAIL", detail.c_str());
+    }
+    fs::remove_all(options.dir);
+    return failures == 0 ? 0 : 1;
+}